@@ -0,0 +1,334 @@
+/**
+ * @file DriveGateway.c
+ * @brief 드라이브 연결을 혼자 가지고 여러 프로그램의 요청을 Unix domain socket으로 받아 대신 보내는 daemon
+ * @details 사용법: DriveGateway (-i ip [-i ip ...] | -d /dev/ttyUSB0 [-n 축 수] [-B baud]) [-u socket 경로] [-w worker 수] [-s 통계 주기(초)]
+ * -i를 여러 번 주면 차례로 보드 ID 0, 1, 2...로 연결하고, -d는 Slave ID 0 ~ n-1로 연결한다.
+ * 클라이언트는 FAS_ConnectGateway(경로, 보드 ID)로 붙으며 그 뒤로는 FAS_Transact 등을 그대로 쓴다.
+ * 드라이브 I/O는 FAS_Shard worker가 하고, main 스레드는 클라이언트 socket과 완료 pipe만 poll 한다.
+ * 읽기 요청(축 상태, 엔코더, 알람 등)은 같은 보드, 같은 frame type, 같은 data의 요청이 이미 처리 중이면
+ * 드라이브로 다시 보내지 않고 그 응답을 같이 받는다. (응답은 각 클라이언트의 sync 번호로 바꿔서 보냄)
+ * 그 밖의 요청은 받은 순서대로 하나씩 보낸다. 응답이 없으면 클라이언트에도 보내지 않으므로 클라이언트가 timeout으로 처리한다.
+ * 빌드: gcc -O2 -pthread -o DriveGateway DriveGateway.c FAS_Shard.c FAS_Library.c FAS_Trace.c FAS_Ethernet.c FAS_Uring.c FAS_Serial.c FAS_Gateway.c
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "FAS_Shard.h"
+
+#define GATEWAY_MAX_CLIENTS 32
+#define GATEWAY_MAX_PENDING 256 //드라이브로 보냈거나 보낼 요청 수
+#define GATEWAY_MAX_WAITERS 32  //요청 하나의 응답을 같이 받는 클라이언트 요청 수
+
+ /**@brief 응답을 기다리는 클라이언트 요청 하나*/
+typedef struct
+{
+    int client;
+    unsigned generation; //그 사이에 클라이언트가 끊기고 칸이 재사용되었는지 확인용
+    BYTE sync;
+} WAITER;
+
+typedef struct
+{
+    bool in_use;
+    bool coalesce;
+    FAS_REQUEST request;
+    BYTE data[BUFFER_SIZE];
+    BYTE reply[BUFFER_SIZE];
+    WAITER waiters[GATEWAY_MAX_WAITERS];
+    int waiter_count;
+} PENDING;
+
+typedef struct
+{
+    int fd;              //-1이면 빈 칸
+    unsigned generation;
+} CLIENT;
+
+static PENDING pending[GATEWAY_MAX_PENDING];
+static CLIENT clients[GATEWAY_MAX_CLIENTS];
+static int done_pipe[2]; //worker -> main, 끝난 PENDING 포인터
+static volatile sig_atomic_t stop;
+static uint64_t stat_requests, stat_wire, stat_coalesced, stat_dropped, stat_timeouts;
+
+static void on_signal(int sig) {
+    stop = 1;
+}
+
+ /**@brief worker 스레드에서 부름, 끝난 요청을 main 스레드로 넘김 (포인터 크기 쓰기는 pipe에서 나뉘지 않음)*/
+static void on_request_done(FAS_REQUEST *request, void *user) {
+    PENDING *p = user;
+    if (write(done_pipe[1], &p, sizeof(p)) != sizeof(p)) {
+        perror("gateway done pipe failed");
+    }
+}
+
+static PENDING *find_pending(int iBdID, BYTE frame_type, const BYTE *data, int data_size) {
+    for (int i = 0; i < GATEWAY_MAX_PENDING; i++) {
+        PENDING *p = &pending[i];
+        if (p->in_use && p->coalesce && p->waiter_count < GATEWAY_MAX_WAITERS && p->request.iBdID == iBdID
+            && p->request.frame_type == frame_type && p->request.data_size == data_size && memcmp(p->data, data, data_size) == 0) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+static PENDING *alloc_pending(void) {
+    for (int i = 0; i < GATEWAY_MAX_PENDING; i++) {
+        if (!pending[i].in_use) {
+            pending[i].in_use = true;
+            pending[i].waiter_count = 0;
+            return &pending[i];
+        }
+    }
+    return NULL;
+}
+
+ /**@brief 클라이언트 메시지 [보드 ID][AA][길이][sync][00][frame type][data...] 하나를 처리*/
+static void handle_message(int client, const BYTE *message, int size) {
+    stat_requests++;
+    if (size < 6 || message[1] != 0xAA || message[2] + 3 != size) {
+        stat_dropped++;
+        return;
+    }
+    int iBdID = message[0];
+    BYTE sync = message[3], frame_type = message[5];
+    const BYTE *data = &message[6];
+    int data_size = size - 6;
+    WAITER waiter = { client, clients[client].generation, sync };
+
+    if (FAS_ShardWorkerOf(iBdID) < 0) {
+        stat_dropped++;
+        return;
+    }
+    bool coalesce = FAS_IsReadRequest(frame_type);
+    if (coalesce) {
+        PENDING *p = find_pending(iBdID, frame_type, data, data_size);
+        if (p != NULL) {
+            p->waiters[p->waiter_count++] = waiter;
+            stat_coalesced++;
+            return;
+        }
+    }
+    PENDING *p = alloc_pending();
+    if (p == NULL) {
+        stat_dropped++;
+        return;
+    }
+    p->coalesce = coalesce;
+    memcpy(p->data, data, data_size);
+    p->request = (FAS_REQUEST){ .iBdID = iBdID, .frame_type = frame_type, .data = p->data, .data_size = data_size,
+                                .reply = p->reply, .reply_size = sizeof(p->reply) };
+    p->waiters[p->waiter_count++] = waiter;
+    if (!FAS_ShardSubmit(&p->request, on_request_done, p)) {
+        p->in_use = false;
+        stat_dropped++;
+        return;
+    }
+    stat_wire++;
+}
+
+ /**@brief 끝난 요청의 응답을 기다리던 클라이언트마다 sync 번호를 바꿔 보냄*/
+static void fan_out(PENDING *p) {
+    BYTE message[1 + BUFFER_SIZE];
+
+    if (p->request.reply_bytes <= 0) {
+        stat_timeouts++;
+    }
+    else {
+        message[0] = (BYTE)p->request.iBdID;
+        memcpy(&message[1], p->reply, p->request.reply_bytes);
+        for (int i = 0; i < p->waiter_count; i++) {
+            const WAITER *w = &p->waiters[i];
+            CLIENT *c = &clients[w->client];
+            if (c->fd < 0 || c->generation != w->generation) {
+                continue;
+            }
+            message[3] = w->sync;
+            if (send(c->fd, message, p->request.reply_bytes + 1, MSG_NOSIGNAL | MSG_DONTWAIT) < 0 && errno != EAGAIN) {
+                perror("gateway reply failed");
+            }
+        }
+    }
+    p->in_use = false;
+}
+
+static int open_listener(const char *path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("Socket creation failed");
+        return -1;
+    }
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, GATEWAY_MAX_CLIENTS) < 0) {
+        perror("gateway bind failed");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void accept_client(int listener) {
+    int fd = accept4(listener, NULL, NULL, SOCK_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    for (int i = 0; i < GATEWAY_MAX_CLIENTS; i++) {
+        if (clients[i].fd < 0) {
+            clients[i].fd = fd;
+            return;
+        }
+    }
+    fprintf(stderr, "too many clients (max %d)\n", GATEWAY_MAX_CLIENTS);
+    close(fd);
+}
+
+static void print_stats(void) {
+    int connected = 0;
+    for (int i = 0; i < GATEWAY_MAX_CLIENTS; i++) {
+        connected += clients[i].fd >= 0;
+    }
+    printf("clients %d, requests %llu, sent to drives %llu, coalesced %llu (%.1f%%), no reply %llu, dropped %llu\n", connected,
+           (unsigned long long)stat_requests, (unsigned long long)stat_wire, (unsigned long long)stat_coalesced,
+           stat_requests > 0 ? 100.0 * stat_coalesced / stat_requests : 0, (unsigned long long)stat_timeouts,
+           (unsigned long long)stat_dropped);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    const char *ips[FAS_MAX_BOARD];
+    int ip_count = 0;
+    const char *device = NULL, *path = FAS_GATEWAY_PATH;
+    int slaves = 1, baud = 115200, workers = 0;
+    double stats_s = 0;
+
+    while ((opt = getopt(argc, argv, "i:d:n:B:u:w:s:")) != -1) {
+        switch (opt)
+        {
+            case 'i':
+                if (ip_count < FAS_MAX_BOARD) {
+                    ips[ip_count++] = optarg;
+                }
+                break;
+            case 'd': device = optarg; break;
+            case 'n': slaves = atoi(optarg); break;
+            case 'B': baud = atoi(optarg); break;
+            case 'u': path = optarg; break;
+            case 'w': workers = atoi(optarg); break;
+            case 's': stats_s = atof(optarg); break;
+            default: break;
+        }
+    }
+    if (ip_count == 0 && device == NULL) {
+        fprintf(stderr, "usage: %s (-i ip [-i ip ...] | -d device [-n slaves] [-B baud]) [-u socket] [-w workers] [-s stats_s]\n", argv[0]);
+        return 2;
+    }
+
+    int boards = device != NULL ? slaves : ip_count;
+    for (int i = 0; i < boards; i++) {
+        unsigned sb[4];
+        bool connected = false;
+        if (device != NULL) {
+            connected = FAS_ConnectSerial(device, baud, i);
+        }
+        else if (sscanf(ips[i], "%u.%u.%u.%u", &sb[0], &sb[1], &sb[2], &sb[3]) == 4) {
+            connected = FAS_Connect(sb[0], sb[1], sb[2], sb[3], i);
+        }
+        if (!connected) {
+            fprintf(stderr, "board %d: connect failed\n", i);
+            return 2;
+        }
+    }
+    if (pipe2(done_pipe, O_CLOEXEC) < 0) {
+        perror("pipe failed");
+        return 2;
+    }
+    int listener = open_listener(path);
+    if (listener < 0 || !FAS_ShardStart(workers, true)) {
+        return 2;
+    }
+    for (int i = 0; i < GATEWAY_MAX_CLIENTS; i++) {
+        clients[i].fd = -1;
+    }
+    struct sigaction sa = { .sa_handler = on_signal };
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    printf("%s: %d board(s)\n", path, boards);
+    fflush(stdout);
+
+    struct pollfd pfds[2 + GATEWAY_MAX_CLIENTS];
+    int64_t next_stats = FAS_NowUs() + (int64_t)(stats_s * 1e6);
+    while (!stop) {
+        int count = 0;
+        pfds[count++] = (struct pollfd){ .fd = done_pipe[0], .events = POLLIN };
+        pfds[count++] = (struct pollfd){ .fd = listener, .events = POLLIN };
+        for (int i = 0; i < GATEWAY_MAX_CLIENTS; i++) {
+            pfds[count++] = (struct pollfd){ .fd = clients[i].fd, .events = POLLIN }; //fd가 -1이면 poll이 무시함
+        }
+        int timeout_ms = -1;
+        if (stats_s > 0) {
+            int64_t left = next_stats - FAS_NowUs();
+            timeout_ms = left > 0 ? (int)(left / 1000) + 1 : 0;
+        }
+        if (poll(pfds, count, timeout_ms) < 0) {
+            if (errno != EINTR) {
+                perror("poll failed");
+            }
+            continue;
+        }
+        if (pfds[0].revents & POLLIN) {
+            PENDING *done[64];
+            ssize_t n = read(done_pipe[0], done, sizeof(done));
+            for (ssize_t i = 0; i < n / (ssize_t)sizeof(done[0]); i++) {
+                fan_out(done[i]);
+            }
+        }
+        if (pfds[1].revents & POLLIN) {
+            accept_client(listener);
+        }
+        for (int i = 0; i < GATEWAY_MAX_CLIENTS; i++) {
+            if (!(pfds[2 + i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            BYTE message[1 + BUFFER_SIZE];
+            ssize_t n = recv(clients[i].fd, message, sizeof(message), MSG_DONTWAIT);
+            if (n > 0) {
+                handle_message(i, message, (int)n);
+            }
+            else if (n == 0 || errno != EAGAIN) {
+                close(clients[i].fd);
+                clients[i].fd = -1;
+                clients[i].generation++;
+            }
+        }
+        if (stats_s > 0 && FAS_NowUs() >= next_stats) {
+            print_stats();
+            next_stats += (int64_t)(stats_s * 1e6);
+        }
+    }
+
+    FAS_ShardStop();
+    print_stats();
+    close(listener);
+    unlink(path);
+    for (int i = 0; i < boards; i++) {
+        FAS_Close(i);
+    }
+    return 0;
+}
@@ -0,0 +1,303 @@
+/**
+ * @file DriveSim.c
+ * @brief 실제 드라이브 없이 클라이언트를 시험하기 위한 Ezi-SERVO II 대역(stand-in) 프로그램
+ * @details -s N : pty를 하나 열고 Slave ID 0 ~ N-1인 Plus-R 드라이브 N대처럼 응답한다.
+ * 출력되는 /dev/pts/X 경로를 FAS_ConnectSerial(또는 ProtocolTest의 RS485 연결)에 넣으면 된다.
+ * -u : 127.0.0.1의 UDP PORT(3001)에서 Plus-E 드라이브 한 대처럼 응답한다. FAS_Connect(127, 0, 0, 1, ...)로 연결.
+ * -a 127.0.0.X : -u로 응답할 주소, 여러 개를 띄워 드라이브 여러 대를 흉내 낼 때 사용
+ * -l 손실률(%) : -u에서 받은 요청 중 이 비율만큼을 응답하지 않고 버림 (재전송 시험용)
+ * 빌드: gcc -pthread -o DriveSim DriveSim.c FAS_Serial.c FAS_Trace.c
+ */
+
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include "FAS_Serial.h"
+#include "MOTION_EziSERVO2_DEFINE.h"
+#include "FAS_Frame.h"
+
+#define ORIGIN_TIME_MS 500 //원점복귀에 걸리는 시간
+#define SIM_IO_PINS 22     //입력 12 + 출력 10
+
+typedef struct
+{
+    EZISERVO2_AXISSTATUS status;
+    int32_t position;
+    int32_t velocity; //pps, 방향 포함
+    int64_t last_us;
+    int64_t travel;   //velocity x us 중 아직 position에 넣지 않은 나머지
+    int64_t origin_done_ms;
+    int32_t params[MAX_SERVO2_PARAM];
+    DWORD inputs;                //입력 logic 상태 (SERVO2_IN_BITMASK_*), 0x21로 바꿈
+    DWORD outputs;               //출력 logic 상태 (SERVO2_OUT_BITMASK_*)
+    DWORD io_logic[SIM_IO_PINS]; //pin별 I/O 할당 logic mask
+    BYTE io_level[SIM_IO_PINS];
+} SIM_DRIVE;
+
+static SIM_DRIVE drives[FAS_MAX_BOARD];
+
+ /**@brief 마지막 요청 이후 흐른 시간만큼 위치와 원점복귀 상태를 진행*/
+static void sim_update(SIM_DRIVE *d) {
+    int64_t now_u = FAS_NowUs();
+    int64_t now = now_u / 1000;
+    if (d->last_us != 0) {
+        d->travel += (int64_t)d->velocity * (now_u - d->last_us);
+        d->position += (int32_t)(d->travel / 1000000);
+        d->travel %= 1000000;
+    }
+    d->last_us = now_u;
+
+    if (d->status.FFLAG_ORIGINRETURNING && now >= d->origin_done_ms) {
+        d->status.FFLAG_ORIGINRETURNING = 0;
+        d->status.FFLAG_ORIGINRETOK = 1;
+        d->status.FFLAG_INPOSITION = 1;
+        d->status.FFLAG_MOTIONING = 0;
+        d->position = 0;
+    }
+}
+
+ /**@brief 요청 하나를 처리하고 응답 [통신상태][data...]를 만듦
+  * @return 응답 길이*/
+static int sim_handle(SIM_DRIVE *d, BYTE frame_type, const BYTE *data, int size, BYTE *out) {
+    sim_update(d);
+    out[0] = FMM_OK;
+
+    switch (frame_type)
+    {
+        case 0x01: {
+            static const char name[] = DEVNAME_EZI_SERVO2_PLUS_R_ST;
+            out[1] = DEVTYPE_EZI_SERVO2_PLUS_R_ST;
+            memcpy(&out[2], name, sizeof(name) - 1);
+            return 2 + sizeof(name) - 1;
+        }
+        case 0x05: {
+            static const char motor[] = "EzM2-56S";
+            out[1] = 1;
+            memcpy(&out[2], motor, sizeof(motor) - 1);
+            return 2 + sizeof(motor) - 1;
+        }
+        case 0x07: {
+            static const char firmware[] = "v08.01.011";
+            out[1] = 0;
+            memcpy(&out[2], firmware, sizeof(firmware) - 1);
+            return 2 + sizeof(firmware) - 1;
+        }
+        case 0x12:
+            if (size < 5 || data[0] >= MAX_SERVO2_PARAM) {
+                out[0] = FMP_DATAERROR;
+                return 1;
+            }
+            d->params[data[0]] = (int32_t)(data[1] | data[2] << 8 | data[3] << 16 | (DWORD)data[4] << 24);
+            return 1;
+        case 0x13:
+            if (size < 1 || data[0] >= MAX_SERVO2_PARAM) {
+                out[0] = FMP_DATAERROR;
+                return 1;
+            }
+            FAS_PutDword(&out[1], (DWORD)d->params[data[0]]);
+            return 5;
+        case 0x20:
+        case 0x21: { // [켤 bit 4][끌 bit 4], 0x21(입력)은 시험할 때 입력이 바뀐 것처럼 만드는 데 씀
+            if (size < 8) {
+                out[0] = FMP_DATAERROR;
+                return 1;
+            }
+            DWORD *bits = frame_type == 0x20 ? &d->outputs : &d->inputs;
+            *bits |= data[0] | data[1] << 8 | data[2] << 16 | (DWORD)data[3] << 24;
+            *bits &= ~(data[4] | data[5] << 8 | data[6] << 16 | (DWORD)data[7] << 24);
+            return 1;
+        }
+        case 0x22:
+            FAS_PutDword(&out[1], d->inputs);
+            return 5;
+        case 0x23:
+            FAS_PutDword(&out[1], d->outputs);
+            return 5;
+        case 0x24:
+            if (size < 6 || data[0] >= SIM_IO_PINS) {
+                out[0] = FMP_DATAERROR;
+                return 1;
+            }
+            d->io_logic[data[0]] = data[1] | data[2] << 8 | data[3] << 16 | (DWORD)data[4] << 24;
+            d->io_level[data[0]] = data[5];
+            return 1;
+        case 0x25:
+            if (size < 1 || data[0] >= SIM_IO_PINS) {
+                out[0] = FMP_DATAERROR;
+                return 1;
+            }
+            FAS_PutDword(&out[1], d->io_logic[data[0]]);
+            out[5] = d->io_level[data[0]];
+            return 6;
+        case 0x06:
+            FAS_PutDword(&out[1], (DWORD)d->position);
+            return 5;
+        case 0x2A:
+            d->status.FFLAG_SERVOON = size > 0 && data[0] != 0;
+            return 1;
+        case 0x2B:
+            d->status.FFLAG_ERRORALL = 0;
+            return 1;
+        case 0x2E:
+            out[1] = 0;
+            return 2;
+        case 0x31:
+        case 0x32:
+            d->velocity = 0;
+            d->status.FFLAG_MOTIONING = 0;
+            d->status.FFLAG_INPOSITION = 1;
+            d->status.FFLAG_EMGSTOP = frame_type == 0x32;
+            return 1;
+        case 0x33:
+            d->velocity = 0;
+            d->status.FFLAG_ORIGINRETURNING = 1;
+            d->status.FFLAG_ORIGINRETOK = 0;
+            d->status.FFLAG_MOTIONING = 1;
+            d->status.FFLAG_INPOSITION = 0;
+            d->origin_done_ms = FAS_NowUs() / 1000 + ORIGIN_TIME_MS;
+            return 1;
+        case 0x37:
+            if (size < 5) {
+                out[0] = FMP_DATAERROR;
+                return 1;
+            }
+            d->velocity = (int32_t)(data[0] | data[1] << 8 | data[2] << 16 | (DWORD)data[3] << 24);
+            if (data[4] == 0) {
+                d->velocity = -d->velocity;
+            }
+            d->status.FFLAG_MOTIONING = d->velocity != 0;
+            d->status.FFLAG_MOTIONDIR = data[4] != 0;
+            d->status.FFLAG_INPOSITION = d->velocity == 0;
+            return 1;
+        case 0x3A: //속도 override, 방향은 그대로 두고 크기만 바꿈
+            if (size < 4) {
+                out[0] = FMP_DATAERROR;
+                return 1;
+            }
+            if (!d->status.FFLAG_MOTIONING) {
+                out[0] = FMP_RUNFAIL;
+                return 1;
+            }
+            d->velocity = (int32_t)(data[0] | data[1] << 8 | data[2] << 16 | (DWORD)data[3] << 24);
+            if (!d->status.FFLAG_MOTIONDIR) {
+                d->velocity = -d->velocity;
+            }
+            return 1;
+        case 0x40:
+            FAS_PutDword(&out[1], d->status.dwValue);
+            return 5;
+        default:
+            return 1;
+    }
+}
+
+ /**@brief pty로 들어오는 Plus-R 프레임에 Slave 0 ~ slaves-1 로서 응답*/
+static int run_serial(int slaves) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+        perror("pty open failed");
+        return 1;
+    }
+    printf("%s\n", ptsname(master));
+    fflush(stdout);
+
+    FAS_SERIAL_PARSER parser = { 0 };
+    BYTE rx[256];
+    BYTE reply[BUFFER_SIZE];
+    BYTE frame[SERIAL_FRAME_SIZE];
+
+    while (1) {
+        ssize_t n = read(master, rx, sizeof(rx));
+        if (n <= 0) { // 클라이언트가 slave 쪽을 닫았을 때 EIO, 다시 열릴 때까지 기다림
+            usleep(10000);
+            continue;
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            if (FAS_SerialParse(&parser, rx[i]) != 1 || parser.body[0] >= slaves) {
+                continue;
+            }
+            BYTE slave = parser.body[0];
+            int size = sim_handle(&drives[slave], parser.body[1], &parser.body[2], parser.size - 2, reply);
+            int length = FAS_SerialEncode(slave, parser.body[1], reply, size, frame);
+            if (write(master, frame, length) != length) {
+                perror("pty write failed");
+            }
+        }
+    }
+    return 0;
+}
+
+ /**@brief ip:PORT로 들어오는 Plus-E 프레임에 드라이브 한 대로서 응답*/
+static int run_udp(const char *ip, int loss_percent) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(PORT) };
+    if (inet_pton(AF_INET, ip, &addr.sin_addr) != 1) {
+        fprintf(stderr, "invalid address %s\n", ip);
+        return 1;
+    }
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("udp bind failed");
+        return 1;
+    }
+    printf("%s:%d\n", ip, PORT);
+    fflush(stdout);
+
+    BYTE rx[BUFFER_SIZE];
+    BYTE tx[BUFFER_SIZE];
+    while (1) {
+        struct sockaddr_in from;
+        socklen_t from_size = sizeof(from);
+        ssize_t n = recvfrom(fd, rx, sizeof(rx), 0, (struct sockaddr *)&from, &from_size);
+        if (n < 5 || rx[0] != 0xAA || rx[1] + 2 != n || rand() % 100 < loss_percent) {
+            continue;
+        }
+        // [AA][길이][sync][00][frame type][통신상태][data...]
+        int size = sim_handle(&drives[0], rx[4], &rx[5], n - 5, &tx[5]);
+        tx[0] = 0xAA; tx[1] = 3 + size; tx[2] = rx[2]; tx[3] = 0x00; tx[4] = rx[4];
+        if (sendto(fd, tx, size + 5, 0, (struct sockaddr *)&from, from_size) < 0) {
+            perror("udp send failed");
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    int slaves = 0;
+    bool udp = false;
+    const char *ip = "127.0.0.1";
+    int loss_percent = 0;
+
+    while ((opt = getopt(argc, argv, "s:ua:l:")) != -1) {
+        switch (opt)
+        {
+            case 's':
+                slaves = atoi(optarg);
+                break;
+            case 'u':
+                udp = true;
+                break;
+            case 'a':
+                ip = optarg;
+                break;
+            case 'l':
+                loss_percent = atoi(optarg);
+                break;
+            default:
+                break;
+        }
+    }
+    if (udp) {
+        return run_udp(ip, loss_percent);
+    }
+    if (slaves <= 0 || slaves > FAS_MAX_BOARD) {
+        fprintf(stderr, "usage: %s -s slaves(1~%d) | -u [-a 127.0.0.X] [-l loss%%]\n", argv[0], FAS_MAX_BOARD);
+        return 1;
+    }
+    return run_serial(slaves);
+}
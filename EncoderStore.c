@@ -0,0 +1,475 @@
+/**
+ * @file EncoderStore.c
+ * @brief 축 하나의 엔코더 위치를 장기간 기록하는 압축 시계열 파일
+ * @details 샘플은 메모리에 모았다가 chunk가 가득 차거나 flush_interval_us가 지나면 한 번의 write로 파일 끝에 붙이고
+ * fdatasync 한 뒤에 색인 항목을 쓴다. 따라서 색인에 있는 chunk는 항상 데이터 파일에 온전히 있다.
+ * 전원이 꺼지면 아직 쓰지 않은 샘플(최대 flush_interval_us 분량)만 잃는다.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "EncoderStore.h"
+
+#define FILE_HEADER_SIZE 16
+#define COLUMN_MAX_BYTES (ENCODER_CHUNK_SAMPLES * 8 + ENCODER_CHUNK_SAMPLES / ENCODER_PACK_BLOCK + 1)
+
+struct ENCODER_STORE
+{
+    int fd;
+    int index_fd;
+    uint64_t size;             //데이터 파일에서 유효한 길이
+    int64_t flush_interval_us;
+
+    int pending;               //아직 파일에 쓰지 않은 샘플 수
+    int64_t times[ENCODER_CHUNK_SAMPLES];
+    int32_t values[ENCODER_CHUNK_SAMPLES];
+
+    ENCODER_INDEX_ENTRY *index;
+    uint64_t index_count;
+    uint64_t index_capacity;
+    uint64_t samples;          //파일에 있는 샘플 수
+
+    BYTE chunk[sizeof(ENCODER_CHUNK_HEADER) + 2 * COLUMN_MAX_BYTES];
+    ENCODER_SAMPLE decoded[ENCODER_CHUNK_SAMPLES];
+};
+
+/************************************************************************************************************************************
+ ******************************************************* CRC32, bit-packing *********************************************************
+ ************************************************************************************************************************************/
+
+static DWORD crc_table[256];
+
+static void crc_init(void) {
+    if (crc_table[1] != 0) {
+        return;
+    }
+    for (DWORD i = 0; i < 256; i++) {
+        DWORD c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+        }
+        crc_table[i] = c;
+    }
+}
+
+static DWORD crc32_update(DWORD crc, const BYTE *data, size_t size) {
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static DWORD chunk_crc(const ENCODER_CHUNK_HEADER *header, const BYTE *payload) {
+    DWORD crc = crc32_update(0, (const BYTE *)header, offsetof(ENCODER_CHUNK_HEADER, crc));
+    return crc32_update(crc, payload, header->time_bytes + header->value_bytes);
+}
+
+typedef struct
+{
+    BYTE *p;
+    const BYTE *end;
+    uint64_t acc;
+    int bits;
+} BIT_STREAM;
+
+static void put_bits(BIT_STREAM *s, uint64_t value, int width) {
+    if (width > 32) {
+        put_bits(s, value & 0xFFFFFFFF, 32);
+        put_bits(s, value >> 32, width - 32);
+        return;
+    }
+    s->acc |= (value & ((1ull << width) - 1)) << s->bits;
+    s->bits += width;
+    while (s->bits >= 8) {
+        *s->p++ = (BYTE)s->acc;
+        s->acc >>= 8;
+        s->bits -= 8;
+    }
+}
+
+static void put_flush(BIT_STREAM *s) {
+    if (s->bits > 0) {
+        *s->p++ = (BYTE)s->acc;
+    }
+    s->acc = 0;
+    s->bits = 0;
+}
+
+static bool get_bits(BIT_STREAM *s, int width, uint64_t *value) {
+    if (width > 32) {
+        uint64_t lo, hi;
+        if (!get_bits(s, 32, &lo) || !get_bits(s, width - 32, &hi)) {
+            return false;
+        }
+        *value = lo | hi << 32;
+        return true;
+    }
+    while (s->bits < width) {
+        if (s->p >= s->end) {
+            return false;
+        }
+        s->acc |= (uint64_t)*s->p++ << s->bits;
+        s->bits += 8;
+    }
+    *value = s->acc & ((1ull << width) - 1);
+    s->acc >>= width;
+    s->bits -= width;
+    return true;
+}
+
+static uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+ /**@brief 열 하나를 delta-of-delta + bit-packing으로 씀, 첫 값은 헤더에 있으므로 count-1개만 씀
+  * @return 쓴 바이트 수*/
+static DWORD encode_column(const int64_t *v, int count, BYTE *out) {
+    BIT_STREAM s = { .p = out };
+    uint64_t block[ENCODER_PACK_BLOCK];
+    int64_t prev_delta = 0;
+
+    for (int i = 1; i < count; i += ENCODER_PACK_BLOCK) {
+        int n = count - i < ENCODER_PACK_BLOCK ? count - i : ENCODER_PACK_BLOCK;
+        uint64_t any = 0;
+        for (int k = 0; k < n; k++) {
+            int64_t delta = v[i + k] - v[i + k - 1];
+            block[k] = zigzag(delta - prev_delta);
+            prev_delta = delta;
+            any |= block[k];
+        }
+        int width = any ? 64 - __builtin_clzll(any) : 0;
+        *s.p++ = (BYTE)width;
+        for (int k = 0; k < n; k++) {
+            put_bits(&s, block[k], width);
+        }
+        put_flush(&s);
+    }
+    return (DWORD)(s.p - out);
+}
+
+static bool decode_column(const BYTE *in, DWORD size, int64_t first, int count, int64_t *v) {
+    BIT_STREAM s = { .p = (BYTE *)in, .end = in + size };
+    int64_t delta = 0;
+
+    v[0] = first;
+    for (int i = 1; i < count; i += ENCODER_PACK_BLOCK) {
+        int n = count - i < ENCODER_PACK_BLOCK ? count - i : ENCODER_PACK_BLOCK;
+        if (s.p >= s.end) {
+            return false;
+        }
+        int width = *s.p++;
+        if (width > 64) {
+            return false;
+        }
+        for (int k = 0; k < n; k++) {
+            uint64_t z;
+            if (!get_bits(&s, width, &z)) {
+                return false;
+            }
+            delta += unzigzag(z);
+            v[i + k] = v[i + k - 1] + delta;
+        }
+        s.acc = 0;
+        s.bits = 0;
+    }
+    return true;
+}
+
+/************************************************************************************************************************************
+ ******************************************************* 색인 ***********************************************************************
+ ************************************************************************************************************************************/
+
+static bool index_push(ENCODER_STORE *store, const ENCODER_INDEX_ENTRY *entry) {
+    if (store->index_count == store->index_capacity) {
+        uint64_t capacity = store->index_capacity ? store->index_capacity * 2 : 256;
+        ENCODER_INDEX_ENTRY *index = realloc(store->index, capacity * sizeof(ENCODER_INDEX_ENTRY));
+        if (index == NULL) {
+            return false;
+        }
+        store->index = index;
+        store->index_capacity = capacity;
+    }
+    store->index[store->index_count++] = *entry;
+    store->samples += entry->count;
+    return true;
+}
+
+ /**@brief offset 위치의 chunk를 읽고 CRC까지 확인
+  * @return 헤더 포함 chunk 길이, 잘못된 chunk면 0*/
+static DWORD read_chunk(ENCODER_STORE *store, uint64_t offset, uint64_t file_size) {
+    ENCODER_CHUNK_HEADER *header = (ENCODER_CHUNK_HEADER *)store->chunk;
+
+    if (offset + sizeof(*header) > file_size || pread(store->fd, header, sizeof(*header), offset) != sizeof(*header)) {
+        return 0;
+    }
+    if (header->magic != ENCODER_CHUNK_MAGIC || header->count == 0 || header->count > ENCODER_CHUNK_SAMPLES ||
+        header->time_bytes > COLUMN_MAX_BYTES || header->value_bytes > COLUMN_MAX_BYTES) {
+        return 0;
+    }
+    DWORD payload = header->time_bytes + header->value_bytes;
+    if (offset + sizeof(*header) + payload > file_size ||
+        pread(store->fd, store->chunk + sizeof(*header), payload, offset + sizeof(*header)) != (ssize_t)payload) {
+        return 0;
+    }
+    if (chunk_crc(header, store->chunk + sizeof(*header)) != header->crc) {
+        return 0;
+    }
+    return sizeof(*header) + payload;
+}
+
+ /**@brief 색인 파일을 읽고, 색인 뒤에 남은 chunk는 직접 확인해서 색인을 맞춤. 끊긴 chunk는 잘라냄*/
+static bool recover(ENCODER_STORE *store, uint64_t file_size) {
+    uint64_t offset = FILE_HEADER_SIZE;
+    ENCODER_INDEX_ENTRY entry;
+    bool rewrite = false;
+
+    // 색인은 chunk가 파일 안에 이어서 있는 동안만 믿음
+    while (read(store->index_fd, &entry, sizeof(entry)) == sizeof(entry)) {
+        if (entry.offset != offset || entry.offset + entry.size > file_size || entry.count == 0) {
+            rewrite = true;
+            break;
+        }
+        if (!index_push(store, &entry)) {
+            return false;
+        }
+        offset += entry.size;
+    }
+    if (lseek(store->index_fd, 0, SEEK_END) != (off_t)(store->index_count * sizeof(ENCODER_INDEX_ENTRY))) {
+        rewrite = true; // 끝에 끊긴 항목이 있음
+    }
+
+    // 색인에 없는 chunk는 CRC까지 확인
+    DWORD size;
+    while ((size = read_chunk(store, offset, file_size)) > 0) {
+        const ENCODER_CHUNK_HEADER *header = (const ENCODER_CHUNK_HEADER *)store->chunk;
+        entry = (ENCODER_INDEX_ENTRY){ .offset = offset, .t_first = header->t_first, .t_last = header->t_last,
+                                       .count = header->count, .size = size };
+        if (!index_push(store, &entry)) {
+            return false;
+        }
+        offset += size;
+        rewrite = true;
+    }
+    if (offset < file_size) {
+        fprintf(stderr, "encoder store: dropping %llu bytes of incomplete chunk\n", (unsigned long long)(file_size - offset));
+        if (ftruncate(store->fd, offset) < 0) {
+            return false;
+        }
+    }
+    store->size = offset;
+
+    if (rewrite) {
+        size_t bytes = store->index_count * sizeof(ENCODER_INDEX_ENTRY);
+        if (ftruncate(store->index_fd, 0) < 0 || pwrite(store->index_fd, store->index, bytes, 0) != (ssize_t)bytes) {
+            return false;
+        }
+    }
+    return lseek(store->index_fd, 0, SEEK_END) >= 0;
+}
+
+/************************************************************************************************************************************
+ ******************************************************* 공개 함수 ******************************************************************
+ ************************************************************************************************************************************/
+
+ /**@brief 저장 파일을 열거나 새로 만듦, 이미 있으면 이어서 기록
+  * @param int64_t flush_interval_us 첫 샘플부터 이 시간이 지나면 chunk가 덜 차도 파일에 씀 (0이면 가득 찰 때만)
+  * @return 실패 시 NULL*/
+ENCODER_STORE *EncoderStore_Open(const char *path, int64_t flush_interval_us) {
+    char index_path[512];
+    struct stat st;
+
+    crc_init();
+    ENCODER_STORE *store = calloc(1, sizeof(ENCODER_STORE));
+    if (store == NULL) {
+        return NULL;
+    }
+    store->flush_interval_us = flush_interval_us;
+    snprintf(index_path, sizeof(index_path), "%s.idx", path);
+    store->fd = open(path, O_RDWR | O_CREAT, 0644);
+    store->index_fd = open(index_path, O_RDWR | O_CREAT, 0644);
+    if (store->fd < 0 || store->index_fd < 0 || fstat(store->fd, &st) < 0) {
+        perror("encoder store open failed");
+        EncoderStore_Close(store);
+        return NULL;
+    }
+
+    BYTE header[FILE_HEADER_SIZE] = ENCODER_STORE_MAGIC;
+    if (st.st_size < FILE_HEADER_SIZE) { // 새 파일
+        if (ftruncate(store->fd, 0) < 0 || ftruncate(store->index_fd, 0) < 0 ||
+            pwrite(store->fd, header, sizeof(header), 0) != sizeof(header)) {
+            EncoderStore_Close(store);
+            return NULL;
+        }
+        st.st_size = FILE_HEADER_SIZE;
+    }
+    else if (pread(store->fd, header, sizeof(header), 0) != sizeof(header) || memcmp(header, ENCODER_STORE_MAGIC, 4) != 0) {
+        fprintf(stderr, "%s: not an encoder store\n", path);
+        EncoderStore_Close(store);
+        return NULL;
+    }
+    if (!recover(store, st.st_size)) {
+        perror("encoder store recover failed");
+        EncoderStore_Close(store);
+        return NULL;
+    }
+    return store;
+}
+
+ /**@brief 샘플 하나를 추가, 시간은 줄어들면 안 됨
+  * @return 시간이 거꾸로 가거나 파일 쓰기에 실패하면 FALSE, 쓰지 못한 chunk가 가득 차 있으면 다시 써 보고 그래도 실패하면 받지 않음*/
+bool EncoderStore_Append(ENCODER_STORE *store, int64_t time_us, int32_t position) {
+    if (store->pending == ENCODER_CHUNK_SAMPLES && !EncoderStore_Flush(store)) {
+        return false;
+    }
+    int64_t last = store->pending > 0 ? store->times[store->pending - 1]
+                 : store->index_count > 0 ? store->index[store->index_count - 1].t_last : INT64_MIN;
+    if (time_us < last) {
+        return false;
+    }
+    store->times[store->pending] = time_us;
+    store->values[store->pending] = position;
+    store->pending++;
+
+    if (store->pending == ENCODER_CHUNK_SAMPLES ||
+        (store->flush_interval_us > 0 && time_us - store->times[0] >= store->flush_interval_us)) {
+        return EncoderStore_Flush(store);
+    }
+    return true;
+}
+
+ /**@brief 모아 둔 샘플을 chunk 하나로 만들어 파일 끝에 붙임*/
+bool EncoderStore_Flush(ENCODER_STORE *store) {
+    int count = store->pending;
+    int64_t column[ENCODER_CHUNK_SAMPLES];
+
+    if (count == 0) {
+        return true;
+    }
+    ENCODER_CHUNK_HEADER *header = (ENCODER_CHUNK_HEADER *)store->chunk;
+    BYTE *payload = store->chunk + sizeof(*header);
+    *header = (ENCODER_CHUNK_HEADER){ .magic = ENCODER_CHUNK_MAGIC, .count = count,
+                                      .t_first = store->times[0], .t_last = store->times[count - 1],
+                                      .v_first = store->values[0], .v_min = store->values[0], .v_max = store->values[0] };
+    for (int i = 0; i < count; i++) {
+        column[i] = store->values[i];
+        if (store->values[i] < header->v_min) {
+            header->v_min = store->values[i];
+        }
+        if (store->values[i] > header->v_max) {
+            header->v_max = store->values[i];
+        }
+    }
+    header->time_bytes = encode_column(store->times, count, payload);
+    header->value_bytes = encode_column(column, count, payload + header->time_bytes);
+    header->crc = chunk_crc(header, payload);
+
+    DWORD size = sizeof(*header) + header->time_bytes + header->value_bytes;
+    if (pwrite(store->fd, store->chunk, size, store->size) != (ssize_t)size || fdatasync(store->fd) < 0) {
+        perror("encoder store write failed");
+        return false;
+    }
+    ENCODER_INDEX_ENTRY entry = { .offset = store->size, .t_first = header->t_first, .t_last = header->t_last,
+                                  .count = count, .size = size };
+    store->size += size;
+    store->pending = 0;
+    if (!index_push(store, &entry) || write(store->index_fd, &entry, sizeof(entry)) != sizeof(entry)) {
+        perror("encoder index write failed"); // 다음에 열 때 데이터 파일에서 다시 만들어짐
+    }
+    return true;
+}
+
+ /**@brief 남은 샘플을 쓰고 닫음*/
+void EncoderStore_Close(ENCODER_STORE *store) {
+    if (store == NULL) {
+        return;
+    }
+    if (store->fd >= 0 && store->index_fd >= 0) {
+        EncoderStore_Flush(store);
+    }
+    if (store->fd >= 0) {
+        close(store->fd);
+    }
+    if (store->index_fd >= 0) {
+        close(store->index_fd);
+    }
+    free(store->index);
+    free(store);
+}
+
+static int visit_range(const ENCODER_SAMPLE *samples, int count, int64_t from_us, int64_t to_us, ENCODER_VISIT visit, void *user, bool *stop) {
+    int first = 0, last = count;
+    while (first < count && samples[first].time_us < from_us) {
+        first++;
+    }
+    while (last > first && samples[last - 1].time_us > to_us) {
+        last--;
+    }
+    if (last > first && !visit(&samples[first], last - first, user)) {
+        *stop = true;
+    }
+    return last - first;
+}
+
+ /**@brief from_us ~ to_us(포함) 사이의 샘플을 시간 순으로 chunk 단위로 넘겨줌, 아직 쓰지 않은 샘플도 포함
+  * @return 넘겨준 샘플 수*/
+uint64_t EncoderStore_Query(ENCODER_STORE *store, int64_t from_us, int64_t to_us, ENCODER_VISIT visit, void *user) {
+    int64_t times[ENCODER_CHUNK_SAMPLES];
+    int64_t values[ENCODER_CHUNK_SAMPLES];
+    uint64_t visited = 0;
+    bool stop = false;
+
+    // t_last >= from_us 인 첫 chunk
+    uint64_t lo = 0, hi = store->index_count;
+    while (lo < hi) {
+        uint64_t mid = (lo + hi) / 2;
+        if (store->index[mid].t_last < from_us) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    for (uint64_t i = lo; i < store->index_count && store->index[i].t_first <= to_us && !stop; i++) {
+        if (read_chunk(store, store->index[i].offset, store->size) == 0) {
+            fprintf(stderr, "encoder store: bad chunk at %llu\n", (unsigned long long)store->index[i].offset);
+            continue;
+        }
+        const ENCODER_CHUNK_HEADER *header = (const ENCODER_CHUNK_HEADER *)store->chunk;
+        const BYTE *payload = store->chunk + sizeof(*header);
+        int count = header->count;
+        if (!decode_column(payload, header->time_bytes, header->t_first, count, times) ||
+            !decode_column(payload + header->time_bytes, header->value_bytes, header->v_first, count, values)) {
+            continue;
+        }
+        for (int k = 0; k < count; k++) {
+            store->decoded[k].time_us = times[k];
+            store->decoded[k].position = (int32_t)values[k];
+        }
+        visited += visit_range(store->decoded, count, from_us, to_us, visit, user, &stop);
+    }
+    if (!stop && store->pending > 0) {
+        for (int k = 0; k < store->pending; k++) {
+            store->decoded[k].time_us = store->times[k];
+            store->decoded[k].position = store->values[k];
+        }
+        visited += visit_range(store->decoded, store->pending, from_us, to_us, visit, user, &stop);
+    }
+    return visited;
+}
+
+ /**@brief 파일에 쓰인 chunk 수, 샘플 수, 데이터 파일 크기*/
+void EncoderStore_Stats(const ENCODER_STORE *store, uint64_t *chunks, uint64_t *samples, uint64_t *bytes) {
+    *chunks = store->index_count;
+    *samples = store->samples;
+    *bytes = store->size;
+}
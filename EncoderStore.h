@@ -0,0 +1,64 @@
+#pragma once
+
+/**
+ * @file EncoderStore.h
+ * @brief 축 하나의 엔코더 위치를 장기간 기록하는 압축 시계열 파일
+ * @details 파일: [헤더 16바이트 "FTS1"][chunk][chunk]... (append only)
+ * chunk: [ENCODER_CHUNK_HEADER][시간 열][위치 열], 열마다 delta-of-delta를 zigzag로 바꾼 뒤
+ * 64개씩 묶어 그 묶음에서 가장 큰 값의 비트 수로 bit-packing 한다. 일정한 주기로 일정한 속도로 움직이면 거의 0비트가 된다.
+ * chunk마다 CRC32가 있어 쓰다가 끊긴 마지막 chunk는 다시 열 때 잘라낸다.
+ * 옆에 "<path>.idx" 색인 파일(chunk 위치와 시간 범위)을 두고, 시간 범위 조회는 색인에서 이분 탐색한 chunk만 읽는다.
+ * 색인은 데이터 파일로부터 언제든 다시 만들 수 있다.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "MOTION_DEFINE.h"
+
+#define ENCODER_STORE_MAGIC "FTS1"
+#define ENCODER_CHUNK_MAGIC 0x4B4E4843 //"CHNK"
+#define ENCODER_CHUNK_SAMPLES 4096 //chunk 하나에 들어가는 최대 샘플 수
+#define ENCODER_PACK_BLOCK 64      //bit-packing 묶음 크기
+
+typedef struct
+{
+    int64_t time_us;
+    int32_t position;
+} ENCODER_SAMPLE;
+
+typedef struct
+{
+    DWORD magic;
+    DWORD count;
+    int64_t t_first;
+    int64_t t_last;
+    int32_t v_first;
+    int32_t v_min;
+    int32_t v_max;
+    DWORD time_bytes;   //시간 열 길이
+    DWORD value_bytes;  //위치 열 길이
+    DWORD crc;          //crc를 뺀 헤더 + 두 열에 대한 CRC32
+} ENCODER_CHUNK_HEADER;
+
+ /**@brief 색인 파일 항목 하나 (chunk 하나)*/
+typedef struct
+{
+    uint64_t offset;
+    int64_t t_first;
+    int64_t t_last;
+    DWORD count;
+    DWORD size; //헤더 포함 chunk 전체 길이
+} ENCODER_INDEX_ENTRY;
+
+typedef struct ENCODER_STORE ENCODER_STORE;
+
+ /**@brief 조회 결과를 chunk 단위로 넘겨받는 함수, FALSE를 돌려주면 조회 중단*/
+typedef bool (*ENCODER_VISIT)(const ENCODER_SAMPLE *samples, int count, void *user);
+
+ENCODER_STORE *EncoderStore_Open(const char *path, int64_t flush_interval_us);
+bool EncoderStore_Append(ENCODER_STORE *store, int64_t time_us, int32_t position);
+bool EncoderStore_Flush(ENCODER_STORE *store);
+void EncoderStore_Close(ENCODER_STORE *store);
+uint64_t EncoderStore_Query(ENCODER_STORE *store, int64_t from_us, int64_t to_us, ENCODER_VISIT visit, void *user);
+void EncoderStore_Stats(const ENCODER_STORE *store, uint64_t *chunks, uint64_t *samples, uint64_t *bytes);
@@ -0,0 +1,132 @@
+/**
+ * @file FAS_Ethernet.c
+ * @brief Ezi-SERVO II Plus-E용 UDP/TCP transport
+ * @details ProtocolTest.c의 FAS_Connect/FAS_ConnectTCP에 있던 소켓 코드를 transport로 옮긴 것.
+ * TCP는 스트림이므로 길이 바이트를 보고 프레임 하나를 끝까지 읽는다.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include "FAS_Trace.h"
+#include "FAS_Transport.h"
+
+typedef struct
+{
+    FAS_TRANSPORT base;
+    struct sockaddr_in addr;
+    bool tcp;
+} FAS_ETHERNET;
+
+FAS_POOL_DEFINE(FAS_EthernetPool, FAS_ETHERNET);
+
+static int ethernet_send(FAS_TRANSPORT *tp, int iBdID, const BYTE *frame, int size) {
+    FAS_ETHERNET *eth = (FAS_ETHERNET *)tp;
+    FAS_TRACE_BEGIN(span, "sendto", size);
+    int result = sendto(tp->fd, frame, size, 0, eth->tcp ? NULL : (const struct sockaddr *)&eth->addr, eth->tcp ? 0 : sizeof(eth->addr));
+    FAS_TRACE_END(span);
+    if (result < 0) {
+        perror("sendto failed");
+    }
+    return result;
+}
+
+ /**@brief timeout 안에 size 바이트를 다 읽음 (TCP용)*/
+static int read_full(int fd, BYTE *dst, int size, int timeout_ms) {
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    int done = 0;
+    while (done < size) {
+        if (poll(&pfd, 1, timeout_ms) <= 0) {
+            return -1;
+        }
+        ssize_t n = recv(fd, dst + done, size - done, 0);
+        if (n <= 0) {
+            return -1;
+        }
+        done += n;
+    }
+    return done;
+}
+
+static int ethernet_recv(FAS_TRANSPORT *tp, int iBdID, BYTE *frame, int size, int timeout_ms) {
+    FAS_ETHERNET *eth = (FAS_ETHERNET *)tp;
+
+    if (eth->tcp) {
+        if (size < 2 || read_full(tp->fd, frame, 2, timeout_ms) < 0) {
+            return -1;
+        }
+        if (frame[1] + 2 > size || read_full(tp->fd, frame + 2, frame[1], timeout_ms) < 0) {
+            return -1;
+        }
+        return frame[1] + 2;
+    }
+
+    struct pollfd pfd = { .fd = tp->fd, .events = POLLIN };
+    FAS_TRACE_BEGIN(wait, "poll", timeout_ms);
+    int ready = poll(&pfd, 1, timeout_ms);
+    FAS_TRACE_END(wait);
+    if (ready <= 0) {
+        return -1;
+    }
+    FAS_TRACE_BEGIN(span, "recvfrom", 0);
+    ssize_t received_bytes = recvfrom(tp->fd, frame, size, 0, NULL, NULL);
+    span.arg = (int)received_bytes;
+    FAS_TRACE_END(span);
+    if (received_bytes < 0) {
+        perror("recvfrom failed");
+    }
+    return received_bytes;
+}
+
+static void ethernet_close(FAS_TRANSPORT *tp) {
+    close(tp->fd);
+    FAS_PoolFree(&FAS_EthernetPool, tp);
+}
+
+static const FAS_TRANSPORT_OPS ethernet_ops = {
+    .name = "Ethernet",
+    .send = ethernet_send,
+    .recv = ethernet_recv,
+    .close = ethernet_close,
+};
+
+ /**@brief 드라이브 IP로 UDP 또는 TCP 소켓을 열고 transport로 돌려줌
+  * @param const char *ip "xxx.xxx.xxx.xxx"
+  * @param bool tcp TRUE면 TCP 연결, FALSE면 UDP
+  * @return 실패 시 NULL*/
+FAS_TRANSPORT *FAS_EthernetOpen(const char *ip, bool tcp) {
+    FAS_ETHERNET *eth = FAS_PoolAlloc(&FAS_EthernetPool);
+    if (eth == NULL) {
+        return NULL;
+    }
+    eth->base.ops = &ethernet_ops;
+    eth->base.datagram = !tcp;
+    eth->tcp = tcp;
+
+    // Create socket
+    if ((eth->base.fd = socket(AF_INET, tcp ? SOCK_STREAM : SOCK_DGRAM, 0)) < 0) {
+        perror("Socket creation failed");
+        FAS_PoolFree(&FAS_EthernetPool, eth);
+        return NULL;
+    }
+
+    // Configure server address
+    eth->addr.sin_family = AF_INET;
+    eth->addr.sin_port = htons(PORT);
+    if (inet_pton(AF_INET, ip, &eth->addr.sin_addr) <= 0) {
+        perror("Invalid address/ Address not supported");
+        ethernet_close(&eth->base);
+        return NULL;
+    }
+
+    // Connect to server
+    if (tcp && connect(eth->base.fd, (struct sockaddr *)&eth->addr, sizeof(eth->addr)) == -1) {
+        perror("Connection failed");
+        ethernet_close(&eth->base);
+        return NULL;
+    }
+    return &eth->base;
+}
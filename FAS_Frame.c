@@ -0,0 +1,132 @@
+/**
+ * @file FAS_Frame.c
+ * @brief 프레임 버퍼 pool
+ * @details 빈 칸 목록은 인덱스로 연결한 stack이고, head에는 (꺼낸 횟수 << 32 | 인덱스 + 1)을 넣어
+ * 다른 스레드가 같은 칸을 꺼냈다 돌려놓은 사이에 compare-exchange가 잘못 성공하지 않게 한다. (0은 빈 목록)
+ */
+
+#include <stdatomic.h>
+#include "FAS_Frame.h"
+
+static FAS_FRAME pool[FAS_FRAME_POOL_SIZE];
+static _Atomic uint64_t free_head;
+static atomic_flag pool_ready = ATOMIC_FLAG_INIT;
+static _Atomic int ready;
+static _Atomic int in_use, peak;
+static _Atomic uint64_t exhausted;
+
+ /**@brief 처음 쓸 때 모든 칸을 빈 칸 목록에 연결*/
+static void pool_init(void) {
+    if (atomic_load_explicit(&ready, memory_order_acquire)) {
+        return;
+    }
+    if (!atomic_flag_test_and_set(&pool_ready)) {
+        for (int i = 0; i < FAS_FRAME_POOL_SIZE; i++) {
+            atomic_init(&pool[i].next, i + 1 < FAS_FRAME_POOL_SIZE ? i + 1 : -1);
+        }
+        atomic_store(&free_head, 1);
+        atomic_store_explicit(&ready, 1, memory_order_release);
+    }
+    while (!atomic_load_explicit(&ready, memory_order_acquire)) {
+    }
+}
+
+ /**@brief pool에서 프레임 하나를 참조 1로 꺼냄
+  * @return 빈 칸이 없으면 NULL*/
+FAS_FRAME *FAS_FrameAlloc(void) {
+    pool_init();
+    uint64_t head = atomic_load(&free_head);
+    while (1) {
+        int index = (int)(head & 0xFFFFFFFF) - 1;
+        if (index < 0) {
+            atomic_fetch_add(&exhausted, 1);
+            return NULL;
+        }
+        uint64_t next = ((head >> 32) + 1) << 32 | (uint32_t)(atomic_load(&pool[index].next) + 1);
+        if (atomic_compare_exchange_weak(&free_head, &head, next)) {
+            FAS_FRAME *frame = &pool[index];
+            frame->size = 0;
+            frame->acquired_us = 0;
+            frame->has_text = false;
+            atomic_store(&frame->refs, 1);
+            int used = atomic_fetch_add(&in_use, 1) + 1;
+            int old_peak = atomic_load(&peak);
+            while (used > old_peak && !atomic_compare_exchange_weak(&peak, &old_peak, used)) {
+            }
+            return frame;
+        }
+    }
+}
+
+ /**@brief 참조를 하나 늘림, 프레임을 다른 곳(스레드)에 넘기기 전에 부름
+  * @return frame*/
+FAS_FRAME *FAS_FrameRef(FAS_FRAME *frame) {
+    if (frame != NULL) {
+        atomic_fetch_add_explicit(&frame->refs, 1, memory_order_relaxed);
+    }
+    return frame;
+}
+
+ /**@brief 참조를 하나 줄이고 마지막이면 pool로 돌려놓음, NULL이면 아무것도 안 함*/
+void FAS_FrameUnref(FAS_FRAME *frame) {
+    if (frame == NULL || atomic_fetch_sub_explicit(&frame->refs, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+    int index = (int)(frame - pool);
+    uint64_t head = atomic_load(&free_head);
+    do {
+        atomic_store(&frame->next, (int)(head & 0xFFFFFFFF) - 1);
+    } while (!atomic_compare_exchange_weak(&free_head, &head, (head & 0xFFFFFFFF00000000ull) | (uint32_t)(index + 1)));
+    atomic_fetch_sub(&in_use, 1);
+}
+
+ /**@brief 보드에서 응답 프레임 하나를 pool 프레임에 바로 받음
+  * @return 받은 프레임 (참조 1), timeout이나 pool이 비었으면 NULL*/
+FAS_FRAME *FAS_FrameRecv(int iBdID, int timeout_ms) {
+    FAS_FRAME *frame = FAS_FrameAlloc();
+    if (frame == NULL) {
+        return NULL;
+    }
+    frame->size = FAS_RecvFrame(iBdID, frame->data, sizeof(frame->data), timeout_ms);
+    if (frame->size < 0) {
+        FAS_FrameUnref(frame);
+        return NULL;
+    }
+    return frame;
+}
+
+ /**@brief 바이트 배열을 "AA 03 ..." 형식으로 text에 씀, 넘치는 바이트는 버림
+  * @return 쓴 글자 수 ('\0' 제외)*/
+int FAS_FrameFormat(const BYTE *data, int size, char *text, int text_size) {
+    static const char hex[] = "0123456789ABCDEF";
+    char *p = text;
+
+    if (text_size <= 0) {
+        return 0;
+    }
+    for (int i = 0; i < size && (p - text) + (i > 0 ? 3 : 2) < text_size; i++) {
+        if (i > 0) {
+            *p++ = ' ';
+        }
+        *p++ = hex[data[i] >> 4];
+        *p++ = hex[data[i] & 0x0F];
+    }
+    *p = '\0';
+    return (int)(p - text);
+}
+
+ /**@brief 프레임 내용을 "AA 03 ..." 문자열로, 처음 부를 때 한 번만 만들어 프레임 안에 둠
+  * @details 여러 스레드가 같은 프레임에 처음으로 동시에 부르지 않도록 프레임을 넘기기 전에 부르거나 한 스레드에서만 부름*/
+const char *FAS_FrameText(FAS_FRAME *frame) {
+    if (!frame->has_text) {
+        FAS_FrameFormat(frame->data, frame->size, frame->text, sizeof(frame->text));
+        frame->has_text = true;
+    }
+    return frame->text;
+}
+
+void FAS_FramePoolStats(FAS_FRAME_POOL_STATS *stats) {
+    stats->in_use = atomic_load(&in_use);
+    stats->peak = atomic_load(&peak);
+    stats->exhausted = atomic_load(&exhausted);
+}
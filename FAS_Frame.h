@@ -0,0 +1,56 @@
+#pragma once
+
+/**
+ * @file FAS_Frame.h
+ * @brief 미리 잡아 둔 프레임 버퍼(BUFFER_SIZE 바이트) pool, 참조 횟수로 여러 곳에서 복사 없이 같이 씀
+ * @details 받은 프레임 하나를 해석, 기록, 화면 표시에 넘길 때 각자 FAS_FrameRef로 참조를 늘리고
+ * 다 쓰면 FAS_FrameUnref로 줄인다. 마지막 참조가 풀리면 pool로 돌아간다.
+ * pool은 정적 배열이고 빈 칸 목록은 lock-free라서 어느 스레드에서 잡고 풀어도 되며, 쓰는 동안 malloc이 없다.
+ * 참조가 둘 이상인 프레임의 data는 읽기만 한다.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "FAS_Library.h"
+
+#define FAS_FRAME_POOL_SIZE 256
+#define FAS_FRAME_TEXT_SIZE (BUFFER_SIZE * 3) //바이트마다 "XX " (마지막은 공백 대신 '\0')
+
+typedef struct
+{
+    BYTE data[BUFFER_SIZE];
+    int size;
+    int64_t acquired_us;            //응답이면 드라이브가 값을 읽은 시각 (monotonic us), 모르면 0
+    char text[FAS_FRAME_TEXT_SIZE]; //FAS_FrameText가 채우는 "AA 03 ..." 문자열
+    bool has_text;
+    _Atomic int refs;
+    _Atomic int next;                //pool 안에서 다음 빈 칸, 쓰는 중에는 의미 없음
+} FAS_FRAME;
+
+ /**@brief pool 사용 현황*/
+typedef struct
+{
+    int in_use;
+    int peak;
+    uint64_t exhausted; //빈 칸이 없어 FAS_FrameAlloc이 NULL을 돌려준 횟수
+} FAS_FRAME_POOL_STATS;
+
+ /**@brief 프레임 data의 little-endian 4바이트 값을 읽음*/
+static inline DWORD FAS_GetDword(const BYTE *in) {
+    return in[0] | in[1] << 8 | in[2] << 16 | (DWORD)in[3] << 24;
+}
+
+ /**@brief 프레임 data에 4바이트 값을 little-endian으로 씀*/
+static inline void FAS_PutDword(BYTE *out, DWORD value) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+FAS_FRAME *FAS_FrameAlloc(void);
+FAS_FRAME *FAS_FrameRef(FAS_FRAME *frame);
+void FAS_FrameUnref(FAS_FRAME *frame);
+FAS_FRAME *FAS_FrameRecv(int iBdID, int timeout_ms);
+int FAS_FrameFormat(const BYTE *data, int size, char *text, int text_size);
+const char *FAS_FrameText(FAS_FRAME *frame);
+void FAS_FramePoolStats(FAS_FRAME_POOL_STATS *stats);
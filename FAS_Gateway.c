@@ -0,0 +1,94 @@
+/**
+ * @file FAS_Gateway.c
+ * @brief DriveGateway에 Unix domain socket으로 붙는 transport
+ * @details 드라이브에 직접 연결하지 않고 DriveGateway가 가진 연결을 같이 쓴다.
+ * SOCK_SEQPACKET이라 메시지 하나가 프레임 하나이고, 메시지는 [보드 ID][Plus-E 프레임] 형식이다.
+ * 응답도 같은 형식이며 sync 번호는 보낸 요청의 것으로 돌아온다. 드라이브가 응답하지 않으면 아무것도 오지 않는다.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "FAS_Transport.h"
+
+FAS_POOL_DEFINE(FAS_GatewayPool, FAS_TRANSPORT);
+
+static int gateway_send(FAS_TRANSPORT *tp, int iBdID, const BYTE *frame, int size) {
+    BYTE message[1 + BUFFER_SIZE];
+
+    if (size <= 0 || size > BUFFER_SIZE) {
+        return -1;
+    }
+    message[0] = (BYTE)iBdID;
+    memcpy(&message[1], frame, size);
+    if (send(tp->fd, message, size + 1, MSG_NOSIGNAL) < 0) {
+        perror("gateway send failed");
+        return -1;
+    }
+    return size;
+}
+
+static int gateway_recv(FAS_TRANSPORT *tp, int iBdID, BYTE *frame, int size, int timeout_ms) {
+    BYTE message[1 + BUFFER_SIZE];
+    struct pollfd pfd = { .fd = tp->fd, .events = POLLIN };
+
+    while (1) {
+        if (poll(&pfd, 1, timeout_ms) <= 0) {
+            return -1;
+        }
+        ssize_t n = recv(tp->fd, message, sizeof(message), 0);
+        if (n <= 0) {
+            return -1; //gateway가 끊김
+        }
+        if (n < 2 || message[0] != (BYTE)iBdID || n - 1 > size) {
+            continue;
+        }
+        memcpy(frame, &message[1], n - 1);
+        return (int)n - 1;
+    }
+}
+
+static void gateway_close(FAS_TRANSPORT *tp) {
+    close(tp->fd);
+    FAS_PoolFree(&FAS_GatewayPool, tp);
+}
+
+static const FAS_TRANSPORT_OPS gateway_ops = {
+    .name = "Gateway",
+    .send = gateway_send,
+    .recv = gateway_recv,
+    .close = gateway_close,
+};
+
+ /**@brief DriveGateway의 Unix domain socket에 연결하고 transport로 돌려줌
+  * @param const char *path gateway socket 경로
+  * @return 실패 시 NULL*/
+FAS_TRANSPORT *FAS_GatewayOpen(const char *path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "gateway path too long: %s\n", path);
+        return NULL;
+    }
+    strcpy(addr.sun_path, path);
+
+    FAS_TRANSPORT *tp = FAS_PoolAlloc(&FAS_GatewayPool);
+    if (tp == NULL) {
+        return NULL;
+    }
+    tp->ops = &gateway_ops;
+    if ((tp->fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0)) < 0) {
+        perror("Socket creation failed");
+        FAS_PoolFree(&FAS_GatewayPool, tp);
+        return NULL;
+    }
+    if (connect(tp->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("Gateway connection failed");
+        gateway_close(tp);
+        return NULL;
+    }
+    return tp;
+}
@@ -0,0 +1,330 @@
+/**
+ * @file FAS_Homing.c
+ * @brief 여러 축의 원점복귀를 그룹과 순서 조건에 따라 동시에 진행
+ * @details 한 주기(HOMING_POLL_MS)마다 시작할 수 있는 그룹의 0x33을 모두 모아 한 번에 보내고,
+ * 진행 중인 모든 축의 0x40도 한 번에 읽는다. 같은 transport의 축은 FAS_TransactBatch가 이어서 처리한다.
+ */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FAS_Homing.h"
+#include "MOTION_EziSERVO2_DEFINE.h"
+
+#define HOMING_POLL_MS 20
+#define HOMING_START_MS 100 //0x33을 보낸 뒤 이 시간 안에 FFLAG_ORIGINRETURNING이 안 보이면 상태값만으로 판단
+
+ /**@brief "이름=축,축[ after 그룹,그룹]; ..." 형식의 계획을 읽음
+  * @details 예) "Z=2; XY=0,1 after Z; T=3" 축은 보드 ID, 그룹 순서는 자유 (뒤에 나오는 그룹을 after에 써도 됨)
+  * @return 형식이 틀렸으면 FALSE (원인은 stderr)*/
+bool FAS_HomingParse(FAS_HOMING_PLAN *plan, const char *text) {
+    char after_names[FAS_HOMING_MAX_GROUPS][128];
+    char *copy = strdup(text);
+    char *saveptr;
+    bool ok = true;
+
+    memset(plan, 0, sizeof(*plan));
+    if (copy == NULL) {
+        return false;
+    }
+    for (char *item = strtok_r(copy, ";", &saveptr); item != NULL && ok; item = strtok_r(NULL, ";", &saveptr)) {
+        item = FAS_Trim(item);
+        if (*item == '\0') {
+            continue;
+        }
+        char *equal = strchr(item, '=');
+        if (equal == NULL || plan->count >= FAS_HOMING_MAX_GROUPS) {
+            fprintf(stderr, "homing plan: bad group \"%s\"\n", item);
+            ok = false;
+            break;
+        }
+        FAS_HOMING_GROUP *group = &plan->groups[plan->count];
+        *equal = '\0';
+        snprintf(group->name, sizeof(group->name), "%s", FAS_Trim(item));
+        group->timeout_ms = FAS_HOMING_TIMEOUT_MS;
+
+        char *axes = equal + 1;
+        char *after = strstr(axes, "after");
+        after_names[plan->count][0] = '\0';
+        if (after != NULL) {
+            *after = '\0';
+            snprintf(after_names[plan->count], sizeof(after_names[0]), "%s", after + strlen("after"));
+        }
+        char *end;
+        for (char *p = axes; ok; p = end + 1) {
+            long axis = strtol(p, &end, 10);
+            if (end == p || axis < 0 || axis >= FAS_MAX_BOARD || group->axis_count >= FAS_MAX_BOARD) {
+                fprintf(stderr, "homing plan: bad axis list in group %s\n", group->name);
+                ok = false;
+                break;
+            }
+            group->axes[group->axis_count++] = (int)axis;
+            while (isspace((unsigned char)*end)) {
+                end++;
+            }
+            if (*end != ',') {
+                break;
+            }
+        }
+        if (ok && *end != '\0') {
+            fprintf(stderr, "homing plan: unexpected \"%s\" in group %s\n", end, group->name);
+            ok = false;
+        }
+        plan->count++;
+    }
+
+    // after에 쓴 이름을 그룹 번호로 바꿈
+    for (int g = 0; g < plan->count && ok; g++) {
+        char *names = after_names[g];
+        for (char *name = strtok_r(names, ",", &saveptr); name != NULL && ok; name = strtok_r(NULL, ",", &saveptr)) {
+            name = FAS_Trim(name);
+            int d = 0;
+            while (d < plan->count && strcmp(plan->groups[d].name, name) != 0) {
+                d++;
+            }
+            if (d == plan->count || d == g) {
+                fprintf(stderr, "homing plan: group %s waits for unknown group \"%s\"\n", plan->groups[g].name, name);
+                ok = false;
+                break;
+            }
+            plan->groups[g].after |= 1u << d;
+        }
+    }
+    free(copy);
+    return ok && plan->count > 0;
+}
+
+ /**@brief 그룹 실패 처리, 실패한 축과 아직 끝나지 않은 그룹의 축을 모두 멈춤
+  * @details 0x33 응답이 없어 실패한 축도 원점 센서 쪽으로 움직이고 있을 수 있으므로 같이 멈춘다.*/
+static void fail_group(const FAS_HOMING_GROUP *group, FAS_HOMING_GROUP_RESULT *result, const bool *done,
+                       int axis, int code, DWORD status, int64_t now) {
+    FAS_REQUEST stops[FAS_MAX_BOARD];
+    int count = 0;
+
+    for (int k = 0; k < group->axis_count; k++) {
+        if (!done[k] || group->axes[k] == axis) {
+            stops[count++] = (FAS_REQUEST){ .iBdID = group->axes[k], .frame_type = 0x31 };
+        }
+    }
+    FAS_TransactBatch(stops, count);
+    result->state = FAS_HOMING_FAILED;
+    result->end_us = now;
+    result->failed_axis = axis;
+    result->result = code;
+    result->status = status;
+}
+
+ /**@brief 계획대로 원점복귀를 진행하고 끝날 때까지 기다림
+  * @param volatile bool *stop TRUE가 되면 진행 중인 축을 모두 멈추고 끝냄 (NULL 가능)
+  * @return 모든 그룹이 완료되었으면 TRUE*/
+bool FAS_HomingRun(const FAS_HOMING_PLAN *plan, volatile bool *stop, FAS_HOMING_REPORT *report) {
+    bool returning_seen[FAS_HOMING_MAX_GROUPS][FAS_MAX_BOARD] = { { false } };
+    bool done[FAS_HOMING_MAX_GROUPS][FAS_MAX_BOARD] = { { false } };
+    int64_t done_us[FAS_HOMING_MAX_GROUPS][FAS_MAX_BOARD]; //축별 완료 시각
+    int64_t start = FAS_NowUs();
+    int64_t next = start;
+
+    memset(report, 0, sizeof(*report));
+    for (int g = 0; g < plan->count; g++) {
+        report->groups[g].state = FAS_HOMING_WAITING;
+        report->groups[g].failed_axis = -1;
+    }
+
+    while (1) {
+        FAS_REQUEST requests[FAS_HOMING_MAX_GROUPS * FAS_MAX_BOARD];
+        BYTE replies[FAS_HOMING_MAX_GROUPS * FAS_MAX_BOARD][16];
+        int owner[FAS_HOMING_MAX_GROUPS * FAS_MAX_BOARD][2]; //요청별 (그룹, 그룹 안의 축 번호)
+        int count = 0;
+        int64_t now = FAS_NowUs() - start;
+
+        // 선행 그룹이 모두 끝난 그룹을 한꺼번에 시작
+        for (int g = 0; g < plan->count; g++) {
+            FAS_HOMING_GROUP_RESULT *r = &report->groups[g];
+            if (r->state != FAS_HOMING_WAITING) {
+                continue;
+            }
+            bool ready = true, blocked = false;
+            for (int d = 0; d < plan->count; d++) {
+                if (plan->groups[g].after & (1u << d)) {
+                    ready &= report->groups[d].state == FAS_HOMING_DONE;
+                    blocked |= report->groups[d].state == FAS_HOMING_FAILED || report->groups[d].state == FAS_HOMING_SKIPPED;
+                }
+            }
+            if (blocked) {
+                r->state = FAS_HOMING_SKIPPED;
+            }
+            else if (ready) {
+                r->state = FAS_HOMING_RUNNING;
+                r->start_us = now;
+                for (int k = 0; k < plan->groups[g].axis_count; k++, count++) {
+                    requests[count] = (FAS_REQUEST){ .iBdID = plan->groups[g].axes[k], .frame_type = 0x33 };
+                    owner[count][0] = g;
+                    owner[count][1] = k;
+                }
+            }
+        }
+        FAS_TransactBatch(requests, count);
+        now = FAS_NowUs() - start;
+        for (int i = 0; i < count; i++) {
+            int g = owner[i][0];
+            if (requests[i].result != FMM_OK && report->groups[g].state == FAS_HOMING_RUNNING) {
+                fail_group(&plan->groups[g], &report->groups[g], done[g], requests[i].iBdID, requests[i].result, 0, now);
+            }
+        }
+
+        if (stop != NULL && *stop) {
+            for (int g = 0; g < plan->count; g++) {
+                if (report->groups[g].state == FAS_HOMING_RUNNING) {
+                    fail_group(&plan->groups[g], &report->groups[g], done[g], -1, FMM_OK, 0, now);
+                }
+            }
+            report->stopped = true;
+            break;
+        }
+
+        // 진행 중인 축의 상태를 한꺼번에 읽음
+        count = 0;
+        for (int g = 0; g < plan->count; g++) {
+            if (report->groups[g].state != FAS_HOMING_RUNNING) {
+                continue;
+            }
+            for (int k = 0; k < plan->groups[g].axis_count; k++) {
+                if (!done[g][k]) {
+                    requests[count] = (FAS_REQUEST){ .iBdID = plan->groups[g].axes[k], .frame_type = 0x40,
+                                                     .reply = replies[count], .reply_size = sizeof(replies[count]) };
+                    owner[count][0] = g;
+                    owner[count][1] = k;
+                    count++;
+                }
+            }
+        }
+        FAS_TransactBatch(requests, count);
+        now = FAS_NowUs() - start;
+        for (int i = 0; i < count; i++) {
+            int g = owner[i][0], k = owner[i][1];
+            FAS_HOMING_GROUP_RESULT *r = &report->groups[g];
+            if (r->state != FAS_HOMING_RUNNING) {
+                continue; //같은 그룹의 다른 축이 먼저 실패함
+            }
+            if (requests[i].result != FMM_OK || requests[i].reply_bytes < 10) {
+                fail_group(&plan->groups[g], r, done[g], requests[i].iBdID, requests[i].result != FMM_OK ? requests[i].result : FMC_RECVPACKET_ERROR, 0, now);
+                continue;
+            }
+            EZISERVO2_AXISSTATUS status;
+            status.dwValue = replies[i][6] | (DWORD)replies[i][7] << 8 | (DWORD)replies[i][8] << 16 | (DWORD)replies[i][9] << 24;
+            bool settled = returning_seen[g][k] || now - r->start_us >= HOMING_START_MS * 1000;
+            returning_seen[g][k] |= status.FFLAG_ORIGINRETURNING;
+
+            if (status.FFLAG_ERRORALL || status.FFLAG_EMGSTOP) {
+                fail_group(&plan->groups[g], r, done[g], requests[i].iBdID, FMM_OK, status.dwValue, now);
+            }
+            else if (!status.FFLAG_ORIGINRETURNING && settled) {
+                if (status.FFLAG_ORIGINRETOK) {
+                    done[g][k] = true;
+                    done_us[g][k] = now;
+                }
+                else { //원점을 못 찾고 멈춤
+                    fail_group(&plan->groups[g], r, done[g], requests[i].iBdID, FMM_OK, status.dwValue, now);
+                }
+            }
+        }
+
+        // 그룹 완료/timeout
+        bool running = false;
+        for (int g = 0; g < plan->count; g++) {
+            FAS_HOMING_GROUP_RESULT *r = &report->groups[g];
+            if (r->state == FAS_HOMING_RUNNING) {
+                int k = 0;
+                while (k < plan->groups[g].axis_count && done[g][k]) {
+                    k++;
+                }
+                if (k == plan->groups[g].axis_count) {
+                    r->state = FAS_HOMING_DONE;
+                    r->end_us = now;
+                }
+                else if (now - r->start_us > (int64_t)plan->groups[g].timeout_ms * 1000) {
+                    fail_group(&plan->groups[g], r, done[g], plan->groups[g].axes[k], FMC_TIMEOUT_ERROR, 0, now);
+                }
+            }
+            running |= r->state == FAS_HOMING_RUNNING;
+        }
+        if (!running) {
+            // 진행 중인 그룹이 없으면 선행 그룹이 모두 끝난(성공/실패) 대기 그룹이 있을 때만 계속, 없으면 끝났거나 순환
+            bool startable = false;
+            for (int g = 0; g < plan->count; g++) {
+                if (report->groups[g].state != FAS_HOMING_WAITING) {
+                    continue;
+                }
+                bool pending = false;
+                for (int d = 0; d < plan->count; d++) {
+                    pending |= (plan->groups[g].after & (1u << d)) && report->groups[d].state == FAS_HOMING_WAITING;
+                }
+                startable |= !pending;
+            }
+            if (!startable) {
+                break;
+            }
+            continue;
+        }
+        next += HOMING_POLL_MS * 1000;
+        if (next < FAS_NowUs()) {
+            next = FAS_NowUs();
+        }
+        FAS_SleepUntilUs(next);
+    }
+
+    report->ok = true;
+    for (int g = 0; g < plan->count; g++) {
+        FAS_HOMING_GROUP_RESULT *r = &report->groups[g];
+        if (r->state == FAS_HOMING_WAITING) { //순서 조건이 순환해서 시작할 수 없음
+            r->state = FAS_HOMING_SKIPPED;
+        }
+        if (r->state != FAS_HOMING_DONE) {
+            report->ok = false;
+        }
+        for (int k = 0; k < plan->groups[g].axis_count; k++) {
+            if (done[g][k]) {
+                report->serial_us += done_us[g][k] - r->start_us;
+            }
+        }
+    }
+    report->wall_us = FAS_NowUs() - start;
+    return report->ok;
+}
+
+ /**@brief 그룹별 결과와 전체 시간 출력*/
+void FAS_HomingPrint(FILE *out, const FAS_HOMING_PLAN *plan, const FAS_HOMING_REPORT *report) {
+    static const char *states[] = { "WAITING", "RUNNING", "DONE", "FAILED", "SKIPPED" };
+
+    fprintf(out, "%-16s %-20s %-8s %9s %9s %9s  %s\n", "GROUP", "AXES", "STATE", "START(ms)", "END(ms)", "TIME(ms)", "CAUSE");
+    for (int g = 0; g < plan->count; g++) {
+        const FAS_HOMING_GROUP *group = &plan->groups[g];
+        const FAS_HOMING_GROUP_RESULT *r = &report->groups[g];
+        char axes[64] = "";
+        for (int k = 0; k < group->axis_count; k++) {
+            size_t length = strlen(axes);
+            snprintf(axes + length, sizeof(axes) - length, k ? ",%d" : "%d", group->axes[k]);
+        }
+        fprintf(out, "%-16s %-20s %-8s", group->name, axes, states[r->state]);
+        if (r->state == FAS_HOMING_DONE || r->state == FAS_HOMING_FAILED) {
+            fprintf(out, " %9.1f %9.1f %9.1f", r->start_us / 1e3, r->end_us / 1e3, (r->end_us - r->start_us) / 1e3);
+        }
+        else {
+            fprintf(out, " %9s %9s %9s", "-", "-", "-");
+        }
+        if (r->state == FAS_HOMING_FAILED) {
+            if (r->failed_axis < 0) {
+                fprintf(out, "  stopped");
+            }
+            else if (r->result != FMM_OK) {
+                fprintf(out, "  axis %d error 0x%02X", r->failed_axis, r->result);
+            }
+            else {
+                fprintf(out, "  axis %d status 0x%08X", r->failed_axis, r->status);
+            }
+        }
+        fprintf(out, "\n");
+    }
+    fprintf(out, "wall %.1f ms, one axis at a time %.1f ms, parallel gain %.2fx%s\n", report->wall_us / 1e3, report->serial_us / 1e3,
+            report->wall_us > 0 ? (double)report->serial_us / report->wall_us : 0.0, report->ok ? "" : " (incomplete)");
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+/**
+ * @file FAS_Homing.h
+ * @brief 여러 축의 원점복귀(0x33)를 그룹과 순서 조건에 따라 동시에 진행
+ * @details 계획은 축 그룹과 그룹 사이의 선행 조건으로 이루어진다. 예) "Z=2; XY=0,1 after Z; T=3"
+ * 선행 그룹이 모두 끝난 그룹은 한꺼번에 원점복귀를 시작하고, 진행 중인 축의 상태(0x40)를 주기적으로 읽어
+ * FFLAG_ORIGINRETURNING이 꺼지고 FFLAG_ORIGINRETOK이 켜지면 완료로 본다.
+ * 그룹 안의 한 축이라도 실패(알람, 응답 없음, timeout)하면 그 그룹의 나머지 축을 멈추고 실패로 처리하며,
+ * 그 그룹에 의존하는 그룹은 건너뛴다. 다른 그룹은 계속 진행한다.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "FAS_Library.h"
+
+#define FAS_HOMING_MAX_GROUPS 16
+#define FAS_HOMING_NAME_SIZE 16
+#define FAS_HOMING_TIMEOUT_MS 30000 //그룹 timeout 기본값
+
+typedef struct
+{
+    char name[FAS_HOMING_NAME_SIZE];
+    int axes[FAS_MAX_BOARD];
+    int axis_count;
+    DWORD after;      //먼저 끝나야 하는 그룹 (bit i = groups[i])
+    int timeout_ms;   //그룹이 시작한 뒤 이 시간 안에 끝나지 않으면 실패
+} FAS_HOMING_GROUP;
+
+typedef struct
+{
+    FAS_HOMING_GROUP groups[FAS_HOMING_MAX_GROUPS];
+    int count;
+} FAS_HOMING_PLAN;
+
+typedef enum
+{
+    FAS_HOMING_WAITING,
+    FAS_HOMING_RUNNING,
+    FAS_HOMING_DONE,
+    FAS_HOMING_FAILED,
+    FAS_HOMING_SKIPPED,   //선행 그룹이 실패했거나 순서 조건이 순환함
+} FAS_HOMING_STATE;
+
+ /**@brief 그룹 하나의 결과*/
+typedef struct
+{
+    FAS_HOMING_STATE state;
+    int64_t start_us;     //원점복귀 시작 시각 (FAS_HomingRun 시작 기준)
+    int64_t end_us;
+    int failed_axis;      //실패한 축의 보드 ID, 없으면 -1
+    int result;           //실패 원인: 요청의 FMM_ERROR, FMC_TIMEOUT_ERROR, 알람이면 FMM_OK이고 status에 상태값
+    DWORD status;         //실패 시점의 축 상태
+} FAS_HOMING_GROUP_RESULT;
+
+typedef struct
+{
+    FAS_HOMING_GROUP_RESULT groups[FAS_HOMING_MAX_GROUPS];
+    int64_t wall_us;      //전체 걸린 시간
+    int64_t serial_us;    //완료된 축을 하나씩 차례로 원점복귀했다면 걸렸을 시간 (축별 시간의 합)
+    bool ok;              //모든 그룹이 완료됨
+    bool stopped;         //stop 요청으로 중단됨
+} FAS_HOMING_REPORT;
+
+bool FAS_HomingParse(FAS_HOMING_PLAN *plan, const char *text);
+bool FAS_HomingRun(const FAS_HOMING_PLAN *plan, volatile bool *stop, FAS_HOMING_REPORT *report);
+void FAS_HomingPrint(FILE *out, const FAS_HOMING_PLAN *plan, const FAS_HOMING_REPORT *report);
@@ -0,0 +1,390 @@
+/**
+ * @file FAS_Inventory.c
+ * @brief 드라이브 정보 캐시 파일 읽기/쓰기와 백그라운드 재확인
+ * @details 재확인은 스레드 하나가 transport별 작업 스레드를 띄우고 모두 끝나면 파일을 저장한다.
+ * 드라이브 하나의 요청(정보 3개 + 파라미터 전체)은 FAS_INVENTORY_CHUNK개씩 FAS_TransactBatch로 보내므로
+ * io_uring이나 RS-485 transport에서는 묶음 안의 요청이 대기 없이 이어서 처리되고, 묶음 사이에는 사용자 요청이 끼어든다.
+ */
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "FAS_Inventory.h"
+#include "MOTION_EziSERVO2_DEFINE.h"
+
+#define INVENTORY_HEADER "# FAS inventory v1"
+
+static FAS_INVENTORY entries[FAS_INVENTORY_MAX];
+static int entry_count;
+static char inventory_path[256];
+static pthread_mutex_t inventory_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t inventory_done = PTHREAD_COND_INITIALIZER;
+static bool revalidating;
+static bool dirty;
+static FAS_INVENTORY_LOCK board_lock;  //재확인 중에만 바뀌지 않음
+static void *board_lock_user;
+
+ /**@brief 같은 transport를 쓰는 보드 묶음, 작업 스레드 하나가 차례로 확인함*/
+typedef struct
+{
+    char key[FAS_ADDRESS_SIZE];
+    int boards[FAS_MAX_BOARD];
+    int count;
+    pthread_t thread;
+} INVENTORY_GROUP;
+
+static FAS_INVENTORY *find_entry(const char *address) {
+    for (int i = 0; i < entry_count; i++) {
+        if (strcmp(entries[i].address, address) == 0) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+ /**@brief 새 항목 추가, 가득 찼으면 가장 오래전에 확인한 항목을 덮어씀*/
+static FAS_INVENTORY *add_entry(const char *address) {
+    FAS_INVENTORY *entry = &entries[0];
+    if (entry_count < FAS_INVENTORY_MAX) {
+        entry = &entries[entry_count++];
+    }
+    else {
+        for (int i = 1; i < FAS_INVENTORY_MAX; i++) {
+            if (entries[i].validated < entry->validated) {
+                entry = &entries[i];
+            }
+        }
+    }
+    memset(entry, 0, sizeof(*entry));
+    snprintf(entry->address, sizeof(entry->address), "%s", address);
+    return entry;
+}
+
+ /**@brief 응답의 [type][문자열...]에서 문자열을 꺼냄, 탭/줄바꿈 등 파일에 쓸 수 없는 문자는 '?'로 바꿈*/
+static BYTE copy_name(char *name, const BYTE *reply, int reply_bytes) {
+    int length = 0;
+    for (int i = 7; i < reply_bytes && length < FAS_INVENTORY_NAME_SIZE - 1 && reply[i] != '\0'; i++) {
+        name[length++] = isprint(reply[i]) ? reply[i] : '?';
+    }
+    name[length] = '\0';
+    return reply_bytes > 6 ? reply[6] : 0;
+}
+
+ /**@brief 요청을 FAS_INVENTORY_CHUNK개씩 보드를 잡고 보냄, 묶음 사이에는 다른 요청이 끼어들 수 있음
+  * @return 응답을 받은 요청 수*/
+static int transact_chunked(int iBdID, FAS_REQUEST *requests, int count) {
+    int answered = 0;
+    for (int done = 0; done < count; done += FAS_INVENTORY_CHUNK) {
+        int chunk = count - done < FAS_INVENTORY_CHUNK ? count - done : FAS_INVENTORY_CHUNK;
+        if (board_lock != NULL) {
+            board_lock(iBdID, true, board_lock_user);
+        }
+        answered += FAS_TransactBatch(&requests[done], chunk);
+        if (board_lock != NULL) {
+            board_lock(iBdID, false, board_lock_user);
+        }
+    }
+    return answered;
+}
+
+ /**@brief 드라이브에 정보와 파라미터를 물어봄
+  * @return 모든 요청에 응답을 받았으면 TRUE*/
+static bool query_board(int iBdID, FAS_INVENTORY *info) {
+    static const BYTE info_types[3] = { 0x01, 0x05, 0x07 }; //보드, 모터, 펌웨어
+    FAS_REQUEST requests[3 + MAX_SERVO2_PARAM];
+    BYTE replies[3 + MAX_SERVO2_PARAM][BUFFER_SIZE];
+    BYTE param_no[MAX_SERVO2_PARAM];
+    int count = 0;
+
+    // 꺼진 드라이브에 요청을 다 보내면 요청마다 timeout을 기다리므로 보드 정보로 먼저 응답하는지 확인
+    requests[0] = (FAS_REQUEST){ .iBdID = iBdID, .frame_type = info_types[0], .reply = replies[0], .reply_size = sizeof(replies[0]) };
+    if (transact_chunked(iBdID, requests, 1) != 1) {
+        return false;
+    }
+    for (count = 1; count < 3; count++) {
+        requests[count] = (FAS_REQUEST){ .iBdID = iBdID, .frame_type = info_types[count], .reply = replies[count], .reply_size = sizeof(replies[count]) };
+    }
+    for (int i = 0; i < MAX_SERVO2_PARAM; i++, count++) {
+        param_no[i] = i;
+        requests[count] = (FAS_REQUEST){ .iBdID = iBdID, .frame_type = 0x13, .data = &param_no[i], .data_size = 1,
+                                         .reply = replies[count], .reply_size = sizeof(replies[count]) };
+    }
+    if (transact_chunked(iBdID, &requests[1], count - 1) != count - 1) {
+        return false;
+    }
+
+    info->board_type = copy_name(info->board_name, replies[0], requests[0].reply_bytes);
+    info->motor_type = copy_name(info->motor_name, replies[1], requests[1].reply_bytes);
+    copy_name(info->firmware, replies[2], requests[2].reply_bytes);
+
+    DWORD hash = 2166136261u; //FNV-1a
+    for (int i = 3; i < count; i++) {
+        if (requests[i].reply_bytes < 10) {
+            return false;
+        }
+        for (int j = 6; j < 10; j++) {
+            hash = (hash ^ replies[i][j]) * 16777619u;
+        }
+    }
+    info->param_checksum = hash;
+    return true;
+}
+
+static bool same_inventory(const FAS_INVENTORY *a, const FAS_INVENTORY *b) {
+    return a->board_type == b->board_type && a->motor_type == b->motor_type && a->param_checksum == b->param_checksum
+        && strcmp(a->board_name, b->board_name) == 0 && strcmp(a->motor_name, b->motor_name) == 0
+        && strcmp(a->firmware, b->firmware) == 0;
+}
+
+static void *group_thread(void *arg) {
+    INVENTORY_GROUP *group = arg;
+
+    for (int i = 0; i < group->count; i++) {
+        int iBdID = group->boards[i];
+        const char *address = FAS_BoardAddress(iBdID);
+        if (address == NULL) {
+            continue;
+        }
+        FAS_INVENTORY fresh = { 0 };
+        bool answered = query_board(iBdID, &fresh);
+
+        pthread_mutex_lock(&inventory_lock);
+        FAS_INVENTORY *entry = find_entry(address);
+        if (!answered) {
+            if (entry != NULL) {
+                entry->state = FAS_INVENTORY_OFFLINE;
+            }
+        }
+        else {
+            FAS_INVENTORY_STATE state = FAS_INVENTORY_VALID;
+            if (entry == NULL) {
+                entry = add_entry(address);
+            }
+            else if (!same_inventory(entry, &fresh)) {
+                state = FAS_INVENTORY_CHANGED;
+            }
+            snprintf(fresh.address, sizeof(fresh.address), "%s", address);
+            fresh.validated = time(NULL);
+            fresh.state = state;
+            *entry = fresh;
+            dirty = true;
+        }
+        pthread_mutex_unlock(&inventory_lock);
+    }
+    return NULL;
+}
+
+ /**@brief 연결된 보드를 transport별로 나눠 동시에 확인하고 파일에 저장*/
+static void *revalidate_thread(void *arg) {
+    INVENTORY_GROUP groups[FAS_MAX_BOARD];
+    int group_count = 0;
+
+    for (int iBdID = 0; iBdID < FAS_MAX_BOARD; iBdID++) {
+        const char *address = FAS_BoardAddress(iBdID);
+        if (address == NULL) {
+            continue;
+        }
+        char key[FAS_ADDRESS_SIZE];
+        snprintf(key, sizeof(key), "%s", address);
+        char *mark = strchr(key, '#'); //RS-485는 '#' 앞의 포트가 같으면 같은 버스
+        if (mark != NULL) {
+            *mark = '\0';
+        }
+        int g = 0;
+        while (g < group_count && strcmp(groups[g].key, key) != 0) {
+            g++;
+        }
+        if (g == group_count) {
+            snprintf(groups[g].key, sizeof(groups[g].key), "%s", key);
+            groups[g].count = 0;
+            group_count++;
+        }
+        groups[g].boards[groups[g].count++] = iBdID;
+    }
+
+    bool started[FAS_MAX_BOARD] = { false };
+    for (int g = 0; g < group_count; g++) {
+        started[g] = pthread_create(&groups[g].thread, NULL, group_thread, &groups[g]) == 0;
+        if (!started[g]) {
+            group_thread(&groups[g]);
+        }
+    }
+    for (int g = 0; g < group_count; g++) {
+        if (started[g]) {
+            pthread_join(groups[g].thread, NULL);
+        }
+    }
+
+    FAS_InventorySave();
+    pthread_mutex_lock(&inventory_lock);
+    revalidating = false;
+    pthread_cond_broadcast(&inventory_done);
+    pthread_mutex_unlock(&inventory_lock);
+    return NULL;
+}
+
+ /**@brief 캐시 파일을 읽음, 파일이 없으면 빈 캐시로 시작 (저장할 때 만듦)
+  * @param const char *path 캐시 파일 경로
+  * @return 읽은 드라이브 수, 재확인 중이면 -1*/
+int FAS_InventoryLoad(const char *path) {
+    pthread_mutex_lock(&inventory_lock);
+    if (revalidating) {
+        pthread_mutex_unlock(&inventory_lock);
+        return -1;
+    }
+    snprintf(inventory_path, sizeof(inventory_path), "%s", path);
+    entry_count = 0;
+    dirty = false;
+
+    FILE *fp = fopen(path, "r");
+    if (fp != NULL) {
+        char line[512];
+        while (fgets(line, sizeof(line), fp) != NULL && entry_count < FAS_INVENTORY_MAX) {
+            if (line[0] == '#' || line[0] == '\n') {
+                continue;
+            }
+            // address, board type, board name, motor type, motor name, firmware, checksum, validated
+            char *field[8];
+            char *cursor = line;
+            int fields = 0;
+            while (fields < 8 && cursor != NULL) {
+                field[fields++] = cursor;
+                cursor = strchr(cursor, '\t');
+                if (cursor != NULL) {
+                    *cursor++ = '\0';
+                }
+            }
+            if (fields != 8) {
+                continue;
+            }
+            field[7][strcspn(field[7], "\r\n")] = '\0';
+            FAS_INVENTORY *entry = add_entry(field[0]);
+            entry->board_type = atoi(field[1]);
+            snprintf(entry->board_name, sizeof(entry->board_name), "%s", field[2]);
+            entry->motor_type = atoi(field[3]);
+            snprintf(entry->motor_name, sizeof(entry->motor_name), "%s", field[4]);
+            snprintf(entry->firmware, sizeof(entry->firmware), "%s", field[5]);
+            entry->param_checksum = strtoul(field[6], NULL, 16);
+            entry->validated = atoll(field[7]);
+            entry->state = FAS_INVENTORY_CACHED;
+        }
+        fclose(fp);
+    }
+    int count = entry_count;
+    pthread_mutex_unlock(&inventory_lock);
+    return count;
+}
+
+ /**@brief 보드의 정보를 돌려줌, 재확인 전이면 파일의 정보(CACHED)
+  * @param int iBdID 드라이브 ID
+  * @param FAS_INVENTORY *info 정보를 받을 구조체
+  * @return 알고 있는 정보가 없으면 FALSE (info->state는 FAS_INVENTORY_UNKNOWN)*/
+bool FAS_InventoryGet(int iBdID, FAS_INVENTORY *info) {
+    const char *address = FAS_BoardAddress(iBdID);
+
+    memset(info, 0, sizeof(*info));
+    if (address == NULL) {
+        return false;
+    }
+    pthread_mutex_lock(&inventory_lock);
+    FAS_INVENTORY *entry = find_entry(address);
+    if (entry != NULL) {
+        *info = *entry;
+    }
+    else {
+        snprintf(info->address, sizeof(info->address), "%s", address);
+    }
+    pthread_mutex_unlock(&inventory_lock);
+    return entry != NULL;
+}
+
+ /**@brief 연결된 모든 보드를 백그라운드에서 다시 확인, 끝나면 파일을 저장함
+  * @param FAS_INVENTORY_LOCK lock 요청 묶음마다 보드를 잡고 놓는 함수, NULL이면 잡지 않음 (그동안 다른 요청을 보내지 않을 때)
+  * @return 이미 확인 중이면 FALSE*/
+bool FAS_InventoryRevalidate(FAS_INVENTORY_LOCK lock, void *user) {
+    pthread_t thread;
+
+    pthread_mutex_lock(&inventory_lock);
+    if (revalidating) {
+        pthread_mutex_unlock(&inventory_lock);
+        return false;
+    }
+    revalidating = true;
+    board_lock = lock;
+    board_lock_user = user;
+    pthread_mutex_unlock(&inventory_lock);
+
+    if (pthread_create(&thread, NULL, revalidate_thread, NULL) != 0) {
+        revalidate_thread(NULL);
+        return true;
+    }
+    pthread_detach(thread);
+    return true;
+}
+
+ /**@brief 재확인이 끝날 때까지 기다림
+  * @param int timeout_ms 0이면 기다리지 않고 상태만 확인
+  * @return 재확인 중이 아니면 TRUE*/
+bool FAS_InventoryWait(int timeout_ms) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&inventory_lock);
+    while (revalidating && timeout_ms > 0) {
+        if (pthread_cond_timedwait(&inventory_done, &inventory_lock, &deadline) != 0) {
+            break;
+        }
+    }
+    bool done = !revalidating;
+    pthread_mutex_unlock(&inventory_lock);
+    return done;
+}
+
+ /**@brief 바뀐 내용이 있으면 캐시 파일을 다시 씀, 임시 파일에 쓴 뒤 rename 하므로 도중에 꺼져도 이전 파일이 남음
+  * @return 실패 시 FALSE*/
+bool FAS_InventorySave(void) {
+    char temp[sizeof(inventory_path) + 8];
+    bool saved = true;
+
+    pthread_mutex_lock(&inventory_lock);
+    if (!dirty || inventory_path[0] == '\0') {
+        pthread_mutex_unlock(&inventory_lock);
+        return true;
+    }
+    snprintf(temp, sizeof(temp), "%s.tmp", inventory_path);
+    FILE *fp = fopen(temp, "w");
+    if (fp == NULL) {
+        perror("inventory save failed");
+        pthread_mutex_unlock(&inventory_lock);
+        return false;
+    }
+    fprintf(fp, "%s\n", INVENTORY_HEADER);
+    for (int i = 0; i < entry_count; i++) {
+        const FAS_INVENTORY *e = &entries[i];
+        fprintf(fp, "%s\t%u\t%s\t%u\t%s\t%s\t%08X\t%lld\n", e->address, e->board_type, e->board_name,
+                e->motor_type, e->motor_name, e->firmware, e->param_checksum, (long long)e->validated);
+    }
+    if (fflush(fp) != 0 || fsync(fileno(fp)) != 0) {
+        saved = false;
+    }
+    if (fclose(fp) != 0 || !saved || rename(temp, inventory_path) != 0) {
+        perror("inventory save failed");
+        unlink(temp);
+        saved = false;
+    }
+    if (saved) {
+        dirty = false;
+    }
+    pthread_mutex_unlock(&inventory_lock);
+    return saved;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+/**
+ * @file FAS_Inventory.h
+ * @brief 드라이브별 보드/모터/펌웨어 정보와 파라미터 체크섬을 파일에 저장해 두고 시작할 때 바로 쓰는 캐시
+ * @details 시작하면 FAS_InventoryLoad로 지난번 정보를 읽어 FAS_InventoryGet이 곧바로 돌려주고(CACHED),
+ * 연결 후 FAS_InventoryRevalidate가 뒤에서 실제 드라이브에 다시 물어본다 (0x01, 0x05, 0x07, 파라미터 전체 0x13).
+ * transport가 다른 보드는 스레드를 나눠 동시에 확인하고, 같은 RS-485 버스의 보드는 한 스레드가 차례로 확인한다.
+ * 확인이 끝나면 바뀐 내용을 파일에 다시 쓴다.
+ * 파일은 한 줄에 드라이브 하나인 탭 구분 텍스트이며, 키는 FAS_BoardAddress이다.
+ * 재확인은 FAS_INVENTORY_CHUNK개씩 나눠 보내며, 묶음마다 FAS_INVENTORY_LOCK으로 그 보드를 잡으므로
+ * 같은 잠금을 쓰는 사용자 요청은 재확인이 끝나기를 기다리지 않고 묶음 사이에 끼어 나간다.
+ * 확인하는 동안에는 해당 보드를 FAS_Close 하지 않는다.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "FAS_Library.h"
+
+#define FAS_INVENTORY_MAX 64       //파일에 기억하는 최대 드라이브 수
+#define FAS_INVENTORY_NAME_SIZE 48
+#define FAS_INVENTORY_CHUNK 8      //재확인에서 잠금 한 번에 보내는 요청 수
+
+typedef enum
+{
+    FAS_INVENTORY_UNKNOWN,  //파일에도 없고 아직 확인하지 않음
+    FAS_INVENTORY_CACHED,   //파일의 정보, 아직 확인하지 않음
+    FAS_INVENTORY_VALID,    //확인 결과 파일과 같음 (또는 새로 추가됨)
+    FAS_INVENTORY_CHANGED,  //확인 결과 파일과 달라서 새 정보로 바꿈
+    FAS_INVENTORY_OFFLINE,  //확인할 때 응답이 없음, 파일의 정보를 그대로 둠
+} FAS_INVENTORY_STATE;
+
+typedef struct
+{
+    char address[FAS_ADDRESS_SIZE];
+    BYTE board_type;
+    char board_name[FAS_INVENTORY_NAME_SIZE];
+    BYTE motor_type;
+    char motor_name[FAS_INVENTORY_NAME_SIZE];
+    char firmware[FAS_INVENTORY_NAME_SIZE];
+    DWORD param_checksum;  //파라미터 0 ~ MAX_SERVO2_PARAM-1 값의 FNV-1a
+    int64_t validated;     //마지막으로 드라이브에서 확인한 시각 (unix time, 초)
+    FAS_INVENTORY_STATE state;
+} FAS_INVENTORY;
+
+ /**@brief 재확인이 보드 iBdID로 요청을 보내기 전(lock TRUE)과 후(lock FALSE)에 부름*/
+typedef void (*FAS_INVENTORY_LOCK)(int iBdID, bool lock, void *user);
+
+int FAS_InventoryLoad(const char *path);
+bool FAS_InventoryGet(int iBdID, FAS_INVENTORY *info);
+bool FAS_InventoryRevalidate(FAS_INVENTORY_LOCK lock, void *user);
+bool FAS_InventoryWait(int timeout_ms);
+bool FAS_InventorySave(void);
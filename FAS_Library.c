@@ -0,0 +1,428 @@
+/**
+ * @file FAS_Library.c
+ * @brief 보드별 연결 관리와 요청/응답 처리
+ * @details 보드마다 transport와 sync 번호를 하나씩 가진다. FAS_Transact는 프레임을 만들어 보내고
+ * sync 번호가 같은 응답이 올 때까지 기다리며, 늦게 도착한 이전 응답은 버린다.
+ * 응답마다 보낸 시각과 받은 시각으로 보드별 RTT를 추정하고(FAS_GetRtt), UDP 읽기 요청은 고정 timeout 대신
+ * 그 추정값으로 정한 RTO가 지나면 새 sync 번호로 다시 보낸다. 어느 전송의 응답인지 sync로 알 수 있으므로 재전송한 요청도 RTT 표본으로 쓴다.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FAS_Library.h"
+#include "FAS_Trace.h"
+#include "FAS_Transport.h"
+
+static FAS_TRANSPORT *boards[FAS_MAX_BOARD];
+static BYTE board_sync[FAS_MAX_BOARD];
+static char board_address[FAS_MAX_BOARD][FAS_ADDRESS_SIZE];
+static FAS_RTT board_rtt[FAS_MAX_BOARD];
+static int64_t board_reply_time[FAS_MAX_BOARD];
+static FAS_ETHERNET_BACKEND ethernet_backend = FAS_BACKEND_SOCKET;
+
+static bool attach_board(int iBdID, FAS_TRANSPORT *tp, const char *address) {
+    if (tp == NULL) {
+        return false;
+    }
+    tp->refs++; //같은 포트를 다시 연결하면 tp가 지금 보드의 transport일 수 있으므로 닫기 전에 참조를 잡음
+    if (boards[iBdID] != NULL) {
+        FAS_Close(iBdID);
+    }
+    boards[iBdID] = tp;
+    board_sync[iBdID] = (BYTE)rand();
+    board_rtt[iBdID] = (FAS_RTT){ .rto_us = FAS_TIMEOUT_MS * 1000 };
+    board_reply_time[iBdID] = 0;
+    snprintf(board_address[iBdID], FAS_ADDRESS_SIZE, "%s", address);
+    return true;
+}
+
+static bool connect_ethernet(BYTE sb1, BYTE sb2, BYTE sb3, BYTE sb4, int iBdID, bool tcp) {
+    char SERVER_IP[16]; //최대 길이 가정 "xxx.xxx.xxx.xxx\0"
+    char address[FAS_ADDRESS_SIZE];
+
+    if (iBdID < 0 || iBdID >= FAS_MAX_BOARD) {
+        return false;
+    }
+    snprintf(SERVER_IP, sizeof(SERVER_IP), "%u.%u.%u.%u", sb1, sb2, sb3, sb4);
+    snprintf(address, sizeof(address), "%s:%s", tcp ? "tcp" : "udp", SERVER_IP);
+    if (!tcp && ethernet_backend != FAS_BACKEND_SOCKET) {
+        FAS_TRANSPORT *tp = FAS_UringOpen(SERVER_IP, ethernet_backend == FAS_BACKEND_URING_SQPOLL);
+        if (tp != NULL) {
+            return attach_board(iBdID, tp, address);
+        }
+        fprintf(stderr, "io_uring unavailable, using plain UDP socket\n");
+    }
+    return attach_board(iBdID, FAS_EthernetOpen(SERVER_IP, tcp), address);
+}
+
+ /**@brief 이후 FAS_Connect(UDP)에 쓸 방식 선택, io_uring을 쓸 수 없는 커널이면 연결할 때 일반 소켓으로 바뀜
+  * @param FAS_ETHERNET_BACKEND backend FAS_BACKEND_SOCKET, FAS_BACKEND_URING, FAS_BACKEND_URING_SQPOLL*/
+void FAS_SetEthernetBackend(FAS_ETHERNET_BACKEND backend) {
+    ethernet_backend = backend;
+}
+
+ /**@brief UDP 연결 시 사용
+  * @param BYTE sb1,sb2,sb3,sb4 IPv4주소 입력 시 각 자리
+  * @param int iBdID 드라이브 ID
+  * @return boolean 성공시 TRUE 실패시 FALSE*/
+bool FAS_Connect(BYTE sb1, BYTE sb2, BYTE sb3, BYTE sb4, int iBdID) {
+    return connect_ethernet(sb1, sb2, sb3, sb4, iBdID, false);
+}
+
+ /**@brief TCP 연결 시 사용
+  * @param BYTE sb1,sb2,sb3,sb4 IPv4주소 입력 시 각 자리
+  * @param int iBdID 드라이브 ID
+  * @return boolean 성공시 TRUE 실패시 FALSE*/
+bool FAS_ConnectTCP(BYTE sb1, BYTE sb2, BYTE sb3, BYTE sb4, int iBdID) {
+    return connect_ethernet(sb1, sb2, sb3, sb4, iBdID, true);
+}
+
+ /**@brief RS-485(Plus-R) 연결 시 사용, 같은 포트에 여러 보드를 연결하면 multi-drop 버스를 공유함
+  * @param const char *device 시리얼 장치 경로
+  * @param int baud 9600 ~ 921600
+  * @param int iBdID 드라이브 ID (= Slave ID)
+  * @return boolean 성공시 TRUE 실패시 FALSE*/
+bool FAS_ConnectSerial(const char *device, int baud, int iBdID) {
+    if (iBdID < 0 || iBdID >= FAS_MAX_BOARD) {
+        return false;
+    }
+    char address[FAS_ADDRESS_SIZE];
+    snprintf(address, sizeof(address), "serial:%s#%d", device, iBdID);
+    return attach_board(iBdID, FAS_SerialOpen(device, baud), address);
+}
+
+ /**@brief DriveGateway를 거쳐 연결 시 사용, gateway에서 같은 보드 ID로 연결된 드라이브와 통신함
+  * @param const char *path gateway socket 경로, NULL이면 FAS_GATEWAY_PATH
+  * @param int iBdID 드라이브 ID
+  * @return boolean 성공시 TRUE 실패시 FALSE*/
+bool FAS_ConnectGateway(const char *path, int iBdID) {
+    if (iBdID < 0 || iBdID >= FAS_MAX_BOARD) {
+        return false;
+    }
+    if (path == NULL) {
+        path = FAS_GATEWAY_PATH;
+    }
+    char address[FAS_ADDRESS_SIZE];
+    snprintf(address, sizeof(address), "gateway:%s#%d", path, iBdID);
+    return attach_board(iBdID, FAS_GatewayOpen(path), address);
+}
+
+ /**@brief 연결 해제 시 사용, 공유하는 보드가 없으면 transport도 닫음
+  * @param int iBdID 드라이브 ID */
+void FAS_Close(int iBdID) {
+    if (!FAS_IsConnected(iBdID)) {
+        return;
+    }
+    FAS_TRANSPORT *tp = boards[iBdID];
+    boards[iBdID] = NULL;
+    if (--tp->refs == 0) {
+        tp->ops->close(tp);
+    }
+}
+
+ /**@brief 보드가 연결되어 있는지 확인
+  * @param int iBdID 드라이브 ID */
+bool FAS_IsConnected(int iBdID) {
+    return iBdID >= 0 && iBdID < FAS_MAX_BOARD && boards[iBdID] != NULL;
+}
+
+ /**@brief 보드를 연결한 주소, "udp:192.168.0.2", "tcp:192.168.0.2", "serial:/dev/ttyUSB0#3", "gateway:/tmp/fas_gateway.sock#3" 형식
+  * @details 같은 transport를 쓰는 보드는 '#' 앞부분이 같다.
+  * @return 연결되어 있지 않으면 NULL*/
+const char *FAS_BoardAddress(int iBdID) {
+    return FAS_IsConnected(iBdID) ? board_address[iBdID] : NULL;
+}
+
+ /**@brief 보드의 RTT 추정값
+  * @return 연결되어 있지 않으면 FALSE*/
+bool FAS_GetRtt(int iBdID, FAS_RTT *rtt) {
+    if (!FAS_IsConnected(iBdID)) {
+        return false;
+    }
+    *rtt = board_rtt[iBdID];
+    return true;
+}
+
+ /**@brief 마지막으로 받은 응답의 값을 드라이브가 읽었을 것으로 추정한 시각 (CLOCK_MONOTONIC, us)
+  * @details 응답을 받은 시각은 네트워크 지연과 스케줄링 지연만큼 늦으므로, 여러 축의 값을 같은 시간축에 놓을 때는 이 값을 씀
+  * @return 아직 응답이 없으면 0*/
+int64_t FAS_ReplyTime(int iBdID) {
+    return FAS_IsConnected(iBdID) ? board_reply_time[iBdID] : 0;
+}
+
+ /**@brief 드라이브 상태를 바꾸지 않는 읽기 요청인지, 여러 번 보내거나 같은 요청끼리 묶어도 됨*/
+bool FAS_IsReadRequest(BYTE frame_type) {
+    switch (frame_type)
+    {
+        case 0x01: //FAS_GetboardInfo
+        case 0x05: //FAS_GetMotorInfo
+        case 0x06: //FAS_GetEncoder
+        case 0x07: //FAS_GetFirmwareInfo
+        case 0x13: //FAS_GetParameter
+        case 0x22: //FAS_GetIOInput
+        case 0x23: //FAS_GetIOOutput
+        case 0x25: //FAS_GetIOAssignMap
+        case 0x2E: //FAS_GetAlarmType
+        case 0x40: //FAS_GetAxisStatus
+            return true;
+        default:
+            return false;
+    }
+}
+
+ /**@brief RTT 표본 하나로 추정값을 갱신하고 드라이브가 값을 읽은 시각을 추정
+  * @details 드라이브는 요청을 받은 직후 값을 읽으므로 보낸 시각 + 편도 시간으로 본다. 편도 시간은 RTT의 절반인데,
+  * 평소보다 긴 RTT는 대개 응답을 받은 쪽의 스케줄링 지연이므로 표본과 평활 RTT 중 작은 쪽을 쓴다.
+  * @return 추정한 드라이브 쪽 시각 (CLOCK_MONOTONIC, us)*/
+static int64_t rtt_sample(int iBdID, int64_t sent_us, int64_t received_us) {
+    FAS_RTT *rtt = &board_rtt[iBdID];
+    int64_t sample = received_us - sent_us;
+
+    if (sample < 0) {
+        sample = 0;
+    }
+    if (rtt->samples == 0) {
+        rtt->srtt_us = sample;
+        rtt->rttvar_us = sample / 2;
+        rtt->min_us = sample;
+    }
+    else {
+        int64_t error = rtt->srtt_us - sample;
+        rtt->rttvar_us += ((error < 0 ? -error : error) - rtt->rttvar_us) / 4;
+        rtt->srtt_us += (sample - rtt->srtt_us) / 8;
+        if (sample < rtt->min_us) {
+            rtt->min_us = sample;
+        }
+    }
+    rtt->samples++;
+    rtt->rto_us = rtt->srtt_us + 4 * rtt->rttvar_us;
+    if (rtt->rto_us < FAS_RTO_MIN_MS * 1000) {
+        rtt->rto_us = FAS_RTO_MIN_MS * 1000;
+    }
+    if (rtt->rto_us > FAS_TIMEOUT_MS * 1000) {
+        rtt->rto_us = FAS_TIMEOUT_MS * 1000;
+    }
+    int64_t one_way = (sample < rtt->srtt_us ? sample : rtt->srtt_us) / 2;
+    board_reply_time[iBdID] = sent_us + one_way;
+    return board_reply_time[iBdID];
+}
+
+ /**@brief 지금 보낸 요청을 다시 보내기까지 기다릴 시간 (us)*/
+int64_t FAS_RttTimeout(int iBdID) {
+    return board_rtt[iBdID].rto_us;
+}
+
+ /**@brief RTO 안에 응답이 없었음, 다음 RTO를 두 배로 늘림*/
+void FAS_RttBackoff(int iBdID) {
+    FAS_RTT *rtt = &board_rtt[iBdID];
+    rtt->expired++;
+    rtt->rto_us = rtt->rto_us * 2 < FAS_TIMEOUT_MS * 1000 ? rtt->rto_us * 2 : FAS_TIMEOUT_MS * 1000;
+}
+
+ /**@brief 완성된 Plus-E 형식 프레임을 그대로 보냄 (ProtocolTest의 Send 버튼용)
+  * @return 보낸 바이트 수, 실패 시 -1*/
+int FAS_SendFrame(int iBdID, const BYTE *frame, int size) {
+    if (!FAS_IsConnected(iBdID)) {
+        return -1;
+    }
+    FAS_TRACE_BEGIN(span, "send", iBdID);
+    int result = boards[iBdID]->ops->send(boards[iBdID], iBdID, frame, size);
+    FAS_TRACE_END(span);
+    return result;
+}
+
+ /**@brief 응답 프레임 하나를 받음
+  * @return 받은 바이트 수, 실패나 timeout이면 -1, 받은 프레임의 CRC가 틀리면 FAS_RECV_CRC_ERROR*/
+int FAS_RecvFrame(int iBdID, BYTE *frame, int size, int timeout_ms) {
+    if (!FAS_IsConnected(iBdID)) {
+        return -1;
+    }
+    FAS_TRACE_BEGIN(span, "recv", iBdID);
+    int result = boards[iBdID]->ops->recv(boards[iBdID], iBdID, frame, size, timeout_ms);
+    FAS_TRACE_END(span);
+    return result;
+}
+
+static int transact_frame(int iBdID, BYTE *frame, int size, BYTE *reply, int reply_size, int *reply_bytes, int64_t *acquired_us) {
+    BYTE rx[BUFFER_SIZE];
+    BYTE syncs[FAS_MAX_TRIES];
+    int64_t sent_at[FAS_MAX_TRIES];
+    int tries = 0;
+
+    if (!FAS_IsConnected(iBdID)) {
+        return FMM_NOT_OPEN;
+    }
+    if (size < 5 || size > BUFFER_SIZE) {
+        return FMP_DATAERROR;
+    }
+    BYTE frame_type = frame[4];
+    bool retransmit = boards[iBdID]->datagram && FAS_IsReadRequest(frame_type);
+    int64_t deadline = FAS_NowUs() + FAS_TIMEOUT_MS * 1000;
+    int64_t resend_at = deadline;
+
+    while (1) {
+        int64_t now = FAS_NowUs();
+        if (tries == 0 || (now >= resend_at && now < deadline)) {
+            if (tries > 0) {
+                FAS_RttBackoff(iBdID);
+            }
+            frame[2] = syncs[tries] = ++board_sync[iBdID];
+            sent_at[tries] = now;
+            if (FAS_SendFrame(iBdID, frame, size) < 0) {
+                return FMC_DISCONNECTED;
+            }
+            tries++;
+            resend_at = retransmit && tries < FAS_MAX_TRIES ? now + FAS_RttTimeout(iBdID) : deadline;
+        }
+        int64_t wait = (resend_at < deadline ? resend_at : deadline) - FAS_NowUs();
+        int n = wait > 0 ? FAS_RecvFrame(iBdID, rx, sizeof(rx), (int)((wait + 999) / 1000)) : -1;
+        if (n == FAS_RECV_CRC_ERROR) {
+            return FMC_CRCFAILED_ERROR;
+        }
+        if (n < 0) {
+            if (FAS_NowUs() >= deadline) {
+                FAS_RttBackoff(iBdID);
+                return FMC_TIMEOUT_ERROR;
+            }
+            continue;
+        }
+        int k = 0;
+        while (k < tries && (n < 6 || rx[2] != syncs[k])) {
+            k++;
+        }
+        if (k == tries) {
+            continue;
+        }
+        int64_t received = FAS_NowUs();
+        int64_t acquired = rtt_sample(iBdID, sent_at[k], received);
+        FAS_TraceSpan("wire+drive", sent_at[k] * 1000, received * 1000, frame_type);
+        if (acquired_us != NULL) {
+            *acquired_us = acquired;
+        }
+        if (rx[4] != frame_type) {
+            return FMC_RECVPACKET_ERROR;
+        }
+        if (reply != NULL) {
+            memcpy(reply, rx, n < reply_size ? n : reply_size);
+        }
+        if (reply_bytes != NULL) {
+            *reply_bytes = n;
+        }
+        return rx[5];
+    }
+}
+
+static int transact(int iBdID, BYTE frame_type, const BYTE *data, int data_size, BYTE *reply, int reply_size, int *reply_bytes, int64_t *acquired_us) {
+    BYTE frame[BUFFER_SIZE];
+
+    if (data_size < 0 || data_size > DATA_SIZE) {
+        return FMP_DATAERROR;
+    }
+    FAS_TRACE_BEGIN(span, "transact", frame_type);
+    frame[0] = 0xAA; frame[1] = 3 + data_size; frame[2] = 0x00; frame[3] = 0x00; frame[4] = frame_type;
+    if (data_size > 0) {
+        memcpy(&frame[5], data, data_size);
+    }
+    int result = transact_frame(iBdID, frame, data_size + 5, reply, reply_size, reply_bytes, acquired_us);
+    FAS_TRACE_END(span);
+    return result;
+}
+
+ /**@brief 요청 하나를 보내고 sync 번호가 맞는 응답을 기다림
+  * @param BYTE *reply 응답 프레임 전체를 받을 버퍼, NULL이면 버림
+  * @return FMM_ERROR (응답의 통신상태 또는 FMM_NOT_OPEN, FMC_TIMEOUT_ERROR 등)*/
+int FAS_Transact(int iBdID, BYTE frame_type, const BYTE *data, int data_size, BYTE *reply, int reply_size) {
+    return transact(iBdID, frame_type, data, data_size, reply, reply_size, NULL, NULL);
+}
+
+ /**@brief 미리 만들어 둔 Plus-E 프레임을 sync 번호만 바꿔서 보내고 응답을 기다림
+  * @param BYTE *frame [AA][길이][sync][00][frame type][data...], frame[2]는 보낼 때의 sync 번호로 덮어씀
+  * @return FMM_ERROR (FAS_Transact와 같음)*/
+int FAS_TransactFrame(int iBdID, BYTE *frame, int size, BYTE *reply, int reply_size) {
+    FAS_TRACE_BEGIN(span, "transact", size > 4 ? frame[4] : 0);
+    int result = transact_frame(iBdID, frame, size, reply, reply_size, NULL, NULL);
+    FAS_TRACE_END(span);
+    return result;
+}
+
+ /**@brief 요청 여러 개를 차례로 처리, 같은 transport로 이어지는 요청은 transport가 한 번에 처리함
+  * @details RS-485 버스는 요청 사이의 빈 시간을 줄이기 위해 연속된 요청을 묶어서 보내므로,
+  * 같은 버스의 요청은 배열에서 붙여 두는 것이 좋다.
+  * @return 성공(FMM_OK)한 요청 수*/
+int FAS_TransactBatch(FAS_REQUEST *requests, int count) {
+    int ok = 0;
+
+    for (int i = 0; i < count;) {
+        FAS_TRANSPORT *tp = FAS_IsConnected(requests[i].iBdID) ? boards[requests[i].iBdID] : NULL;
+        int run = 1;
+        if (tp != NULL && tp->ops->batch != NULL) {
+            while (i + run < count && FAS_IsConnected(requests[i + run].iBdID) && boards[requests[i + run].iBdID] == tp) {
+                run++;
+            }
+            for (int j = i; j < i + run; j++) {
+                requests[j].acquired_us = requests[j].received_us = 0;
+            }
+            FAS_TRACE_BEGIN(span, "batch", run);
+            tp->ops->batch(tp, &requests[i], run);
+            FAS_TRACE_END(span);
+            for (int j = i; j < i + run; j++) {
+                if (requests[j].received_us != 0) {
+                    requests[j].acquired_us = rtt_sample(requests[j].iBdID, requests[j].sent_us, requests[j].received_us);
+                    FAS_TraceSpan("wire+drive", requests[j].sent_us * 1000, requests[j].received_us * 1000, requests[j].frame_type);
+                }
+            }
+        }
+        else {
+            FAS_REQUEST *request = &requests[i];
+            request->reply_bytes = 0;
+            request->acquired_us = 0;
+            request->result = transact(request->iBdID, request->frame_type, request->data, request->data_size,
+                                       request->reply, request->reply_size, &request->reply_bytes, &request->acquired_us);
+        }
+        for (int j = i; j < i + run; j++) {
+            if (requests[j].result == FMM_OK) {
+                ok++;
+            }
+        }
+        i += run;
+    }
+    return ok;
+}
+
+ /**@brief 라이브러리가 쓰는 메모리를 출력, FAS_STATIC_MEMORY 빌드면 모두 static이고 아니면 transport는 연결할 때마다 heap에서 잡음*/
+void FAS_PrintFootprint(FILE *out) {
+    const FAS_POOL *pools[] = { &FAS_EthernetPool, &FAS_UringPool, &FAS_SerialPool, &FAS_GatewayPool };
+    size_t tables = sizeof(boards) + sizeof(board_sync) + sizeof(board_address) + sizeof(board_rtt) + sizeof(board_reply_time);
+    size_t total = tables;
+#ifdef FAS_STATIC_MEMORY
+    const char *where = "static";
+#else
+    const char *where = "heap";
+#endif
+
+    fprintf(out, "FAS_MAX_BOARD %d, FAS_MAX_INFLIGHT %d, BUFFER_SIZE %d, transports from %s\n", FAS_MAX_BOARD, FAS_MAX_INFLIGHT, BUFFER_SIZE, where);
+    fprintf(out, "%-14s %8s %6s %10s %7s %5s\n", "ITEM", "SIZE", "SLOTS", "BYTES", "IN USE", "PEAK");
+    fprintf(out, "%-14s %8zu %6d %10zu %7s %5s\n", "board table", tables / FAS_MAX_BOARD, FAS_MAX_BOARD, tables, "-", "-");
+    for (size_t i = 0; i < sizeof(pools) / sizeof(pools[0]); i++) {
+        size_t bytes = pools[i]->size * (pools[i]->slots != NULL ? FAS_MAX_BOARD : pools[i]->peak);
+        fprintf(out, "%-14s %8zu %6d %10zu %7d %5d\n", pools[i]->name, pools[i]->size, pools[i]->slots != NULL ? FAS_MAX_BOARD : pools[i]->peak,
+                bytes, pools[i]->in_use, pools[i]->peak);
+        total += bytes;
+    }
+    fprintf(out, "total %zu bytes%s\n", total, pools[0]->slots != NULL ? "" : " (heap part counted at peak)");
+}
+
+ /**@brief 문자열 앞뒤의 공백을 없앰 (뒤쪽은 제자리에서 자름), 계획/규칙 문자열을 읽는 모듈이 씀
+  * @return text 안에서 공백이 아닌 첫 글자*/
+char *FAS_Trim(char *text) {
+    while (isspace((unsigned char)*text)) {
+        text++;
+    }
+    char *end = text + strlen(text);
+    while (end > text && isspace((unsigned char)end[-1])) {
+        *--end = '\0';
+    }
+    return text;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+/**
+ * @file FAS_Library.h
+ * @brief ProtocolTest.c에서 분리한 FASTECH 라이브러리와 같은 기능의 통신 함수
+ * @details 보드(iBdID)마다 transport(UDP/TCP/RS-485)를 하나씩 연결하고, 프레임은 어느 transport든
+ * Plus-E 형식으로 주고받는다. (송신 [AA][길이][sync][00][frame type][data...], 응답은 frame type 뒤에 통신상태 1바이트)
+ * RS-485(Plus-R)는 transport가 내부에서 Plus-R 프레임으로 바꾸어 보낸다.
+ * GTK/GLib를 쓰지 않으므로 GUI 없는 도구에서도 그대로 링크할 수 있다.
+ * -DFAS_STATIC_MEMORY로 빌드하면 transport를 heap 대신 컴파일할 때 잡은 배열에서 가져오므로 malloc을 전혀 쓰지 않는다.
+ * 배열 크기는 FAS_MAX_BOARD, FAS_MAX_INFLIGHT, BUFFER_SIZE로 정해지며 -D로 줄일 수 있다. (크기는 FAS_PrintFootprint로 확인)
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include "MOTION_DEFINE.h"
+#include "ReturnCodes_Define.h"
+
+#define BUFFER_SIZE 258
+#define DATA_SIZE 253
+#define PORT 3001 //UDP GUI
+
+#ifndef FAS_MAX_BOARD
+#define FAS_MAX_BOARD 16 //연결할 수 있는 최대 보드 수, RS-485 Slave ID도 이 범위 안에서 사용
+#endif
+#ifndef FAS_MAX_INFLIGHT
+#define FAS_MAX_INFLIGHT 8 //batch에서 응답을 기다리지 않고 먼저 보내 두는 요청 수 (io_uring transport)
+#endif
+#define FAS_TIMEOUT_MS 100 //FAS_Transact의 응답 대기 시간
+#define FAS_RTO_MIN_MS 5 //재전송 timeout 하한
+#define FAS_MAX_TRIES 3 //UDP 읽기 요청을 보내는 최대 횟수 (첫 전송 포함)
+#define FAS_ADDRESS_SIZE 64 //FAS_BoardAddress 문자열 최대 길이
+#define FAS_RECV_CRC_ERROR -2 //FAS_RecvFrame이 CRC가 틀린 프레임을 받았을 때 돌려주는 값 (RS-485)
+#define FAS_GATEWAY_PATH "/tmp/fas_gateway.sock" //DriveGateway가 기본으로 여는 Unix domain socket
+
+ /**@brief FAS_TransactBatch에 넘기는 요청 하나*/
+typedef struct
+{
+    int iBdID;
+    BYTE frame_type;
+    const BYTE *data;
+    int data_size;
+    BYTE *reply;      //응답 프레임 전체 (Plus-E 형식), NULL이면 버림
+    int reply_size;
+    int reply_bytes;  //받은 응답 길이
+    int result;       //FMM_ERROR, 응답의 통신상태 바이트 또는 FMC_TIMEOUT_ERROR 등
+    int64_t acquired_us; //드라이브가 값을 읽었을 것으로 추정한 시각 (CLOCK_MONOTONIC, us), 응답이 없으면 0
+    int64_t sent_us;     //응답을 받은 전송을 보낸 시각, transport의 batch가 채움
+    int64_t received_us; //응답을 받은 시각, transport의 batch가 채우고 응답이 없으면 0
+} FAS_REQUEST;
+
+ /**@brief 보드별 왕복시간(RTT) 추정값, RFC 6298과 같은 방식*/
+typedef struct
+{
+    int64_t srtt_us;    //평활 RTT
+    int64_t rttvar_us;  //RTT 변동폭
+    int64_t min_us;     //지금까지 가장 짧은 RTT
+    int64_t rto_us;     //재전송 timeout, 응답이 없을 때마다 두 배 (FAS_RTO_MIN_MS ~ FAS_TIMEOUT_MS)
+    uint64_t samples;
+    uint64_t expired;   //RTO 안에 응답이 없었던 횟수 (재전송과 timeout)
+} FAS_RTT;
+
+ /**@brief UDP 연결에 쓰는 방식, FAS_Connect 전에 FAS_SetEthernetBackend로 바꿈*/
+typedef enum
+{
+    FAS_BACKEND_SOCKET,        //sendto/recvfrom (기본)
+    FAS_BACKEND_URING,         //io_uring, 제출과 응답 대기를 시스템 콜 한 번으로
+    FAS_BACKEND_URING_SQPOLL,  //io_uring + 커널 SQ polling 스레드
+} FAS_ETHERNET_BACKEND;
+
+void FAS_SetEthernetBackend(FAS_ETHERNET_BACKEND backend);
+bool FAS_Connect(BYTE sb1, BYTE sb2, BYTE sb3, BYTE sb4, int iBdID);
+bool FAS_ConnectTCP(BYTE sb1, BYTE sb2, BYTE sb3, BYTE sb4, int iBdID);
+bool FAS_ConnectSerial(const char *device, int baud, int iBdID);
+bool FAS_ConnectGateway(const char *path, int iBdID);
+void FAS_Close(int iBdID);
+bool FAS_IsConnected(int iBdID);
+const char *FAS_BoardAddress(int iBdID);
+bool FAS_GetRtt(int iBdID, FAS_RTT *rtt);
+int64_t FAS_ReplyTime(int iBdID);
+bool FAS_IsReadRequest(BYTE frame_type);
+
+int FAS_SendFrame(int iBdID, const BYTE *frame, int size);
+int FAS_RecvFrame(int iBdID, BYTE *frame, int size, int timeout_ms);
+int FAS_Transact(int iBdID, BYTE frame_type, const BYTE *data, int data_size, BYTE *reply, int reply_size);
+int FAS_TransactFrame(int iBdID, BYTE *frame, int size, BYTE *reply, int reply_size);
+int FAS_TransactBatch(FAS_REQUEST *requests, int count);
+
+void FAS_PrintFootprint(FILE *out);
+char *FAS_Trim(char *text);
+
+ /**@brief CLOCK_MONOTONIC 시각 (us), FAS_REQUEST의 시각과 같은 시계*/
+static inline int64_t FAS_NowUs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+ /**@brief FAS_NowUs 시각 when까지 잠듦, 주기를 맞출 때 절대 시각으로 자므로 오차가 쌓이지 않음*/
+static inline void FAS_SleepUntilUs(int64_t when) {
+    struct timespec ts = { .tv_sec = when / 1000000, .tv_nsec = (when % 1000000) * 1000 };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) { //시그널로 깨어나면 다시 잠듦
+    }
+}
@@ -0,0 +1,679 @@
+/**
+ * @file FAS_Log.c
+ * @brief 스레드별 lock-free ring, 기록 스레드, binary 로그 파일 읽기
+ * @details ring은 스레드 하나가 쓰고 기록 스레드 하나가 읽는다. (single producer, single consumer)
+ * 로그 하나는 [크기 4][호출 위치 번호 2][앞서 버린 수 2][시각 8][인자...]이고 8바이트 단위로 맞춘다.
+ * 정수/실수/포인터 인자는 8바이트, 문자열은 [길이 2][바이트...]로 넣는다.
+ * 끝에 자리가 모자라면 번호 0인 빈 로그로 채우고 처음부터 쓴다.
+ * 파일은 "FASLOG1\n"과 [시작 시각 보정값 8] 뒤에 'S'(호출 위치 정의, 처음 쓸 때 한 번)와 'R'([스레드 1][로그])이 이어진다.
+ */
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/types.h>
+#include <time.h>
+#include "FAS_Log.h"
+
+#define LOG_MAGIC "FASLOG1\n"
+#define LOG_HEADER_SIZE 16
+#define LOG_MAX_RECORD (LOG_HEADER_SIZE + FAS_LOG_MAX_ARGS * (2 + FAS_LOG_STRING_MAX) + 8)
+#define LOG_TEXT_SIZE 4096
+#define LOG_SPEC_TEXT 32  //변환 하나('%'부터 변환 문자까지)의 최대 길이 + 1
+
+typedef enum
+{
+    LENGTH_NONE,
+    LENGTH_HH,
+    LENGTH_H,
+    LENGTH_L,
+    LENGTH_LL,
+    LENGTH_Z,
+    LENGTH_J,
+    LENGTH_T,
+    LENGTH_BIG_L,  //long double
+} LOG_LENGTH;
+
+ /**@brief 형식 문자열의 변환 하나 (%08X 등)*/
+typedef struct
+{
+    char conv;          //d, u, x, f, s, p ... 지원하지 않는 변환이면 0
+    LOG_LENGTH length;
+    int size;           //'%'부터 변환 문자까지의 길이
+} LOG_SPEC;
+
+ /**@brief 등록된 호출 위치와 인자 형*/
+typedef struct
+{
+    FAS_LOG_SITE *site;
+    LOG_SPEC args[FAS_LOG_MAX_ARGS];
+    int argc;
+    bool bytes;  //FAS_LOG_BYTES, %s 인자를 hex로 보여줌
+} LOG_SITE_INFO;
+
+typedef struct
+{
+    unsigned char data[FAS_LOG_RING_SIZE];
+    _Atomic uint32_t head;   //쓰는 스레드만 바꿈
+    _Atomic uint32_t tail;   //기록 스레드만 바꿈
+    _Atomic bool owned;      //쓰는 스레드가 있음, 스레드가 끝나면 다른 스레드가 이어 씀
+    uint32_t dropped;        //자리가 없어 버린 뒤 아직 알리지 못한 수
+} LOG_RING;
+
+static LOG_RING rings[FAS_LOG_MAX_THREADS];
+static _Atomic int ring_count;  //한 번이라도 쓴 ring 수
+static _Thread_local LOG_RING *thread_ring;
+static pthread_key_t ring_key;
+static pthread_once_t ring_once = PTHREAD_ONCE_INIT;
+
+static LOG_SITE_INFO sites[FAS_LOG_MAX_SITES];
+static int site_count;
+static pthread_mutex_t site_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static _Atomic bool running;
+static _Atomic bool writer_stop;
+static _Atomic bool writer_sleeping; //기록 스레드가 wake_fd에서 잠들어 있음, 이때만 쓰는 쪽이 깨움
+static int wake_fd = -1;
+static pthread_t writer;
+static FILE *log_out;
+static bool log_binary;
+static int64_t realtime_offset_ns; //CLOCK_REALTIME - CLOCK_MONOTONIC
+static bool site_written[FAS_LOG_MAX_SITES];
+
+static int64_t now_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+ /**@brief p가 가리키는 '%'부터 변환 하나를 읽음*/
+static void parse_spec(const char *p, LOG_SPEC *spec) {
+    const char *start = p++;
+    spec->conv = 0;
+    spec->length = LENGTH_NONE;
+    p += strspn(p, "-+ #0");
+    p += strspn(p, "0123456789");
+    if (*p == '.') {
+        p++;
+        p += strspn(p, "0123456789");
+    }
+    switch (*p)
+    {
+        case 'h': spec->length = p[1] == 'h' ? LENGTH_HH : LENGTH_H; p += p[1] == 'h' ? 2 : 1; break;
+        case 'l': spec->length = p[1] == 'l' ? LENGTH_LL : LENGTH_L; p += p[1] == 'l' ? 2 : 1; break;
+        case 'z': spec->length = LENGTH_Z; p++; break;
+        case 'j': spec->length = LENGTH_J; p++; break;
+        case 't': spec->length = LENGTH_T; p++; break;
+        case 'L': spec->length = LENGTH_BIG_L; p++; break;
+        default: break;
+    }
+    if (*p != '\0' && strchr("diouxXcfFeEgGaAsp%", *p) != NULL) {
+        spec->conv = *p;
+    }
+    spec->size = (int)(p - start) + (*p != '\0');
+}
+
+static bool is_signed(char conv) {
+    return conv == 'd' || conv == 'i';
+}
+
+static bool is_double(char conv) {
+    return strchr("fFeEgGaA", conv) != NULL;
+}
+
+ /**@brief 로그의 8바이트 값이나 문자열로 snprintf에 넘길 수 있는 변환인지 (%n, '*', %ls 등은 안 됨)*/
+static bool spec_supported(const LOG_SPEC *spec) {
+    if (spec->conv == 0 || spec->size >= LOG_SPEC_TEXT) {
+        return false;
+    }
+    if (spec->conv == '%') {
+        return true;
+    }
+    if (spec->conv == 's' || spec->conv == 'p' || spec->conv == 'c') {
+        return spec->length == LENGTH_NONE;
+    }
+    if (is_double(spec->conv)) {
+        return spec->length == LENGTH_NONE || spec->length == LENGTH_L || spec->length == LENGTH_BIG_L;
+    }
+    return spec->length != LENGTH_BIG_L;
+}
+
+ /**@brief 호출 위치에 번호를 주고 인자 형을 기억함, 처음 한 번만 잠금
+  * @return 번호, 자리가 없거나 형식을 지원하지 않으면 0*/
+static int register_site(FAS_LOG_SITE *site, bool bytes) {
+    pthread_mutex_lock(&site_lock);
+    int id = atomic_load(&site->id);
+    if (id == 0 && site_count + 1 < FAS_LOG_MAX_SITES) {
+        LOG_SITE_INFO info = { .site = site, .bytes = bytes };
+        bool ok = true;
+        for (const char *p = site->format; (p = strchr(p, '%')) != NULL; ) {
+            LOG_SPEC spec;
+            parse_spec(p, &spec);
+            p += spec.size;
+            if (spec.conv == '%') {
+                continue;
+            }
+            if (!spec_supported(&spec) || info.argc == FAS_LOG_MAX_ARGS || (bytes && spec.conv != 's')) {
+                ok = false;
+                break;
+            }
+            info.args[info.argc++] = spec;
+        }
+        if (ok && (!bytes || info.argc == 1)) {
+            id = ++site_count;
+            sites[id] = info;
+            atomic_store_explicit(&site->id, id, memory_order_release);
+        }
+        else {
+            fprintf(stderr, "%s:%d: unsupported log format \"%s\"\n", site->file, site->line, site->format);
+        }
+    }
+    pthread_mutex_unlock(&site_lock);
+    return id;
+}
+
+static void release_ring(void *arg) {
+    LOG_RING *ring = arg;
+    atomic_store_explicit(&ring->owned, false, memory_order_release);
+}
+
+static void make_ring_key(void) {
+    pthread_key_create(&ring_key, release_ring);
+}
+
+ /**@brief 이 스레드의 ring, 처음 부르면 빈 ring 하나를 차지함
+  * @return ring이 모두 쓰이고 있으면 NULL*/
+static LOG_RING *claim_ring(void) {
+    if (thread_ring != NULL) {
+        return thread_ring;
+    }
+    pthread_once(&ring_once, make_ring_key);
+    for (int i = 0; i < FAS_LOG_MAX_THREADS; i++) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&rings[i].owned, &expected, true)) {
+            int count = atomic_load(&ring_count);
+            while (count < i + 1 && !atomic_compare_exchange_weak(&ring_count, &count, i + 1)) {
+            }
+            pthread_setspecific(ring_key, &rings[i]);
+            thread_ring = &rings[i];
+            return thread_ring;
+        }
+    }
+    return NULL;
+}
+
+ /**@brief record를 ring에 넣음, 자리가 없으면 버리고 버린 수를 셈*/
+static void ring_push(LOG_RING *ring, unsigned char *record, uint32_t size) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    uint32_t offset = head & (FAS_LOG_RING_SIZE - 1);
+    uint32_t pad = FAS_LOG_RING_SIZE - offset < size ? FAS_LOG_RING_SIZE - offset : 0;
+
+    if (head + pad + size - tail > FAS_LOG_RING_SIZE) {
+        ring->dropped++;
+        return;
+    }
+    if (pad > 0) {
+        memcpy(&ring->data[offset], &pad, 4);
+        memset(&ring->data[offset + 4], 0, 2);
+        offset = 0;
+    }
+    uint16_t dropped = ring->dropped > UINT16_MAX ? UINT16_MAX : (uint16_t)ring->dropped;
+    ring->dropped -= dropped;
+    memcpy(&record[6], &dropped, 2);
+    memcpy(&ring->data[offset], record, size);
+    atomic_store_explicit(&ring->head, head + pad + size, memory_order_release);
+    atomic_thread_fence(memory_order_seq_cst); //writer_thread의 fence와 짝, head를 쓴 뒤에 sleeping을 읽음
+    if (atomic_load_explicit(&writer_sleeping, memory_order_relaxed)) {
+        uint64_t one = 1;
+        if (write(wake_fd, &one, sizeof(one)) < 0) {
+            perror("log writer wake failed");
+        }
+    }
+}
+
+ /**@brief 로그 머리 [크기][번호][버린 수 자리][시각]를 채움*/
+static void put_header(unsigned char *record, uint32_t size, uint16_t id) {
+    int64_t time_ns = now_ns(CLOCK_MONOTONIC);
+    memcpy(&record[0], &size, 4);
+    memcpy(&record[4], &id, 2);
+    memcpy(&record[8], &time_ns, 8);
+}
+
+ /**@brief FAS_LOG가 부르는 함수, 인자 값만 복사함*/
+void FAS_LogWrite(FAS_LOG_SITE *site, ...) {
+    if (!atomic_load_explicit(&running, memory_order_relaxed)) {
+        return;
+    }
+    int id = atomic_load_explicit(&site->id, memory_order_acquire);
+    if (id == 0 && (id = register_site(site, false)) == 0) {
+        return;
+    }
+    LOG_RING *ring = claim_ring();
+    if (ring == NULL) {
+        return;
+    }
+
+    const LOG_SITE_INFO *info = &sites[id];
+    unsigned char record[LOG_MAX_RECORD];
+    unsigned char *p = &record[LOG_HEADER_SIZE];
+    va_list ap;
+    va_start(ap, site);
+    for (int i = 0; i < info->argc; i++) {
+        const LOG_SPEC *spec = &info->args[i];
+        if (spec->conv == 's') {
+            const char *text = va_arg(ap, const char *);
+            if (text == NULL) {
+                text = "(null)";
+            }
+            uint16_t length = (uint16_t)strnlen(text, FAS_LOG_STRING_MAX);
+            memcpy(p, &length, 2);
+            memcpy(p + 2, text, length);
+            p += 2 + length;
+            continue;
+        }
+        if (is_double(spec->conv)) {
+            double value = spec->length == LENGTH_BIG_L ? (double)va_arg(ap, long double) : va_arg(ap, double);
+            memcpy(p, &value, 8);
+            p += 8;
+            continue;
+        }
+        int64_t value;
+        if (spec->conv == 'p') {
+            value = (int64_t)(uintptr_t)va_arg(ap, void *);
+        }
+        else {
+            switch (spec->length)
+            {
+                case LENGTH_L: value = va_arg(ap, long); break;
+                case LENGTH_LL: value = va_arg(ap, long long); break;
+                case LENGTH_Z: value = (int64_t)va_arg(ap, size_t); break;
+                case LENGTH_J: value = va_arg(ap, intmax_t); break;
+                case LENGTH_T: value = va_arg(ap, ptrdiff_t); break;
+                default: value = is_signed(spec->conv) || spec->conv == 'c' ? va_arg(ap, int) : (int64_t)va_arg(ap, unsigned); break;
+            }
+        }
+        memcpy(p, &value, 8);
+        p += 8;
+    }
+    va_end(ap);
+
+    uint32_t size = ((uint32_t)(p - record) + 7) & ~7u;
+    put_header(record, size, (uint16_t)id);
+    ring_push(ring, record, size);
+}
+
+ /**@brief FAS_LOG_BYTES가 부르는 함수, 바이트를 그대로 복사함 (FAS_LOG_STRING_MAX까지)*/
+void FAS_LogBytes(FAS_LOG_SITE *site, const void *bytes, int size) {
+    if (!atomic_load_explicit(&running, memory_order_relaxed)) {
+        return;
+    }
+    int id = atomic_load_explicit(&site->id, memory_order_acquire);
+    if (id == 0 && (id = register_site(site, true)) == 0) {
+        return;
+    }
+    LOG_RING *ring = claim_ring();
+    if (ring == NULL) {
+        return;
+    }
+
+    unsigned char record[LOG_HEADER_SIZE + 2 + FAS_LOG_STRING_MAX + 8];
+    uint16_t length = size < 0 ? 0 : size > FAS_LOG_STRING_MAX ? FAS_LOG_STRING_MAX : (uint16_t)size;
+    memcpy(&record[LOG_HEADER_SIZE], &length, 2);
+    memcpy(&record[LOG_HEADER_SIZE + 2], bytes, length);
+    uint32_t record_size = (LOG_HEADER_SIZE + 2 + length + 7) & ~7u;
+    put_header(record, record_size, (uint16_t)id);
+    ring_push(ring, record, record_size);
+}
+
+ /**@brief 형식과 로그의 인자로 문자열을 만듦, 인자가 모자라면 거기서 멈춤
+  * @details 형식도 파일에서 읽은 것이므로 register_site와 같이 검사하고, 지원하지 않는 변환이 나오면 나머지 형식을 그대로 옮김*/
+static void format_record(const char *format, bool bytes, const unsigned char *args, const unsigned char *end, char *text, int text_size) {
+    static const char hex[] = "0123456789ABCDEF";
+    int n = 0;
+
+    for (const char *p = format; *p != '\0' && n < text_size - 1; ) {
+        if (*p != '%') {
+            text[n++] = *p++;
+            continue;
+        }
+        LOG_SPEC spec;
+        parse_spec(p, &spec);
+        if (!spec_supported(&spec) || (bytes && spec.conv != 's' && spec.conv != '%')) {
+            while (*p != '\0' && n < text_size - 1) {
+                text[n++] = *p++;
+            }
+            break;
+        }
+        char one[LOG_SPEC_TEXT];
+        snprintf(one, sizeof(one), "%.*s", spec.size, p);
+        p += spec.size;
+        int room = text_size - n;
+        int written = 0;
+        if (spec.conv == '%') {
+            if (n < text_size - 1) {
+                text[n++] = '%';
+            }
+            continue;
+        }
+        if (spec.conv == 's') {
+            uint16_t length;
+            if (end - args < 2) {
+                break;
+            }
+            memcpy(&length, args, 2);
+            if (length > FAS_LOG_STRING_MAX || end - args < 2 + length) {
+                break;
+            }
+            if (bytes) {
+                for (int i = 0; i < length && n + 3 < text_size; i++) {
+                    if (i > 0) {
+                        text[n++] = ' ';
+                    }
+                    text[n++] = hex[args[2 + i] >> 4];
+                    text[n++] = hex[args[2 + i] & 0x0F];
+                }
+            }
+            else {
+                char string[FAS_LOG_STRING_MAX + 1];
+                memcpy(string, &args[2], length);
+                string[length] = '\0';
+                written = snprintf(&text[n], room, one, string);
+            }
+            args += 2 + length;
+        }
+        else {
+            if (end - args < 8) {
+                break;
+            }
+            int64_t value;
+            double real;
+            memcpy(&value, args, 8);
+            memcpy(&real, args, 8);
+            args += 8;
+            if (is_double(spec.conv)) {
+                if (spec.length == LENGTH_BIG_L) {
+                    written = snprintf(&text[n], room, one, (long double)real);
+                }
+                else {
+                    written = snprintf(&text[n], room, one, real);
+                }
+            }
+            else if (spec.conv == 'p') {
+                written = snprintf(&text[n], room, one, (void *)(uintptr_t)value);
+            }
+            else if (is_signed(spec.conv) || spec.conv == 'c') {
+                switch (spec.length)
+                {
+                    case LENGTH_L: written = snprintf(&text[n], room, one, (long)value); break;
+                    case LENGTH_LL: written = snprintf(&text[n], room, one, (long long)value); break;
+                    case LENGTH_Z: written = snprintf(&text[n], room, one, (ssize_t)value); break;
+                    case LENGTH_J: written = snprintf(&text[n], room, one, (intmax_t)value); break;
+                    case LENGTH_T: written = snprintf(&text[n], room, one, (ptrdiff_t)value); break;
+                    default: written = snprintf(&text[n], room, one, (int)value); break;
+                }
+            }
+            else {
+                switch (spec.length)
+                {
+                    case LENGTH_L: written = snprintf(&text[n], room, one, (unsigned long)value); break;
+                    case LENGTH_LL: written = snprintf(&text[n], room, one, (unsigned long long)value); break;
+                    case LENGTH_Z: written = snprintf(&text[n], room, one, (size_t)value); break;
+                    case LENGTH_J: written = snprintf(&text[n], room, one, (uintmax_t)value); break;
+                    case LENGTH_T: written = snprintf(&text[n], room, one, (ptrdiff_t)value); break;
+                    default: written = snprintf(&text[n], room, one, (unsigned)value); break;
+                }
+            }
+        }
+        if (written > 0) {
+            n += written < room ? written : room - 1;
+        }
+    }
+    text[n] = '\0';
+}
+
+ /**@brief 한 줄 출력 "시:분:초.us T스레드 내용"*/
+static void print_line(FILE *out, int64_t realtime_ns, int thread, const char *text) {
+    time_t seconds = (time_t)(realtime_ns / 1000000000);
+    struct tm tm;
+    localtime_r(&seconds, &tm);
+    fprintf(out, "%02d:%02d:%02d.%06d T%d %s\n", tm.tm_hour, tm.tm_min, tm.tm_sec, (int)(realtime_ns % 1000000000 / 1000), thread, text);
+}
+
+ /**@brief 로그 하나를 글자로 출력, 앞서 버린 로그가 있으면 먼저 알림*/
+static void print_record(FILE *out, int64_t offset_ns, int thread, const char *format, bool bytes, const unsigned char *record, uint32_t size) {
+    uint16_t dropped;
+    int64_t time_ns;
+    char text[LOG_TEXT_SIZE];
+    memcpy(&dropped, &record[6], 2);
+    memcpy(&time_ns, &record[8], 8);
+    if (dropped > 0) {
+        snprintf(text, sizeof(text), "(%u logs dropped, ring full)", dropped);
+        print_line(out, time_ns + offset_ns, thread, text);
+    }
+    format_record(format, bytes, &record[LOG_HEADER_SIZE], &record[size], text, sizeof(text));
+    print_line(out, time_ns + offset_ns, thread, text);
+}
+
+ /**@brief 호출 위치 정의 'S'를 파일에 씀 [번호 2][bytes 1][줄 4][파일 이름 길이 2][파일 이름][형식 길이 2][형식]*/
+static void write_site(int id) {
+    const LOG_SITE_INFO *info = &sites[id];
+    uint16_t id16 = (uint16_t)id;
+    int32_t line = info->site->line;
+    uint16_t file_length = (uint16_t)strlen(info->site->file);
+    uint16_t format_length = (uint16_t)strlen(info->site->format);
+    fputc('S', log_out);
+    fwrite(&id16, 2, 1, log_out);
+    fputc(info->bytes, log_out);
+    fwrite(&line, 4, 1, log_out);
+    fwrite(&file_length, 2, 1, log_out);
+    fwrite(info->site->file, 1, file_length, log_out);
+    fwrite(&format_length, 2, 1, log_out);
+    fwrite(info->site->format, 1, format_length, log_out);
+    site_written[id] = true;
+}
+
+ /**@brief 모든 ring에 쌓인 로그를 내보냄
+  * @return 내보낸 로그 수*/
+static int drain(void) {
+    int count = 0;
+    int rings_used = atomic_load(&ring_count);
+    for (int r = 0; r < rings_used; r++) {
+        LOG_RING *ring = &rings[r];
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        while (tail != head) {
+            const unsigned char *record = &ring->data[tail & (FAS_LOG_RING_SIZE - 1)];
+            uint32_t size;
+            uint16_t id;
+            memcpy(&size, record, 4);
+            memcpy(&id, &record[4], 2);
+            tail += size;
+            if (id == 0) {
+                continue; //끝을 채운 빈 로그
+            }
+            if (log_binary) {
+                if (!site_written[id]) {
+                    write_site(id);
+                }
+                fputc('R', log_out);
+                fputc(r, log_out);
+                fwrite(record, 1, size, log_out);
+            }
+            else {
+                print_record(log_out, realtime_offset_ns, r, sites[id].site->format, sites[id].bytes, record, size);
+            }
+            count++;
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+    if (count > 0) {
+        fflush(log_out);
+    }
+    return count;
+}
+
+ /**@brief 아직 내보내지 않은 로그가 있는 ring이 있는지*/
+static bool rings_pending(void) {
+    int rings_used = atomic_load(&ring_count);
+    for (int r = 0; r < rings_used; r++) {
+        if (atomic_load_explicit(&rings[r].head, memory_order_acquire) != atomic_load_explicit(&rings[r].tail, memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ /**@brief 바쁜 동안에는 FAS_LOG_FLUSH_MS마다 ring을 비우고, 한 주기 동안 로그가 없으면 다음 로그가 깨울 때까지 잠듦*/
+static void *writer_thread(void *arg) {
+    struct timespec period = { 0, FAS_LOG_FLUSH_MS * 1000000L };
+    bool idle = false;
+    while (!atomic_load(&writer_stop)) {
+        if (drain() > 0) {
+            idle = false;
+            continue;
+        }
+        if (!idle) {
+            idle = true;
+            nanosleep(&period, NULL); //곧 이어지는 로그를 한 번에 내보내도록 잠깐 기다림
+            continue;
+        }
+        atomic_store(&writer_sleeping, true);
+        atomic_thread_fence(memory_order_seq_cst); //ring_push의 fence와 짝, 잠들기 전에 들어온 로그를 놓치지 않도록 다시 확인
+        if (!rings_pending() && !atomic_load(&writer_stop)) {
+            uint64_t value;
+            if (read(wake_fd, &value, sizeof(value)) < 0) {
+                nanosleep(&period, NULL);
+            }
+        }
+        atomic_store(&writer_sleeping, false);
+    }
+    drain();
+    return NULL;
+}
+
+ /**@brief 기록 스레드를 띄우고 로그를 받기 시작함
+  * @param const char *path binary 로그 파일 (덮어씀), NULL이면 stdout에 글자로 씀
+  * @return 이미 시작했거나 파일을 열 수 없으면 FALSE*/
+bool FAS_LogStart(const char *path) {
+    if (atomic_load(&running)) {
+        return false;
+    }
+    log_binary = path != NULL;
+    log_out = log_binary ? fopen(path, "wb") : stdout;
+    if (log_out == NULL) {
+        perror(path);
+        return false;
+    }
+    realtime_offset_ns = now_ns(CLOCK_REALTIME) - now_ns(CLOCK_MONOTONIC);
+    memset(site_written, 0, sizeof(site_written));
+    if (log_binary) {
+        fwrite(LOG_MAGIC, 1, strlen(LOG_MAGIC), log_out);
+        fwrite(&realtime_offset_ns, 8, 1, log_out);
+    }
+    atomic_store(&writer_stop, false);
+    wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (wake_fd < 0 || pthread_create(&writer, NULL, writer_thread, NULL) != 0) {
+        if (wake_fd >= 0) {
+            close(wake_fd);
+            wake_fd = -1;
+        }
+        if (log_binary) {
+            fclose(log_out);
+        }
+        return false;
+    }
+    atomic_store(&running, true);
+    return true;
+}
+
+ /**@brief 로그를 그만 받고 남은 로그를 모두 내보낸 뒤 파일을 닫음*/
+void FAS_LogStop(void) {
+    if (!atomic_exchange(&running, false)) {
+        return;
+    }
+    atomic_store(&writer_stop, true);
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0) {
+        perror("log writer wake failed");
+    }
+    pthread_join(writer, NULL);
+    close(wake_fd);
+    wake_fd = -1;
+    if (log_binary) {
+        fclose(log_out);
+    }
+    else {
+        fflush(log_out);
+    }
+}
+
+ /**@brief FAS_LogStart(path)로 남긴 binary 로그를 글자로 바꿔 out에 씀
+  * @return 읽은 로그 수, 파일 형식이 아니면 -1*/
+int FAS_LogDecode(FILE *in, FILE *out) {
+    char magic[sizeof(LOG_MAGIC) - 1];
+    int64_t offset_ns;
+    if (fread(magic, 1, sizeof(magic), in) != sizeof(magic) || memcmp(magic, LOG_MAGIC, sizeof(magic)) != 0
+        || fread(&offset_ns, 8, 1, in) != 1) {
+        return -1;
+    }
+
+    static char *formats[FAS_LOG_MAX_SITES];
+    static bool bytes[FAS_LOG_MAX_SITES];
+    int count = 0;
+    int type;
+    while ((type = fgetc(in)) != EOF) {
+        if (type == 'S') {
+            uint16_t id, length;
+            int32_t line;
+            if (fread(&id, 2, 1, in) != 1 || id >= FAS_LOG_MAX_SITES) {
+                break;
+            }
+            int is_bytes = fgetc(in);
+            if (fread(&line, 4, 1, in) != 1 || fread(&length, 2, 1, in) != 1 || fseek(in, length, SEEK_CUR) != 0
+                || fread(&length, 2, 1, in) != 1) {
+                break;
+            }
+            free(formats[id]);
+            formats[id] = calloc(1, length + 1);
+            if (formats[id] == NULL || fread(formats[id], 1, length, in) != length) {
+                break;
+            }
+            bytes[id] = is_bytes == 1;
+        }
+        else if (type == 'R') {
+            unsigned char record[LOG_MAX_RECORD];
+            uint32_t size;
+            uint16_t id;
+            int thread = fgetc(in);
+            if (fread(record, 1, LOG_HEADER_SIZE, in) != LOG_HEADER_SIZE) {
+                break;
+            }
+            memcpy(&size, record, 4);
+            memcpy(&id, &record[4], 2);
+            if (size < LOG_HEADER_SIZE || size > sizeof(record) || fread(&record[LOG_HEADER_SIZE], 1, size - LOG_HEADER_SIZE, in) != size - LOG_HEADER_SIZE) {
+                break;
+            }
+            if (id >= FAS_LOG_MAX_SITES || formats[id] == NULL) {
+                fprintf(out, "(record for unknown site %u)\n", id);
+                continue;
+            }
+            print_record(out, offset_ns, thread, formats[id], bytes[id], record, size);
+            count++;
+        }
+        else {
+            fprintf(stderr, "corrupt log entry 0x%02X\n", type);
+            break;
+        }
+    }
+    for (int i = 0; i < FAS_LOG_MAX_SITES; i++) {
+        free(formats[i]);
+        formats[i] = NULL;
+    }
+    return count;
+}
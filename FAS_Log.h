@@ -0,0 +1,52 @@
+#pragma once
+
+/**
+ * @file FAS_Log.h
+ * @brief 호출하는 곳에서는 문자열을 만들지 않는 binary 로그
+ * @details FAS_LOG("Server: %d", x)는 호출 위치마다 하나인 FAS_LOG_SITE의 번호와 인자 값만
+ * 스레드별 ring에 복사하고 돌아온다. (잠금, malloc 없음, 시스템 콜은 기록 스레드가 잠들어 있을 때 깨우는 한 번뿐)
+ * 문자열로 바꾸는 일은 FAS_LogStart가 띄운 기록 스레드가 한다.
+ * 경로를 주면 binary 그대로 파일에 쓰고 나중에 LogDecode로 읽으며, NULL이면 stdout에 글자로 쓴다.
+ * 형식은 printf와 같고 컴파일러가 인자 형을 검사하지만 '*' 폭/정밀도, %n, %ls는 쓰지 않는다.
+ * %s 문자열은 FAS_LOG_STRING_MAX 바이트까지 복사한다.
+ * FAS_LOG_BYTES는 %s 자리에 바이트 배열을 "AA 03 ..."으로 보여준다.
+ * ring이 가득 차면 기다리지 않고 버리며, 버린 수는 다음에 기록할 때 같이 남긴다.
+ * FAS_LogStart 전이나 FAS_LogStop 후의 로그는 버린다.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define FAS_LOG_RING_SIZE 65536   //스레드별 ring 크기 (바이트), 2의 거듭제곱
+#define FAS_LOG_MAX_THREADS 32    //동시에 로그를 남기는 스레드 수
+#define FAS_LOG_MAX_SITES 1024    //FAS_LOG 호출 위치 수
+#define FAS_LOG_MAX_ARGS 8        //로그 하나의 인자 수
+#define FAS_LOG_STRING_MAX 260    //%s 하나에 복사하는 최대 바이트, Plus-E 프레임(BUFFER_SIZE) 하나가 들어감
+#define FAS_LOG_FLUSH_MS 2        //로그가 이어지는 동안 기록 스레드가 ring을 비우는 주기, 한 주기 동안 없으면 다음 로그까지 잠듦
+
+ /**@brief FAS_LOG 호출 위치 하나, 처음 부를 때 번호가 정해짐*/
+typedef struct
+{
+    const char *format;
+    const char *file;
+    int line;
+    _Atomic int id;  //0이면 아직 등록 전
+} FAS_LOG_SITE;
+
+#define FAS_LOG(format, ...) do { \
+        static FAS_LOG_SITE fas_log_site_ = { format, __FILE__, __LINE__, 0 }; \
+        if (0) { printf(format, ##__VA_ARGS__); } /* 형 검사만 */ \
+        FAS_LogWrite(&fas_log_site_, ##__VA_ARGS__); \
+    } while (0)
+
+#define FAS_LOG_BYTES(format, bytes, size) do { \
+        static FAS_LOG_SITE fas_log_site_ = { format, __FILE__, __LINE__, 0 }; \
+        FAS_LogBytes(&fas_log_site_, bytes, size); \
+    } while (0)
+
+bool FAS_LogStart(const char *path);
+void FAS_LogStop(void);
+void FAS_LogWrite(FAS_LOG_SITE *site, ...);
+void FAS_LogBytes(FAS_LOG_SITE *site, const void *bytes, int size);
+int FAS_LogDecode(FILE *in, FILE *out);
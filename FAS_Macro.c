@@ -0,0 +1,119 @@
+/**
+ * @file FAS_Macro.c
+ * @brief 미리 만들어 둔 프레임 묶음(매크로)을 정해진 횟수와 속도로 반복 전송
+ * @details 전송 간격은 시작 시각 기준의 절대 시각으로 맞추므로, 응답이 조금 늦어도 평균 속도는 유지된다.
+ * 한 주기 이상 밀리면 밀린 만큼 한꺼번에 보내지 않고 그 시점부터 다시 맞춘다.
+ */
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+#include "FAS_Macro.h"
+
+ /**@brief 기록된 프레임을 모두 지움*/
+void FAS_MacroClear(FAS_MACRO *macro) {
+    macro->count = 0;
+}
+
+ /**@brief 완성된 Plus-E 프레임 하나를 매크로 끝에 추가
+  * @param const BYTE *frame [AA][길이][sync][00][frame type][data...], sync는 전송할 때 바뀜
+  * @return 가득 찼거나 프레임이 잘못되었으면 FALSE*/
+bool FAS_MacroRecord(FAS_MACRO *macro, const BYTE *frame, int size) {
+    if (macro->count >= FAS_MACRO_MAX_FRAMES || size < 5 || size > BUFFER_SIZE || frame[1] + 2 != size) {
+        return false;
+    }
+    memcpy(macro->frame[macro->count], frame, size);
+    macro->size[macro->count] = size;
+    macro->count++;
+    return true;
+}
+
+ /**@brief result를 고치기 시작/끝낼 때 부름, 그 사이에 FAS_MacroSnapshot이 복사한 것은 버려짐*/
+static void result_begin(FAS_MACRO_RESULT *result) {
+    atomic_fetch_add_explicit(&result->seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static void result_end(FAS_MACRO_RESULT *result) {
+    atomic_fetch_add_explicit(&result->seq, 1, memory_order_release);
+}
+
+ /**@brief 매크로를 loops번 반복 전송
+  * @param int rate_hz 초당 보낼 프레임 수, 0이면 응답을 받는 대로 바로 다음 프레임을 보냄
+  * @param volatile bool *stop 다른 스레드에서 TRUE로 바꾸면 중단, NULL 가능
+  * @param FAS_MACRO_RESULT *result 프레임마다 고침 (elapsed_us 포함), 전송 중에는 FAS_MacroSnapshot으로 읽음
+  * @return 성공(FMM_OK)한 요청 수*/
+int FAS_MacroRun(int iBdID, FAS_MACRO *macro, int loops, int rate_hz, volatile bool *stop, FAS_MACRO_RESULT *result) {
+    int64_t period = rate_hz > 0 ? 1000000 / rate_hz : 0;
+    int64_t start = FAS_NowUs();
+    int64_t next = start;
+
+    result_begin(result);
+    memset(result, 0, offsetof(FAS_MACRO_RESULT, seq));
+    result_end(result);
+    for (int loop = 0; loop < loops; loop++) {
+        for (int i = 0; i < macro->count; i++) {
+            if (stop != NULL && *stop) {
+                goto done;
+            }
+            if (period > 0) {
+                int64_t now = FAS_NowUs();
+                if (now < next) {
+                    FAS_SleepUntilUs(next);
+                }
+                else if (now - next > period) {
+                    next = now;
+                }
+                next += period;
+            }
+
+            int64_t sent_at = FAS_NowUs();
+            int status = FAS_TransactFrame(iBdID, macro->frame[i], macro->size[i], NULL, 0);
+            int64_t rtt = FAS_NowUs() - sent_at;
+            bool disconnected = status == FMC_DISCONNECTED || status == FMM_NOT_OPEN;
+            result_begin(result);
+            result->sent++;
+            if (status == FMC_TIMEOUT_ERROR) {
+                result->timeout++;
+            }
+            else if (disconnected) {
+                result->failed++;
+            }
+            else {
+                result->rtt_total_us += rtt;
+                if (rtt > result->rtt_max_us) {
+                    result->rtt_max_us = rtt;
+                }
+                LatencyHist_Add(&result->rtt, (uint32_t)rtt);
+                if (status == FMM_OK) {
+                    result->ok++;
+                }
+                else {
+                    result->failed++;
+                }
+            }
+            result->elapsed_us = FAS_NowUs() - start;
+            result_end(result);
+            if (disconnected) {
+                goto done;
+            }
+        }
+    }
+done:
+    result_begin(result);
+    result->elapsed_us = FAS_NowUs() - start;
+    result_end(result);
+    return (int)result->ok;
+}
+
+ /**@brief 다른 스레드가 FAS_MacroRun으로 고치고 있는 결과를 어긋나지 않게 복사 (seqlock)*/
+void FAS_MacroSnapshot(const FAS_MACRO_RESULT *live, FAS_MACRO_RESULT *copy) {
+    uint32_t before, after;
+    do {
+        before = atomic_load_explicit(&live->seq, memory_order_acquire);
+        memcpy(copy, live, offsetof(FAS_MACRO_RESULT, seq));
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&live->seq, memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+    atomic_store_explicit(&copy->seq, after, memory_order_relaxed);
+}
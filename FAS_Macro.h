@@ -0,0 +1,42 @@
+#pragma once
+
+/**
+ * @file FAS_Macro.h
+ * @brief 미리 만들어 둔 프레임 묶음(매크로)을 정해진 횟수와 속도로 반복 전송
+ * @details 기록할 때 프레임을 완성된 형태로 저장해 두고, 전송할 때는 sync 번호만 바꿔서 보낸다.
+ * 프레임마다 응답을 기다린 뒤 다음 프레임을 보낸다.
+ * 전송 중인 결과는 다른 스레드에서 FAS_MacroSnapshot으로 복사해 볼 수 있다.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "FAS_Library.h"
+#include "LatencyHist.h"
+
+#define FAS_MACRO_MAX_FRAMES 32 //매크로 하나에 기록할 수 있는 최대 프레임 수
+
+typedef struct
+{
+    int count;
+    int size[FAS_MACRO_MAX_FRAMES];
+    BYTE frame[FAS_MACRO_MAX_FRAMES][BUFFER_SIZE];
+} FAS_MACRO;
+
+ /**@brief FAS_MacroRun 결과*/
+typedef struct
+{
+    uint64_t sent;
+    uint64_t ok;
+    uint64_t timeout;
+    uint64_t failed;       //timeout이 아닌 다른 오류 (응답의 통신상태가 FMM_OK가 아님 등)
+    int64_t elapsed_us;
+    int64_t rtt_max_us;
+    int64_t rtt_total_us;  //응답을 받은 요청의 왕복시간 합
+    LATENCY_HIST rtt;      //응답을 받은 요청의 왕복시간 분포
+    _Atomic uint32_t seq;  //FAS_MacroRun이 고치는 중이면 홀수
+} FAS_MACRO_RESULT;
+
+void FAS_MacroClear(FAS_MACRO *macro);
+bool FAS_MacroRecord(FAS_MACRO *macro, const BYTE *frame, int size);
+int FAS_MacroRun(int iBdID, FAS_MACRO *macro, int loops, int rate_hz, volatile bool *stop, FAS_MACRO_RESULT *result);
+void FAS_MacroSnapshot(const FAS_MACRO_RESULT *live, FAS_MACRO_RESULT *copy);
@@ -0,0 +1,194 @@
+/**
+ * @file FAS_Poll.c
+ * @brief 축 상태에 따라 요청 주기를 바꾸는 상태 폴링 스케줄러
+ * @details FAS_PollDue/FAS_PollUpdate는 통신을 하지 않으므로 GUI처럼 요청을 직접 보내는 쪽에서도 쓸 수 있고,
+ * FAS_PollStep은 밀린 축들의 0x40을 FAS_TransactBatch 한 번으로 보낸다.
+ */
+
+#include <string.h>
+#include "FAS_Poll.h"
+
+//FFLAG_ERRORALL ~ FFLAG_SWNEGALMT, FFLAG_ERRPOSOVERFLOW ~ FFLAG_ERRINPOSITION, FFLAG_EMGSTOP
+#define ALARM_FLAGS 0x0001FF9Ful
+
+static int interval_ms(const FAS_POLLER *poller, FAS_POLL_CLASS cls) {
+    switch (cls)
+    {
+        case FAS_POLL_FAST:
+            return poller->config.fast_ms;
+        case FAS_POLL_SLOW:
+            return poller->config.slow_ms;
+        default:
+            return poller->config.normal_ms;
+    }
+}
+
+ /**@brief 한 번에 몰아서 보낼 수 있는 최대 프레임 수, 10ms 분량*/
+static double burst(const FAS_POLLER *poller) {
+    double frames = poller->config.budget_fps / 100.0;
+    return frames > poller->config.frames_per_poll ? frames : poller->config.frames_per_poll;
+}
+
+static void refill(FAS_POLLER *poller, int64_t now) {
+    if (poller->refill_us != 0 && now > poller->refill_us) {
+        poller->tokens += (now - poller->refill_us) * (double)poller->config.budget_fps / 1e6;
+        if (poller->tokens > burst(poller)) {
+            poller->tokens = burst(poller);
+        }
+    }
+    poller->refill_us = now;
+}
+
+static FAS_POLL_AXIS *find_axis(FAS_POLLER *poller, int iBdID) {
+    for (int i = 0; i < poller->count; i++) {
+        if (poller->axes[i].iBdID == iBdID) {
+            return &poller->axes[i];
+        }
+    }
+    return NULL;
+}
+
+ /**@brief 스케줄러 초기화, budget_fps가 0 이하이면 한도 없음*/
+void FAS_PollInit(FAS_POLLER *poller, const FAS_POLL_CONFIG *config) {
+    memset(poller, 0, sizeof(*poller));
+    poller->config = *config;
+    if (poller->config.frames_per_poll < 1) {
+        poller->config.frames_per_poll = 1;
+    }
+    poller->tokens = burst(poller);
+}
+
+ /**@brief 폴링할 보드 추가, 추가하자마자 한 번 요청 대상이 됨
+  * @return 이미 있거나 가득 찼으면 FALSE*/
+bool FAS_PollAdd(FAS_POLLER *poller, int iBdID) {
+    if (poller->count >= FAS_MAX_BOARD || find_axis(poller, iBdID) != NULL) {
+        return false;
+    }
+    FAS_POLL_AXIS *axis = &poller->axes[poller->count++];
+    memset(axis, 0, sizeof(*axis));
+    axis->iBdID = iBdID;
+    axis->cls = FAS_POLL_NORMAL;
+    return true;
+}
+
+ /**@brief 축 상태로 요청 주기 분류*/
+FAS_POLL_CLASS FAS_PollClassify(EZISERVO2_AXISSTATUS status) {
+    if (status.dwValue & ALARM_FLAGS) {
+        return FAS_POLL_ALARM;
+    }
+    if (status.FFLAG_MOTIONING || status.FFLAG_ORIGINRETURNING || status.FFLAG_MOTIONACCEL || status.FFLAG_MOTIONDECEL) {
+        return FAS_POLL_FAST;
+    }
+    if (!status.FFLAG_SERVOON || status.FFLAG_INPOSITION) {
+        return FAS_POLL_SLOW;
+    }
+    return FAS_POLL_NORMAL;
+}
+
+ /**@brief 지금 요청해야 할 보드를 골라 줌, 한도 안에서 가장 오래 밀린 축부터
+  * @param int *boards 요청할 보드 ID를 받을 배열
+  * @param int max boards 크기, 0이면 wait_us만 계산
+  * @param int64_t *wait_us 다음에 요청할 보드가 생길 때까지의 시간 (NULL 가능)
+  * @return 고른 보드 수*/
+int FAS_PollDue(FAS_POLLER *poller, int64_t now_us, int *boards, int max, int64_t *wait_us) {
+    FAS_POLL_AXIS *due[FAS_MAX_BOARD];
+    int due_count = 0, picked = 0;
+    int cost = poller->config.frames_per_poll;
+    bool limited = poller->config.budget_fps > 0;
+
+    refill(poller, now_us);
+    for (int i = 0; i < poller->count; i++) {
+        if (poller->axes[i].due_us <= now_us) {
+            // 밀린 시간 순으로 삽입 정렬 (축 수가 적음)
+            int k = due_count++;
+            while (k > 0 && due[k - 1]->due_us > poller->axes[i].due_us) {
+                due[k] = due[k - 1];
+                k--;
+            }
+            due[k] = &poller->axes[i];
+        }
+    }
+    while (picked < due_count && picked < max && (!limited || poller->tokens >= cost)) {
+        FAS_POLL_AXIS *axis = due[picked];
+        boards[picked++] = axis->iBdID;
+        axis->due_us = now_us + (int64_t)interval_ms(poller, axis->cls) * 1000; //FAS_PollUpdate 전까지 다시 고르지 않도록
+        poller->frames += cost;
+        if (limited) {
+            poller->tokens -= cost;
+        }
+    }
+
+    if (wait_us != NULL) {
+        int64_t wait = INT64_MAX;
+        if (picked < due_count) {
+            // max에 걸려 남은 축은 바로 보낼 수 있고, token이 모자라 남았을 때만 채워질 때까지 기다림
+            wait = 0;
+            if (limited && poller->tokens < cost) {
+                wait = (int64_t)((cost - poller->tokens) * 1e6 / poller->config.budget_fps) + 1;
+            }
+        }
+        else {
+            for (int i = 0; i < poller->count; i++) {
+                int64_t remain = poller->axes[i].due_us - now_us;
+                if (remain < wait) {
+                    wait = remain < 0 ? 0 : remain;
+                }
+            }
+        }
+        *wait_us = wait;
+    }
+    return picked;
+}
+
+ /**@brief 요청 결과로 축의 분류와 다음 요청 시각을 정함
+  * @param bool ok 응답을 받았는지, FALSE면 status는 무시*/
+void FAS_PollUpdate(FAS_POLLER *poller, int iBdID, int64_t now_us, bool ok, DWORD status) {
+    FAS_POLL_AXIS *axis = find_axis(poller, iBdID);
+    if (axis == NULL) {
+        return;
+    }
+    axis->polls++;
+    if (!ok) {
+        axis->timeouts++;
+        axis->cls = FAS_POLL_NORMAL;
+        axis->due_us = now_us + (int64_t)poller->config.normal_ms * 1000;
+        return;
+    }
+
+    DWORD raised = status & ALARM_FLAGS & ~(axis->valid ? axis->status.dwValue : 0);
+    axis->status.dwValue = status;
+    axis->valid = true;
+    axis->cls = FAS_PollClassify(axis->status);
+    axis->due_us = now_us + (raised ? 0 : (int64_t)interval_ms(poller, axis->cls) * 1000);
+}
+
+ /**@brief 밀린 축의 상태(0x40)를 한 번에 요청하고 결과를 반영
+  * @param FAS_POLL_VISIT visit 응답을 받은 축마다 부름 (NULL 가능)
+  * @return 다음 FAS_PollStep을 부를 때까지 기다릴 시간(us)*/
+int64_t FAS_PollStep(FAS_POLLER *poller, FAS_POLL_VISIT visit, void *user) {
+    int boards[FAS_MAX_BOARD];
+    FAS_REQUEST requests[FAS_MAX_BOARD];
+    BYTE replies[FAS_MAX_BOARD][16];
+    int64_t wait;
+
+    int count = FAS_PollDue(poller, FAS_NowUs(), boards, FAS_MAX_BOARD, &wait);
+    if (count == 0) {
+        return wait;
+    }
+    for (int i = 0; i < count; i++) {
+        requests[i] = (FAS_REQUEST){ .iBdID = boards[i], .frame_type = 0x40, .reply = replies[i], .reply_size = sizeof(replies[i]) };
+    }
+    FAS_TransactBatch(requests, count);
+
+    int64_t now = FAS_NowUs();
+    for (int i = 0; i < count; i++) {
+        bool ok = requests[i].result == FMM_OK && requests[i].reply_bytes >= 10;
+        DWORD status = ok ? replies[i][6] | (DWORD)replies[i][7] << 8 | (DWORD)replies[i][8] << 16 | (DWORD)replies[i][9] << 24 : 0;
+        FAS_PollUpdate(poller, boards[i], now, ok, status);
+        if (ok && visit != NULL) {
+            visit(find_axis(poller, boards[i]), user);
+        }
+    }
+    FAS_PollDue(poller, now, NULL, 0, &wait);
+    return wait;
+}
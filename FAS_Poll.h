@@ -0,0 +1,66 @@
+#pragma once
+
+/**
+ * @file FAS_Poll.h
+ * @brief 축 상태(0x40)에 따라 요청 주기를 바꾸는 상태 폴링 스케줄러
+ * @details 마지막으로 받은 EZISERVO2_AXISSTATUS로 축마다 다음 요청 시각을 정한다.
+ * - FAST  : FFLAG_MOTIONING, FFLAG_ORIGINRETURNING, FFLAG_MOTIONACCEL, FFLAG_MOTIONDECEL 중 하나라도 켜짐
+ * - SLOW  : servo off 이거나 FFLAG_INPOSITION
+ * - NORMAL: 그 밖 (servo on 정지 중 정착 대기 등), 응답이 없을 때
+ * - ALARM : 알람 플래그가 새로 켜지면 바로 한 번 더 요청해서 확인, 계속 켜져 있으면 NORMAL 주기
+ * 모든 축의 요청은 budget_fps를 넘지 않도록 token bucket으로 제한하고, 한도에 걸리면 가장 오래 밀린 축부터 요청한다.
+ * 축이 늘어 한도를 넘으면 모든 축의 주기가 함께 늘어날 뿐 네트워크에 보내는 양은 늘지 않는다.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "FAS_Library.h"
+#include "MOTION_EziSERVO2_DEFINE.h"
+
+typedef enum
+{
+    FAS_POLL_NORMAL,
+    FAS_POLL_FAST,
+    FAS_POLL_SLOW,
+    FAS_POLL_ALARM,
+} FAS_POLL_CLASS;
+
+typedef struct
+{
+    int fast_ms;
+    int normal_ms;
+    int slow_ms;
+    int budget_fps;      //모든 드라이브를 합친 초당 프레임 수 한도
+    int frames_per_poll; //축 하나를 한 번 요청할 때 보내는 프레임 수 (상태만 1, 엔코더도 같이 읽으면 2)
+} FAS_POLL_CONFIG;
+
+typedef struct
+{
+    int iBdID;
+    EZISERVO2_AXISSTATUS status;
+    bool valid;           //status를 한 번이라도 받았는지
+    FAS_POLL_CLASS cls;
+    int64_t due_us;       //다음 요청 시각
+    uint64_t polls;
+    uint64_t timeouts;
+} FAS_POLL_AXIS;
+
+typedef struct
+{
+    FAS_POLL_CONFIG config;
+    FAS_POLL_AXIS axes[FAS_MAX_BOARD];
+    int count;
+    double tokens;
+    int64_t refill_us;
+    uint64_t frames;      //지금까지 보낸 프레임 수
+} FAS_POLLER;
+
+ /**@brief FAS_PollStep이 응답을 받은 축마다 부르는 함수*/
+typedef void (*FAS_POLL_VISIT)(const FAS_POLL_AXIS *axis, void *user);
+
+void FAS_PollInit(FAS_POLLER *poller, const FAS_POLL_CONFIG *config);
+bool FAS_PollAdd(FAS_POLLER *poller, int iBdID);
+FAS_POLL_CLASS FAS_PollClassify(EZISERVO2_AXISSTATUS status);
+int FAS_PollDue(FAS_POLLER *poller, int64_t now_us, int *boards, int max, int64_t *wait_us);
+void FAS_PollUpdate(FAS_POLLER *poller, int iBdID, int64_t now_us, bool ok, DWORD status);
+int64_t FAS_PollStep(FAS_POLLER *poller, FAS_POLL_VISIT visit, void *user);
@@ -0,0 +1,305 @@
+/**
+ * @file FAS_React.c
+ * @brief interlock 규칙 읽기/미리 만들기와 입력 감시 루프
+ * @details 한 scan은 입력 읽기(0x22) batch 하나와, 조건이 맞은 규칙이 있을 때 정지/출력 batch 하나로 이루어진다.
+ * 처음 읽은 입력은 기준으로만 쓰고 규칙을 확인하지 않는다. 입력을 읽지 못한 보드는 이전 값을 그대로 둔다.
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "FAS_React.h"
+#include "FAS_Frame.h"
+
+typedef struct
+{
+    const char *name;
+    DWORD mask;
+} REACT_NAME;
+
+static const REACT_NAME input_names[] = {
+    { "LIMITP", 0x00000001 }, { "LIMITN", 0x00000002 }, { "ORIGIN", 0x00000004 }, { "CLEARPOSITION", 0x00000008 },
+    { "PTA0", 0x00000010 }, { "PTA1", 0x00000020 }, { "PTA2", 0x00000040 }, { "PTA3", 0x00000080 },
+    { "PTA4", 0x00000100 }, { "PTA5", 0x00000200 }, { "PTA6", 0x00000400 }, { "PTA7", 0x00000800 },
+    { "PTSTART", 0x00001000 }, { "STOP", 0x00002000 }, { "PJOG", 0x00004000 }, { "NJOG", 0x00008000 },
+    { "ALARMRESET", 0x00010000 }, { "SERVOON", 0x00020000 }, { "PAUSE", 0x00040000 }, { "ORIGINSEARCH", 0x00080000 },
+    { "TEACHING", 0x00100000 }, { "ESTOP", 0x00200000 }, { "JPTIN0", 0x00400000 }, { "JPTIN1", 0x00800000 },
+    { "JPTIN2", 0x01000000 }, { "JPTSTART", 0x02000000 }, { "USERIN0", 0x04000000 }, { "USERIN1", 0x08000000 },
+    { "USERIN2", 0x10000000 }, { "USERIN3", 0x20000000 }, { "USERIN4", 0x40000000 }, { "USERIN5", 0x80000000 },
+    { "USERIN6", 0x00000200 }, { "USERIN7", 0x00000400 }, { "USERIN8", 0x00000800 },
+}; //SERVO2_IN_BITMASK_*
+
+static const REACT_NAME output_names[] = {
+    { "COMPAREOUT", 0x00000001 }, { "INPOSITION", 0x00000002 }, { "ALARM", 0x00000004 }, { "MOVING", 0x00000008 },
+    { "ACCDEC", 0x00000010 }, { "ACK", 0x00000020 }, { "END", 0x00000040 }, { "PUSHDETECT", 0x00000080 },
+    { "ORGSEARCHOK", 0x00000100 }, { "SERVOREADY", 0x00000200 }, { "BRAKE", 0x00000800 }, { "PTOUT0", 0x00001000 },
+    { "PTOUT1", 0x00002000 }, { "PTOUT2", 0x00004000 }, { "USEROUT0", 0x00008000 }, { "USEROUT1", 0x00010000 },
+    { "USEROUT2", 0x00020000 }, { "USEROUT3", 0x00040000 }, { "USEROUT4", 0x00080000 }, { "USEROUT5", 0x00100000 },
+    { "USEROUT6", 0x00200000 }, { "USEROUT7", 0x00400000 }, { "USEROUT8", 0x00800000 },
+}; //SERVO2_OUT_BITMASK_*
+
+ /**@brief "보드.이름"을 읽음
+  * @return 보드 번호가 틀렸거나 이름이 names에 없으면 FALSE*/
+static bool parse_pin(const char *text, const REACT_NAME *names, int name_count, int *iBdID, DWORD *mask) {
+    char *end;
+    long board = strtol(text, &end, 10);
+    if (end == text || *end != '.' || board < 0 || board >= FAS_MAX_BOARD) {
+        return false;
+    }
+    for (int i = 0; i < name_count; i++) {
+        if (strcasecmp(end + 1, names[i].name) == 0) {
+            *iBdID = (int)board;
+            *mask = names[i].mask;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_board(const char *text, int *iBdID) {
+    char *end;
+    long board = strtol(text, &end, 10);
+    if (end == text || *FAS_Trim(end) != '\0' || board < 0 || board >= FAS_MAX_BOARD) {
+        return false;
+    }
+    *iBdID = (int)board;
+    return true;
+}
+
+ /**@brief 동작 목록을 보드별로 모아 보낼 프레임을 만듦 (비상정지, 정지, 출력 순)*/
+static bool parse_actions(FAS_REACT_RULE *rule, char *text) {
+    bool estop[FAS_MAX_BOARD] = { false }, stop[FAS_MAX_BOARD] = { false };
+    DWORD set[FAS_MAX_BOARD] = { 0 }, clear[FAS_MAX_BOARD] = { 0 };
+    char *saveptr;
+    int actions = 0;
+
+    for (char *action = strtok_r(text, ",", &saveptr); action != NULL; action = strtok_r(NULL, ",", &saveptr)) {
+        action = FAS_Trim(action);
+        char *arg = action + strcspn(action, " \t");
+        if (*arg != '\0') {
+            *arg++ = '\0';
+        }
+        arg = FAS_Trim(arg);
+        int iBdID;
+        DWORD mask;
+        if (strcmp(action, "stop") == 0 && parse_board(arg, &iBdID)) {
+            stop[iBdID] = true;
+        }
+        else if (strcmp(action, "estop") == 0 && parse_board(arg, &iBdID)) {
+            estop[iBdID] = true;
+        }
+        else if (strcmp(action, "set") == 0 && parse_pin(arg, output_names, sizeof(output_names) / sizeof(output_names[0]), &iBdID, &mask)) {
+            set[iBdID] |= mask;
+            clear[iBdID] &= ~mask;
+        }
+        else if (strcmp(action, "clear") == 0 && parse_pin(arg, output_names, sizeof(output_names) / sizeof(output_names[0]), &iBdID, &mask)) {
+            clear[iBdID] |= mask;
+            set[iBdID] &= ~mask;
+        }
+        else {
+            fprintf(stderr, "react rule: bad action \"%s %s\"\n", action, arg);
+            return false;
+        }
+        if (++actions > FAS_REACT_MAX_ACTIONS) {
+            fprintf(stderr, "react rule: more than %d actions\n", FAS_REACT_MAX_ACTIONS);
+            return false;
+        }
+    }
+    for (int iBdID = 0; iBdID < FAS_MAX_BOARD; iBdID++) {
+        if (estop[iBdID]) {
+            rule->frames[rule->frame_count++] = (FAS_REQUEST){ .iBdID = iBdID, .frame_type = 0x32 };
+        }
+    }
+    for (int iBdID = 0; iBdID < FAS_MAX_BOARD; iBdID++) {
+        if (stop[iBdID] && !estop[iBdID]) {
+            rule->frames[rule->frame_count++] = (FAS_REQUEST){ .iBdID = iBdID, .frame_type = 0x31 };
+        }
+    }
+    for (int iBdID = 0; iBdID < FAS_MAX_BOARD; iBdID++) {
+        if (set[iBdID] != 0 || clear[iBdID] != 0) {
+            BYTE *data = rule->data[rule->frame_count];
+            FAS_PutDword(&data[0], set[iBdID]);
+            FAS_PutDword(&data[4], clear[iBdID]);
+            rule->frames[rule->frame_count++] = (FAS_REQUEST){ .iBdID = iBdID, .frame_type = 0x20, .data = data, .data_size = 8 };
+        }
+    }
+    return actions > 0;
+}
+
+ /**@brief "보드.입력 rise|fall|change -> 동작, 동작...; ..." 형식의 규칙을 읽고 보낼 프레임을 미리 만듦
+  * @details 예) "4.USERIN3 rise -> stop 7, set 2.USEROUT1; 0.LIMITP fall -> estop 0"
+  * @return 형식이 틀렸으면 FALSE (원인은 stderr)*/
+bool FAS_ReactParse(FAS_REACT_TABLE *table, const char *text) {
+    char *copy = strdup(text);
+    char *saveptr;
+    bool ok = true;
+
+    memset(table, 0, sizeof(*table));
+    if (copy == NULL) {
+        return false;
+    }
+    for (char *item = strtok_r(copy, ";", &saveptr); item != NULL && ok; item = strtok_r(NULL, ";", &saveptr)) {
+        item = FAS_Trim(item);
+        if (*item == '\0') {
+            continue;
+        }
+        char *arrow = strstr(item, "->");
+        if (arrow == NULL || table->count >= FAS_REACT_MAX_RULES) {
+            fprintf(stderr, "react rule: bad rule \"%s\"\n", item);
+            ok = false;
+            break;
+        }
+        FAS_REACT_RULE *rule = &table->rules[table->count];
+        snprintf(rule->text, sizeof(rule->text), "%s", item);
+        *arrow = '\0';
+
+        char pin[64], edge[16];
+        if (sscanf(item, "%63s %15s", pin, edge) != 2
+            || !parse_pin(pin, input_names, sizeof(input_names) / sizeof(input_names[0]), &rule->iBdID, &rule->mask)) {
+            fprintf(stderr, "react rule: bad condition \"%s\"\n", FAS_Trim(item));
+            ok = false;
+            break;
+        }
+        if (strcmp(edge, "rise") == 0) {
+            rule->edge = FAS_REACT_RISE;
+        }
+        else if (strcmp(edge, "fall") == 0) {
+            rule->edge = FAS_REACT_FALL;
+        }
+        else if (strcmp(edge, "change") == 0) {
+            rule->edge = FAS_REACT_CHANGE;
+        }
+        else {
+            fprintf(stderr, "react rule: edge must be rise, fall or change: \"%s\"\n", edge);
+            ok = false;
+            break;
+        }
+        char *actions = strdup(arrow + 2); //strtok_r을 규칙 목록에서 쓰는 중이라 따로 복사
+        ok = actions != NULL && parse_actions(rule, actions);
+        free(actions);
+        if (!ok) {
+            break;
+        }
+
+        int iBdID = rule->iBdID;
+        if (table->watch[iBdID] == 0) {
+            table->boards[table->board_count++] = iBdID;
+        }
+        table->watch[iBdID] |= rule->mask;
+        table->board_rules[iBdID][table->board_rule_count[iBdID]++] = (BYTE)table->count;
+        table->count++;
+    }
+    free(copy);
+    return ok && table->count > 0;
+}
+
+ /**@brief stop이 TRUE가 될 때까지 입력을 읽고 규칙을 확인함
+  * @param int period_us 입력을 읽는 주기, 0이면 쉬지 않고 읽음
+  * @param FAS_REACT_FIRED fired 규칙의 프레임을 보낸 뒤 부를 함수 (NULL 가능)
+  * @return 규칙이 없으면 FALSE*/
+bool FAS_ReactRun(const FAS_REACT_TABLE *table, int period_us, volatile bool *stop, FAS_REACT_FIRED fired, void *user, FAS_REACT_REPORT *report) {
+    DWORD last[FAS_MAX_BOARD] = { 0 };
+    bool seen[FAS_MAX_BOARD] = { false };
+    int64_t start = FAS_NowUs();
+    int64_t next = start;
+
+    memset(report, 0, sizeof(*report));
+    if (table->count == 0) {
+        return false;
+    }
+    while (stop == NULL || !*stop) {
+        FAS_REQUEST reads[FAS_MAX_BOARD];
+        BYTE replies[FAS_MAX_BOARD][16];
+        for (int i = 0; i < table->board_count; i++) {
+            reads[i] = (FAS_REQUEST){ .iBdID = table->boards[i], .frame_type = 0x22, .reply = replies[i], .reply_size = sizeof(replies[i]) };
+        }
+        int64_t scan_start = FAS_NowUs();
+        FAS_TransactBatch(reads, table->board_count);
+        LatencyHist_Add(&report->scan, (uint32_t)(FAS_NowUs() - scan_start));
+        report->scans++;
+
+        // 바뀐 bit가 있는 보드의 규칙만 확인하고, 맞은 규칙의 프레임을 모음
+        FAS_REQUEST batch[FAS_REACT_MAX_RULES * FAS_REACT_MAX_ACTIONS];
+        int first[FAS_REACT_MAX_RULES + 1]; //맞은 규칙 f의 프레임은 batch[first[f]] ~ batch[first[f + 1] - 1]
+        int matched[FAS_REACT_MAX_RULES];
+        int64_t edge_us[FAS_REACT_MAX_RULES];
+        int match_count = 0, count = 0;
+        for (int i = 0; i < table->board_count; i++) {
+            int iBdID = reads[i].iBdID;
+            if (reads[i].result != FMM_OK || reads[i].reply_bytes < 10) {
+                report->read_errors++;
+                continue;
+            }
+            DWORD inputs = replies[i][6] | (DWORD)replies[i][7] << 8 | (DWORD)replies[i][8] << 16 | (DWORD)replies[i][9] << 24;
+            DWORD changed = (inputs ^ last[iBdID]) & table->watch[iBdID];
+            bool baseline = !seen[iBdID];
+            last[iBdID] = inputs;
+            seen[iBdID] = true;
+            if (baseline || changed == 0) {
+                continue;
+            }
+            for (int k = 0; k < table->board_rule_count[iBdID]; k++) {
+                int r = table->board_rules[iBdID][k];
+                const FAS_REACT_RULE *rule = &table->rules[r];
+                DWORD bits = changed & rule->mask;
+                if (bits == 0 || (rule->edge == FAS_REACT_RISE && (inputs & bits) == 0) || (rule->edge == FAS_REACT_FALL && (inputs & bits) != 0)) {
+                    continue;
+                }
+                first[match_count] = count;
+                matched[match_count] = r;
+                edge_us[match_count] = reads[i].acquired_us;
+                memcpy(&batch[count], rule->frames, rule->frame_count * sizeof(FAS_REQUEST));
+                count += rule->frame_count;
+                match_count++;
+            }
+        }
+        if (match_count > 0) {
+            first[match_count] = count;
+            int64_t issued = FAS_NowUs();
+            FAS_TransactBatch(batch, count);
+            for (int f = 0; f < match_count; f++) {
+                FAS_REACT_RULE_RESULT *result = &report->rules[matched[f]];
+                int64_t sent = batch[first[f]].sent_us != 0 ? batch[first[f]].sent_us : issued;
+                int64_t latency = edge_us[f] != 0 && sent > edge_us[f] ? sent - edge_us[f] : 0;
+                for (int j = first[f]; j < first[f + 1]; j++) {
+                    result->errors += batch[j].result != FMM_OK;
+                }
+                result->fires++;
+                LatencyHist_Add(&result->latency, (uint32_t)latency);
+                if (fired != NULL) {
+                    fired(&table->rules[matched[f]], matched[f], latency, user);
+                }
+            }
+        }
+
+        if (period_us > 0) {
+            next += period_us;
+            if (next < FAS_NowUs()) {
+                next = FAS_NowUs();
+            }
+            FAS_SleepUntilUs(next);
+        }
+    }
+    report->wall_us = FAS_NowUs() - start;
+    return true;
+}
+
+ /**@brief 규칙별 실행 횟수와 입력 변화 ~ 프레임 전송 지연 출력*/
+void FAS_ReactPrint(FILE *out, const FAS_REACT_TABLE *table, const FAS_REACT_REPORT *report) {
+    fprintf(out, "%-4s %8s %7s %9s %9s %9s  %s\n", "RULE", "FIRES", "ERRORS", "P50(us)", "P99(us)", "MAX(us)", "TEXT");
+    for (int r = 0; r < table->count; r++) {
+        const FAS_REACT_RULE_RESULT *result = &report->rules[r];
+        fprintf(out, "%-4d %8" PRIu64 " %7" PRIu64, r, result->fires, result->errors);
+        if (result->fires > 0) {
+            fprintf(out, " %9u %9u %9u", LatencyHist_Percentile(&result->latency, 50), LatencyHist_Percentile(&result->latency, 99),
+                    result->latency.max_us);
+        }
+        else {
+            fprintf(out, " %9s %9s %9s", "-", "-", "-");
+        }
+        fprintf(out, "  %s\n", table->rules[r].text);
+    }
+    fprintf(out, "scans %" PRIu64 " in %.1f s, scan p50 %u us, p99 %u us, read errors %" PRIu64 "\n", report->scans, report->wall_us / 1e6,
+            LatencyHist_Percentile(&report->scan, 50), LatencyHist_Percentile(&report->scan, 99), report->read_errors);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+/**
+ * @file FAS_React.h
+ * @brief 드라이브 입력(EZISERVO2_INLOGIC)의 변화에 따라 정지/출력 프레임을 바로 보내는 interlock 규칙 처리기
+ * @details 규칙은 "4.USERIN3 rise -> stop 7, set 2.USEROUT1; 0.LIMITP fall -> estop 0, estop 1" 형식이다.
+ * 조건은 보드.입력 이름(SERVO2_IN_BITMASK_*의 이름)과 rise/fall/change, 동작은
+ * stop 보드(0x31), estop 보드(0x32), set/clear 보드.출력 이름(SERVO2_OUT_BITMASK_*, 0x20)이다.
+ * FAS_ReactParse가 규칙마다 보낼 프레임을 미리 만들어 두고(같은 보드의 출력은 0x20 하나로 합침),
+ * 보드별로 볼 입력 bit와 해당 규칙 목록을 정리해 둔다.
+ * FAS_ReactRun은 규칙에 나오는 보드의 입력(0x22)을 한 번에 읽고, 바뀐 bit가 있는 보드의 규칙만 확인해
+ * 조건이 맞은 모든 규칙의 프레임을 FAS_TransactBatch 한 번으로 보낸다.
+ * 규칙마다 입력이 바뀐 것을 드라이브가 읽은 시각(FAS_REQUEST.acquired_us)부터 프레임을 보낸 시각까지를 잰다.
+ * 입력은 읽는 주기 사이 어딘가에서 바뀌므로 실제 지연은 여기에 최대 한 주기(scan)가 더해질 수 있다.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "FAS_Library.h"
+#include "LatencyHist.h"
+
+#define FAS_REACT_MAX_RULES 32
+#define FAS_REACT_MAX_ACTIONS 8   //규칙 하나의 동작 수
+#define FAS_REACT_TEXT_SIZE 128
+
+typedef enum
+{
+    FAS_REACT_RISE,
+    FAS_REACT_FALL,
+    FAS_REACT_CHANGE,
+} FAS_REACT_EDGE;
+
+typedef struct
+{
+    char text[FAS_REACT_TEXT_SIZE];  //보고용 원문
+    int iBdID;
+    DWORD mask;                      //SERVO2_IN_BITMASK_*
+    FAS_REACT_EDGE edge;
+    FAS_REQUEST frames[FAS_REACT_MAX_ACTIONS];  //미리 만든 정지/출력 요청
+    BYTE data[FAS_REACT_MAX_ACTIONS][8];        //0x20의 [켤 bit 4][끌 bit 4]
+    int frame_count;
+} FAS_REACT_RULE;
+
+typedef struct
+{
+    FAS_REACT_RULE rules[FAS_REACT_MAX_RULES];
+    int count;
+    int boards[FAS_MAX_BOARD];                            //입력을 읽을 보드
+    int board_count;
+    DWORD watch[FAS_MAX_BOARD];                           //보드별로 규칙이 보는 입력 bit
+    BYTE board_rules[FAS_MAX_BOARD][FAS_REACT_MAX_RULES]; //보드별 규칙 번호
+    int board_rule_count[FAS_MAX_BOARD];
+} FAS_REACT_TABLE;
+
+ /**@brief 규칙 하나의 실행 결과*/
+typedef struct
+{
+    uint64_t fires;
+    uint64_t errors;       //보낸 프레임 중 응답이 FMM_OK가 아닌 수
+    LATENCY_HIST latency;  //입력 변화 ~ 프레임 전송 (us)
+} FAS_REACT_RULE_RESULT;
+
+typedef struct
+{
+    FAS_REACT_RULE_RESULT rules[FAS_REACT_MAX_RULES];
+    uint64_t scans;
+    uint64_t read_errors;  //입력을 읽지 못한 수 (보드별)
+    LATENCY_HIST scan;     //입력을 한 번 모두 읽는 데 걸린 시간 (us)
+    int64_t wall_us;
+} FAS_REACT_REPORT;
+
+ /**@brief 규칙의 프레임을 보낸 뒤 부르는 함수 (다음 읽기 전에 부르므로 오래 걸리지 않게 함)*/
+typedef void (*FAS_REACT_FIRED)(const FAS_REACT_RULE *rule, int index, int64_t latency_us, void *user);
+
+bool FAS_ReactParse(FAS_REACT_TABLE *table, const char *text);
+bool FAS_ReactRun(const FAS_REACT_TABLE *table, int period_us, volatile bool *stop, FAS_REACT_FIRED fired, void *user, FAS_REACT_REPORT *report);
+void FAS_ReactPrint(FILE *out, const FAS_REACT_TABLE *table, const FAS_REACT_REPORT *report);
@@ -0,0 +1,406 @@
+/**
+ * @file FAS_Recipe.c
+ * @brief 파라미터/I/O 할당 snapshot, 레시피 파일 읽기/쓰기, 기준과 다른 값 쓰기
+ * @details snapshot과 쓰기는 보드를 transport별 묶음으로 나눠 묶음마다 스레드를 띄운다.
+ * 묶음 안에서는 먼저 보드마다 요청 하나로 응답하는지 보고, 응답한 보드의 나머지 요청을 FAS_TransactBatch 한 번으로 보낸다.
+ * 꺼진 드라이브 때문에 요청마다 timeout을 기다리지 않기 위해서이다.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "FAS_Recipe.h"
+#include "FAS_Frame.h"
+
+#define RECIPE_HEADER "# FAS recipe v1"
+#define BOARD_REQUESTS (MAX_SERVO2_PARAM + FAS_RECIPE_IO_PINS + 1) //파라미터 + I/O + ROM 저장
+
+ /**@brief 같은 transport를 쓰는 보드 묶음, 스레드 하나가 처리함*/
+typedef struct
+{
+    char key[FAS_ADDRESS_SIZE];
+    int index[FAS_MAX_BOARD];  //boards[]/recipes[] 안의 위치
+    int count;
+    pthread_t thread;
+    const int *boards;
+    FAS_RECIPE *recipes;        //snapshot 결과
+    const FAS_RECIPE *golden;   //쓰기할 때만
+    const FAS_RECIPE *actual;
+    bool save_rom;
+    int written;
+} RECIPE_GROUP;
+
+static void *snapshot_thread(void *arg) {
+    RECIPE_GROUP *group = arg;
+    FAS_REQUEST *requests = calloc((size_t)group->count * BOARD_REQUESTS, sizeof(FAS_REQUEST));
+    BYTE (*replies)[BUFFER_SIZE] = calloc((size_t)group->count * BOARD_REQUESTS, BUFFER_SIZE);
+    if (requests == NULL || replies == NULL) {
+        perror("recipe snapshot");
+        free(requests);
+        free(replies);
+        return NULL;
+    }
+    BYTE numbers[MAX_SERVO2_PARAM]; //요청 data로 쓰는 파라미터/pin 번호 (pin 수보다 파라미터 수가 많음)
+    for (int i = 0; i < MAX_SERVO2_PARAM; i++) {
+        numbers[i] = (BYTE)i;
+    }
+
+    // 파라미터 0 하나로 응답하는 보드를 먼저 가려냄
+    for (int i = 0; i < group->count; i++) {
+        requests[i] = (FAS_REQUEST){ .iBdID = group->boards[group->index[i]], .frame_type = 0x13, .data = &numbers[0], .data_size = 1,
+                                     .reply = replies[i], .reply_size = BUFFER_SIZE };
+    }
+    FAS_TransactBatch(requests, group->count);
+    int alive[FAS_MAX_BOARD];
+    int alive_count = 0;
+    for (int i = 0; i < group->count; i++) {
+        if (requests[i].result == FMM_OK && requests[i].reply_bytes >= 10) {
+            group->recipes[group->index[i]].params[0] = (int32_t)FAS_GetDword(&replies[i][6]);
+            alive[alive_count++] = i;
+        }
+    }
+
+    int count = 0;
+    for (int a = 0; a < alive_count; a++) {
+        int iBdID = group->boards[group->index[alive[a]]];
+        for (int no = 1; no < MAX_SERVO2_PARAM; no++, count++) {
+            requests[count] = (FAS_REQUEST){ .iBdID = iBdID, .frame_type = 0x13, .data = &numbers[no], .data_size = 1,
+                                             .reply = replies[count], .reply_size = BUFFER_SIZE };
+        }
+        for (int pin = 0; pin < FAS_RECIPE_IO_PINS; pin++, count++) {
+            requests[count] = (FAS_REQUEST){ .iBdID = iBdID, .frame_type = 0x25, .data = &numbers[pin], .data_size = 1,
+                                             .reply = replies[count], .reply_size = BUFFER_SIZE };
+        }
+    }
+    FAS_TransactBatch(requests, count);
+
+    const int per_board = MAX_SERVO2_PARAM - 1 + FAS_RECIPE_IO_PINS;
+    for (int a = 0; a < alive_count; a++) {
+        FAS_RECIPE *recipe = &group->recipes[group->index[alive[a]]];
+        FAS_REQUEST *request = &requests[a * per_board];
+        BYTE (*reply)[BUFFER_SIZE] = &replies[a * per_board];
+        bool complete = true;
+        for (int no = 1; no < MAX_SERVO2_PARAM; no++, request++, reply++) {
+            complete &= request->result == FMM_OK && request->reply_bytes >= 10;
+            recipe->params[no] = (int32_t)FAS_GetDword(&(*reply)[6]);
+        }
+        for (int pin = 0; pin < FAS_RECIPE_IO_PINS; pin++, request++, reply++) {
+            complete &= request->result == FMM_OK && request->reply_bytes >= 11;
+            recipe->io[pin].logic = FAS_GetDword(&(*reply)[6]);
+            recipe->io[pin].level = (*reply)[10];
+        }
+        recipe->valid = complete;
+    }
+    free(requests);
+    free(replies);
+    return NULL;
+}
+
+static void *push_thread(void *arg) {
+    RECIPE_GROUP *group = arg;
+    FAS_REQUEST *requests = calloc((size_t)group->count * BOARD_REQUESTS, sizeof(FAS_REQUEST));
+    BYTE (*data)[6] = calloc((size_t)group->count * BOARD_REQUESTS, 6);
+    if (requests == NULL || data == NULL) {
+        perror("recipe push");
+        free(requests);
+        free(data);
+        return NULL;
+    }
+
+    int count = 0;
+    for (int i = 0; i < group->count; i++) {
+        int k = group->index[i];
+        const FAS_RECIPE *golden = &group->golden[k];
+        const FAS_RECIPE *actual = &group->actual[k];
+        int first = count;
+        if (!actual->valid) {
+            continue; //읽지 못한 값이 있는 드라이브에는 쓰지 않음
+        }
+        for (int no = 0; no < MAX_SERVO2_PARAM; no++) {
+            if (golden->params[no] != actual->params[no]) {
+                data[count][0] = (BYTE)no;
+                FAS_PutDword(&data[count][1], (DWORD)golden->params[no]);
+                requests[count] = (FAS_REQUEST){ .iBdID = group->boards[k], .frame_type = 0x12, .data = data[count], .data_size = 5 };
+                count++;
+            }
+        }
+        for (int pin = 0; pin < FAS_RECIPE_IO_PINS; pin++) {
+            if (golden->io[pin].logic != actual->io[pin].logic || golden->io[pin].level != actual->io[pin].level) {
+                data[count][0] = (BYTE)pin;
+                FAS_PutDword(&data[count][1], golden->io[pin].logic);
+                data[count][5] = golden->io[pin].level;
+                requests[count] = (FAS_REQUEST){ .iBdID = group->boards[k], .frame_type = 0x24, .data = data[count], .data_size = 6 };
+                count++;
+            }
+        }
+        if (group->save_rom && count > first) {
+            requests[count++] = (FAS_REQUEST){ .iBdID = group->boards[k], .frame_type = 0x10 };
+        }
+    }
+    FAS_TransactBatch(requests, count);
+    for (int i = 0; i < count; i++) {
+        if (requests[i].frame_type == 0x10) {
+            if (requests[i].result != FMM_OK) {
+                fprintf(stderr, "%s: ROM save failed (%d)\n", FAS_BoardAddress(requests[i].iBdID), requests[i].result);
+            }
+        }
+        else if (requests[i].result == FMM_OK) {
+            group->written++;
+        }
+        else {
+            fprintf(stderr, "%s: frame 0x%02X item %d write failed (%d)\n",
+                    FAS_BoardAddress(requests[i].iBdID), requests[i].frame_type, requests[i].data[0], requests[i].result);
+        }
+    }
+    free(requests);
+    free(data);
+    return NULL;
+}
+
+ /**@brief boards를 transport별로 묶어 묶음마다 스레드로 work를 돌리고 모두 끝날 때까지 기다림
+  * @param const RECIPE_GROUP *common 모든 묶음에 똑같이 넣을 항목 (boards, recipes 등)
+  * @return 묶음 수*/
+static int run_groups(const RECIPE_GROUP *common, int count, RECIPE_GROUP *groups, void *(*work)(void *)) {
+    int group_count = 0;
+    for (int i = 0; i < count; i++) {
+        const char *address = FAS_BoardAddress(common->boards[i]);
+        if (address == NULL) {
+            continue;
+        }
+        char key[FAS_ADDRESS_SIZE];
+        snprintf(key, sizeof(key), "%s", address);
+        char *mark = strchr(key, '#'); //RS-485는 '#' 앞의 포트가 같으면 같은 버스
+        if (mark != NULL) {
+            *mark = '\0';
+        }
+        int g = 0;
+        while (g < group_count && strcmp(groups[g].key, key) != 0) {
+            g++;
+        }
+        if (g == group_count) {
+            groups[g] = *common;
+            snprintf(groups[g].key, sizeof(groups[g].key), "%s", key);
+            group_count++;
+        }
+        groups[g].index[groups[g].count++] = i;
+    }
+
+    bool started[FAS_MAX_BOARD] = { false };
+    for (int g = 0; g < group_count; g++) {
+        started[g] = pthread_create(&groups[g].thread, NULL, work, &groups[g]) == 0;
+        if (!started[g]) {
+            work(&groups[g]);
+        }
+    }
+    for (int g = 0; g < group_count; g++) {
+        if (started[g]) {
+            pthread_join(groups[g].thread, NULL);
+        }
+    }
+    return group_count;
+}
+
+ /**@brief 보드들의 파라미터 전체와 I/O 할당을 동시에 읽음
+  * @param const int *boards 보드 ID 목록 (최대 FAS_MAX_BOARD)
+  * @param FAS_RECIPE *recipes boards와 같은 순서로 결과를 채움, 응답이 없거나 일부만 읽은 보드는 valid가 FALSE
+  * @return 모든 값을 읽은 보드 수*/
+int FAS_RecipeSnapshot(const int *boards, int count, FAS_RECIPE *recipes) {
+    RECIPE_GROUP groups[FAS_MAX_BOARD];
+
+    if (count > FAS_MAX_BOARD) {
+        count = FAS_MAX_BOARD;
+    }
+    for (int i = 0; i < count; i++) {
+        memset(&recipes[i], 0, sizeof(recipes[i]));
+        const char *address = FAS_BoardAddress(boards[i]);
+        snprintf(recipes[i].address, sizeof(recipes[i].address), "%s", address != NULL ? address : "");
+    }
+    RECIPE_GROUP common = { .boards = boards, .recipes = recipes };
+    run_groups(&common, count, groups, snapshot_thread);
+
+    int valid = 0;
+    for (int i = 0; i < count; i++) {
+        valid += recipes[i].valid;
+    }
+    return valid;
+}
+
+ /**@brief actual에서 golden과 다른 값을 찾음
+  * @return 다른 값의 수 (max_deltas보다 많으면 deltas에는 앞의 max_deltas개만 채움)*/
+int FAS_RecipeDiff(const FAS_RECIPE *golden, const FAS_RECIPE *actual, FAS_RECIPE_DELTA *deltas, int max_deltas) {
+    int count = 0;
+
+    for (int no = 0; no < MAX_SERVO2_PARAM; no++) {
+        if (golden->params[no] != actual->params[no]) {
+            if (count < max_deltas) {
+                deltas[count] = (FAS_RECIPE_DELTA){ .item = FAS_RECIPE_PARAM, .index = no,
+                                                    .expected = golden->params[no], .actual = actual->params[no] };
+            }
+            count++;
+        }
+    }
+    for (int pin = 0; pin < FAS_RECIPE_IO_PINS; pin++) {
+        if (golden->io[pin].logic != actual->io[pin].logic || golden->io[pin].level != actual->io[pin].level) {
+            if (count < max_deltas) {
+                deltas[count] = (FAS_RECIPE_DELTA){ .item = FAS_RECIPE_IO_MAP, .index = pin,
+                                                    .expected = (int32_t)golden->io[pin].logic, .actual = (int32_t)actual->io[pin].logic,
+                                                    .expected_level = golden->io[pin].level, .actual_level = actual->io[pin].level };
+            }
+            count++;
+        }
+    }
+    return count;
+}
+
+ /**@brief 보드마다 golden과 다른 값(actual 기준)만 동시에 씀 (파라미터 0x12, I/O 할당 0x24)
+  * @param const FAS_RECIPE *golden boards와 같은 순서의 기준 레시피
+  * @param const FAS_RECIPE *actual 방금 읽은 FAS_RecipeSnapshot 결과, valid가 FALSE인 보드는 건너뜀
+  * @param bool save_rom 값을 쓴 보드는 마지막에 ROM에 저장 (0x10)
+  * @return 쓴 값의 수*/
+int FAS_RecipePush(const int *boards, int count, const FAS_RECIPE *golden, const FAS_RECIPE *actual, bool save_rom) {
+    RECIPE_GROUP groups[FAS_MAX_BOARD];
+
+    if (count > FAS_MAX_BOARD) {
+        count = FAS_MAX_BOARD;
+    }
+    RECIPE_GROUP common = { .boards = boards, .golden = golden, .actual = actual, .save_rom = save_rom };
+    int group_count = run_groups(&common, count, groups, push_thread);
+
+    int written = 0;
+    for (int g = 0; g < group_count; g++) {
+        written += groups[g].written;
+    }
+    return written;
+}
+
+ /**@brief address와 같은 주소의 레시피, 없으면 FAS_RECIPE_ANY 레시피
+  * @return 둘 다 없으면 NULL*/
+const FAS_RECIPE *FAS_RecipeFind(const FAS_RECIPE *recipes, int count, const char *address) {
+    const FAS_RECIPE *any = NULL;
+    for (int i = 0; i < count; i++) {
+        if (strcmp(recipes[i].address, address) == 0) {
+            return &recipes[i];
+        }
+        if (strcmp(recipes[i].address, FAS_RECIPE_ANY) == 0) {
+            any = &recipes[i];
+        }
+    }
+    return any;
+}
+
+ /**@brief 레시피 파일을 읽음, 형식이 맞지 않는 줄은 건너뜀
+  * @return 읽은 레시피 수, 파일을 열 수 없으면 -1*/
+int FAS_RecipeLoad(const char *path, FAS_RECIPE *recipes, int max_recipes) {
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    char line[2048];
+    int count = 0;
+    while (fgets(line, sizeof(line), fp) != NULL && count < max_recipes) {
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        // address \t 파라미터,... \t logic:level,...
+        FAS_RECIPE *recipe = &recipes[count];
+        memset(recipe, 0, sizeof(*recipe));
+        char *params = strchr(line, '\t');
+        char *io = params != NULL ? strchr(params + 1, '\t') : NULL;
+        if (io == NULL) {
+            continue;
+        }
+        *params++ = '\0';
+        *io++ = '\0';
+        size_t length = strlen(line);
+        if (length >= sizeof(recipe->address)) {
+            fprintf(stderr, "%s: %.20s...: address longer than %zu characters\n", path, line, sizeof(recipe->address) - 1);
+            continue;
+        }
+        memcpy(recipe->address, line, length + 1);
+
+        char *cursor = params;
+        int no = 0;
+        while (no < MAX_SERVO2_PARAM) {
+            char *end;
+            recipe->params[no] = (int32_t)strtol(cursor, &end, 10);
+            if (end == cursor) {
+                break;
+            }
+            no++;
+            cursor = *end == ',' ? end + 1 : end;
+        }
+        cursor = io;
+        int pin = 0;
+        while (pin < FAS_RECIPE_IO_PINS) {
+            char *end;
+            recipe->io[pin].logic = strtoul(cursor, &end, 16);
+            if (end == cursor || *end != ':') {
+                break;
+            }
+            recipe->io[pin++].level = (BYTE)strtoul(end + 1, &end, 10);
+            cursor = *end == ',' ? end + 1 : end;
+        }
+        if (no != MAX_SERVO2_PARAM || pin != FAS_RECIPE_IO_PINS) {
+            fprintf(stderr, "%s: %s: expected %d params and %d pins\n", path, recipe->address, MAX_SERVO2_PARAM, FAS_RECIPE_IO_PINS);
+            continue;
+        }
+        recipe->valid = true;
+        count++;
+    }
+    fclose(fp);
+    return count;
+}
+
+ /**@brief 레시피를 파일에 씀, valid가 FALSE인 레시피는 빼고 씀
+  * @details 임시 파일에 쓰고 rename하므로 쓰는 도중에 멈춰도 이전 파일이 남는다.
+  * @return 성공 시 TRUE*/
+bool FAS_RecipeSave(const char *path, const FAS_RECIPE *recipes, int count) {
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *fp = fopen(tmp, "w");
+    if (fp == NULL) {
+        perror(tmp);
+        return false;
+    }
+
+    fprintf(fp, "%s\n# address\tparam 0 ~ %d\tpin 0 ~ %d logic mask(hex):level\n", RECIPE_HEADER, MAX_SERVO2_PARAM - 1, FAS_RECIPE_IO_PINS - 1);
+    for (int i = 0; i < count; i++) {
+        if (!recipes[i].valid) {
+            continue;
+        }
+        fprintf(fp, "%s\t", recipes[i].address);
+        for (int no = 0; no < MAX_SERVO2_PARAM; no++) {
+            fprintf(fp, "%s%d", no > 0 ? "," : "", recipes[i].params[no]);
+        }
+        fputc('\t', fp);
+        for (int pin = 0; pin < FAS_RECIPE_IO_PINS; pin++) {
+            fprintf(fp, "%s%X:%u", pin > 0 ? "," : "", recipes[i].io[pin].logic, recipes[i].io[pin].level);
+        }
+        fputc('\n', fp);
+    }
+    bool ok = fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+    ok &= fclose(fp) == 0;
+    if (!ok || rename(tmp, path) != 0) {
+        fprintf(stderr, "%s: save failed: %s\n", path, strerror(errno));
+        unlink(tmp);
+        return false;
+    }
+    return true;
+}
+
+ /**@brief 다른 값 하나를 "param 3: 100 -> 200" / "OUT2(pin 14): 4:1 -> 0:0" 형식으로 출력 (기준 -> 실제)*/
+void FAS_RecipePrintDelta(FILE *fp, const FAS_RECIPE_DELTA *delta) {
+    if (delta->item == FAS_RECIPE_PARAM) {
+        fprintf(fp, "param %d: %d -> %d\n", delta->index, delta->expected, delta->actual);
+    }
+    else {
+        bool input = delta->index < FAS_RECIPE_IN_PINS;
+        fprintf(fp, "%s%d(pin %d): %X:%u -> %X:%u\n", input ? "IN" : "OUT", input ? delta->index : delta->index - FAS_RECIPE_IN_PINS,
+                delta->index, (DWORD)delta->expected, delta->expected_level, (DWORD)delta->actual, delta->actual_level);
+    }
+}
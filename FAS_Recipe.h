@@ -0,0 +1,63 @@
+#pragma once
+
+/**
+ * @file FAS_Recipe.h
+ * @brief 드라이브의 파라미터 전체와 I/O 할당을 한꺼번에 읽어(snapshot) 기준 레시피와 비교하고 다른 값만 써 넣음
+ * @details 파라미터는 FM_EZISERVO2_PARAM 전체(0x13 읽기, 0x12 쓰기),
+ * I/O 할당은 입력 pin 0 ~ 11과 출력 pin 12 ~ 21의 [logic mask][level](0x25 읽기, 0x24 쓰기)이다.
+ * logic mask는 입력 pin이면 SERVO2_IN_BITMASK_*, 출력 pin이면 SERVO2_OUT_BITMASK_* 이고
+ * 켜진 bit 번호 + 1이 EZISERVO2_INLOGIC_LIST / EZISERVO2_OUTLOGIC_LIST 번호이다 (0은 할당 없음).
+ * 여러 보드를 transport별로 나눠 스레드마다 FAS_TransactBatch 한 번으로 처리하므로,
+ * 드라이브마다 따로 연결된 Ethernet 보드는 모두 동시에 읽히고 같은 RS-485 버스의 보드는 한 스레드에서 이어서 읽힌다.
+ * 레시피 파일은 한 줄에 드라이브 하나인 탭 구분 텍스트이며, 주소가 "*"인 줄은 다른 줄에 없는 모든 드라이브에 쓰인다.
+ * 처리하는 동안에는 해당 보드로 다른 요청을 보내거나 FAS_Close 하지 않는다.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "FAS_Library.h"
+#include "MOTION_EziSERVO2_DEFINE.h"
+
+#define FAS_RECIPE_IN_PINS 12   //SERVO2_IN_PIN_CNT
+#define FAS_RECIPE_IO_PINS 22   //SERVO2_IN_PIN_CNT + SERVO2_OUT_PIN_CNT, pin 번호 12부터가 출력
+#define FAS_RECIPE_ANY "*"      //모든 드라이브에 쓰이는 레시피 주소
+
+typedef struct
+{
+    DWORD logic;  //SERVO2_IN_BITMASK_* 또는 SERVO2_OUT_BITMASK_*, 0은 할당 없음
+    BYTE level;   //0: active low, 1: active high
+} FAS_RECIPE_IO;
+
+typedef struct
+{
+    char address[FAS_ADDRESS_SIZE];  //FAS_BoardAddress 또는 FAS_RECIPE_ANY
+    int32_t params[MAX_SERVO2_PARAM];
+    FAS_RECIPE_IO io[FAS_RECIPE_IO_PINS];
+    bool valid;                      //snapshot에서 모든 값을 읽었으면 TRUE
+} FAS_RECIPE;
+
+typedef enum
+{
+    FAS_RECIPE_PARAM,
+    FAS_RECIPE_IO_MAP,
+} FAS_RECIPE_ITEM;
+
+ /**@brief 기준과 다른 값 하나*/
+typedef struct
+{
+    FAS_RECIPE_ITEM item;
+    int index;             //파라미터 번호 또는 pin 번호
+    int32_t expected;      //기준 값 (I/O는 logic mask)
+    int32_t actual;
+    BYTE expected_level;   //I/O만
+    BYTE actual_level;
+} FAS_RECIPE_DELTA;
+
+int FAS_RecipeSnapshot(const int *boards, int count, FAS_RECIPE *recipes);
+int FAS_RecipeDiff(const FAS_RECIPE *golden, const FAS_RECIPE *actual, FAS_RECIPE_DELTA *deltas, int max_deltas);
+int FAS_RecipePush(const int *boards, int count, const FAS_RECIPE *golden, const FAS_RECIPE *actual, bool save_rom);
+const FAS_RECIPE *FAS_RecipeFind(const FAS_RECIPE *recipes, int count, const char *address);
+int FAS_RecipeLoad(const char *path, FAS_RECIPE *recipes, int max_recipes);
+bool FAS_RecipeSave(const char *path, const FAS_RECIPE *recipes, int count);
+void FAS_RecipePrintDelta(FILE *fp, const FAS_RECIPE_DELTA *delta);
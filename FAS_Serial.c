@@ -0,0 +1,444 @@
+/**
+ * @file FAS_Serial.c
+ * @brief Ezi-SERVO II Plus-R(RS-485) transport
+ * @details termios로 포트를 raw 모드(8N1, 최대 921600 baud)로 열고, Plus-E 형식 프레임을 Plus-R 프레임으로 바꾸어 보낸다.
+ * 한 multi-drop 버스에 연결된 보드들은 같은 포트를 공유하며 iBdID를 Slave ID로 쓴다.
+ * 여러 요청을 한 번에 받으면(batch) 다음 요청을 미리 인코딩해 두고, 응답의 끝(AA EE)을 보는 즉시 다음 요청을 써서
+ * 버스가 노는 시간을 줄인다. RS-485는 half-duplex라 응답이 오기 전에 다음 요청을 보내지는 않는다.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/serial.h>
+#include "FAS_Serial.h"
+#include "FAS_Trace.h"
+#include "FAS_Transport.h"
+
+enum { SER_IDLE = 0, SER_HEADER, SER_BODY, SER_BODY_AA };
+
+static const uint16_t crc16_table[256] = {
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040,
+};
+
+/************************************************************************************************************************************
+ ******************************************************* Plus-R 프레임 **************************************************************
+ ************************************************************************************************************************************/
+
+ /**@brief Modbus CRC16, CRC까지 포함해서 계산하면 0이 나옴*/
+uint16_t FAS_CRC16(const BYTE *data, int size) {
+    uint16_t crc = 0xFFFF;
+    for (int i = 0; i < size; i++) {
+        crc = (crc >> 8) ^ crc16_table[(crc ^ data[i]) & 0xFF];
+    }
+    return crc;
+}
+
+static int stuff(BYTE *out, int pos, BYTE c) {
+    out[pos++] = c;
+    if (c == 0xAA) {
+        out[pos++] = 0xAA;
+    }
+    return pos;
+}
+
+ /**@brief Plus-R 프레임 하나를 만듦
+  * @param BYTE *out 최소 SERIAL_FRAME_SIZE 바이트
+  * @return 프레임 길이*/
+int FAS_SerialEncode(BYTE slave, BYTE frame_type, const BYTE *data, int size, BYTE *out) {
+    uint16_t crc = 0xFFFF;
+    int pos = 0;
+
+    out[pos++] = 0xAA;
+    out[pos++] = 0xCC;
+    crc = (crc >> 8) ^ crc16_table[(crc ^ slave) & 0xFF];
+    pos = stuff(out, pos, slave);
+    crc = (crc >> 8) ^ crc16_table[(crc ^ frame_type) & 0xFF];
+    pos = stuff(out, pos, frame_type);
+    for (int i = 0; i < size; i++) {
+        crc = (crc >> 8) ^ crc16_table[(crc ^ data[i]) & 0xFF];
+        pos = stuff(out, pos, data[i]);
+    }
+    pos = stuff(out, pos, crc & 0xFF);
+    pos = stuff(out, pos, crc >> 8);
+    out[pos++] = 0xAA;
+    out[pos++] = 0xEE;
+    return pos;
+}
+
+ /**@brief 수신 바이트를 하나씩 넣어 프레임을 찾음
+  * @return 1 프레임 완성(parser->body, parser->size), -1 CRC/형식 오류, 0 진행 중*/
+int FAS_SerialParse(FAS_SERIAL_PARSER *parser, BYTE c) {
+    switch (parser->state)
+    {
+        case SER_IDLE:
+            if (c == 0xAA) {
+                parser->state = SER_HEADER;
+            }
+            return 0;
+        case SER_HEADER:
+            if (c == 0xCC) {
+                parser->state = SER_BODY;
+                parser->size = 0;
+            }
+            else if (c != 0xAA) {
+                parser->state = SER_IDLE;
+            }
+            return 0;
+        case SER_BODY:
+            if (c == 0xAA) {
+                parser->state = SER_BODY_AA;
+                return 0;
+            }
+            break;
+        case SER_BODY_AA:
+            if (c == 0xEE) {
+                parser->state = SER_IDLE;
+                if (parser->size < 4 || FAS_CRC16(parser->body, parser->size) != 0) {
+                    return -1;
+                }
+                parser->size -= 2;
+                return 1;
+            }
+            if (c == 0xCC) { // 이전 프레임이 중간에 끊기고 새 프레임이 시작됨
+                parser->state = SER_BODY;
+                parser->size = 0;
+                return -1;
+            }
+            if (c != 0xAA) {
+                parser->state = SER_IDLE;
+                return -1;
+            }
+            parser->state = SER_BODY;
+            break;
+    }
+    if (parser->size >= (int)sizeof(parser->body)) {
+        parser->state = SER_IDLE;
+        return -1;
+    }
+    parser->body[parser->size++] = c;
+    return 0;
+}
+
+/************************************************************************************************************************************
+ ******************************************************* RS-485 transport ***********************************************************
+ ************************************************************************************************************************************/
+
+typedef struct FAS_SERIAL
+{
+    FAS_TRANSPORT base;
+    char device[64];
+    int baud;
+    FAS_SERIAL_PARSER parser;
+    BYTE rx[256];                //아직 parser에 넣지 않은 수신 바이트
+    int rx_pos, rx_len;
+    BYTE sync[FAS_MAX_BOARD];    //보드별 마지막 요청의 sync, 응답을 Plus-E 형식으로 바꿀 때 채움
+    struct FAS_SERIAL *next;
+} FAS_SERIAL;
+
+static FAS_SERIAL *serial_ports;
+FAS_POOL_DEFINE(FAS_SerialPool, FAS_SERIAL);
+
+static const struct
+{
+    int baud;
+    speed_t speed;
+} serial_speeds[] = {
+    { 9600, B9600 }, { 19200, B19200 }, { 38400, B38400 }, { 57600, B57600 },
+    { 115200, B115200 }, { 230400, B230400 }, { 460800, B460800 }, { 921600, B921600 },
+};
+
+ /**@brief baud rate에서 프레임 하나가 오가는 시간을 더한 timeout*/
+static int frame_timeout(FAS_SERIAL *port, int timeout_ms) {
+    return timeout_ms + (2 * SERIAL_FRAME_SIZE * 10 * 1000) / port->baud;
+}
+
+static int write_all(int fd, const BYTE *src, int size) {
+    int done = 0;
+    while (done < size) {
+        FAS_TRACE_BEGIN(span, "write", size - done);
+        ssize_t n = write(fd, src + done, size - done);
+        FAS_TRACE_END(span);
+        if (n < 0) {
+            if (errno == EAGAIN) {
+                struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+                FAS_TRACE_BEGIN(wait, "poll", 100);
+                poll(&pfd, 1, 100);
+                FAS_TRACE_END(wait);
+                continue;
+            }
+            perror("serial write failed");
+            return -1;
+        }
+        done += n;
+    }
+    return done;
+}
+
+ /**@brief Slave ID가 slave인 프레임 하나를 받아 Plus-E 형식으로 바꿈
+  * @return frame 길이, timeout이면 -1, CRC/형식이 틀린 프레임을 받으면 FAS_RECV_CRC_ERROR
+  * (버스에는 요청 하나의 응답만 오므로 틀린 프레임은 기다리던 응답으로 봄)
+  * 응답에는 sync가 없으므로 deadline이 지나서 끝난 프레임은 버리고 timeout으로 돌려줌*/
+static int serial_read_frame(FAS_SERIAL *port, int slave, BYTE *frame, int size, int timeout_ms) {
+    int64_t deadline = FAS_NowUs() / 1000 + timeout_ms;
+    FAS_SERIAL_PARSER *parser = &port->parser;
+
+    while (1) {
+        while (port->rx_pos < port->rx_len) {
+            int parsed = FAS_SerialParse(parser, port->rx[port->rx_pos++]);
+            if (parsed < 0) {
+                return FAS_RECV_CRC_ERROR;
+            }
+            if (parsed != 1 || parser->body[0] != slave) {
+                continue;
+            }
+            if (FAS_NowUs() / 1000 > deadline) {
+                return -1;
+            }
+            //[Slave ID][frame type][통신상태][data...] -> [AA][길이][sync][00][frame type][통신상태][data...]
+            int data_size = parser->size - 2;
+            if (data_size + 5 > size) {
+                return -1;
+            }
+            frame[0] = 0xAA;
+            frame[1] = 3 + data_size;
+            frame[2] = port->sync[slave];
+            frame[3] = 0x00;
+            frame[4] = parser->body[1];
+            memcpy(&frame[5], &parser->body[2], data_size);
+            return data_size + 5;
+        }
+
+        int remain = deadline - FAS_NowUs() / 1000;
+        if (remain <= 0) {
+            return -1;
+        }
+        struct pollfd pfd = { .fd = port->base.fd, .events = POLLIN };
+        FAS_TRACE_BEGIN(wait, "poll", remain);
+        int ready = poll(&pfd, 1, remain);
+        FAS_TRACE_END(wait);
+        if (ready <= 0) {
+            return -1;
+        }
+        FAS_TRACE_BEGIN(span, "read", 0);
+        ssize_t n = read(port->base.fd, port->rx, sizeof(port->rx));
+        span.arg = (int)n;
+        FAS_TRACE_END(span);
+        if (n <= 0) {
+            continue;
+        }
+        port->rx_pos = 0;
+        port->rx_len = n;
+    }
+}
+
+ /**@brief 요청을 쓰기 전에 받아 둔 바이트와 parser 상태를 버림
+  * @details Plus-R 응답에는 sync가 없어 timeout 뒤 늦게 온 응답을 다음 요청의 응답과 구분할 수 없으므로
+  * 요청마다 수신 buffer를 비우고 그 뒤에 온 프레임만 응답으로 본다.*/
+static void discard_input(FAS_SERIAL *port) {
+    tcflush(port->base.fd, TCIFLUSH);
+    port->rx_pos = 0;
+    port->rx_len = 0;
+    port->parser.state = SER_IDLE;
+}
+
+static int serial_send(FAS_TRANSPORT *tp, int iBdID, const BYTE *frame, int size) {
+    FAS_SERIAL *port = (FAS_SERIAL *)tp;
+    BYTE out[SERIAL_FRAME_SIZE];
+
+    if (size < 5 || iBdID < 0 || iBdID >= FAS_MAX_BOARD) {
+        return -1;
+    }
+    port->sync[iBdID] = frame[2];
+    int length = FAS_SerialEncode(iBdID, frame[4], &frame[5], size - 5, out);
+    discard_input(port);
+    return write_all(tp->fd, out, length) < 0 ? -1 : size;
+}
+
+static int serial_recv(FAS_TRANSPORT *tp, int iBdID, BYTE *frame, int size, int timeout_ms) {
+    FAS_SERIAL *port = (FAS_SERIAL *)tp;
+    return serial_read_frame(port, iBdID, frame, size, frame_timeout(port, timeout_ms));
+}
+
+static int encode_request(const FAS_REQUEST *request, BYTE *out) {
+    return FAS_SerialEncode(request->iBdID, request->frame_type, request->data, request->data_size, out);
+}
+
+ /**@brief 한 버스에 걸린 여러 Slave에 요청을 연달아 보냄
+  * @details 요청 i를 보낸 뒤 응답을 기다리는 동안 요청 i+1을 인코딩해 두고, 응답 끝을 받자마자 바로 쓴다.*/
+static void serial_batch(FAS_TRANSPORT *tp, FAS_REQUEST *requests, int count) {
+    FAS_SERIAL *port = (FAS_SERIAL *)tp;
+    BYTE tx[2][SERIAL_FRAME_SIZE];
+    int tx_size[2];
+    BYTE reply[BUFFER_SIZE];
+
+    if (count <= 0) {
+        return;
+    }
+    tx_size[0] = encode_request(&requests[0], tx[0]);
+    for (int i = 0; i < count; i++) {
+        FAS_REQUEST *request = &requests[i];
+        discard_input(port);
+        int64_t sent_at = FAS_NowUs();
+        bool sent = write_all(tp->fd, tx[i & 1], tx_size[i & 1]) >= 0;
+        if (i + 1 < count) {
+            tx_size[(i + 1) & 1] = encode_request(&requests[i + 1], tx[(i + 1) & 1]);
+        }
+        request->reply_bytes = 0;
+        if (!sent) {
+            request->result = FMC_DISCONNECTED;
+            continue;
+        }
+
+        port->sync[request->iBdID] = 0;
+        int n = serial_read_frame(port, request->iBdID, reply, sizeof(reply), frame_timeout(port, FAS_TIMEOUT_MS));
+        if (n >= 6) {
+            request->sent_us = sent_at;
+            request->received_us = FAS_NowUs();
+        }
+        if (n < 6 || reply[4] != request->frame_type) {
+            request->result = n == FAS_RECV_CRC_ERROR ? FMC_CRCFAILED_ERROR : n < 0 ? FMC_TIMEOUT_ERROR : FMC_RECVPACKET_ERROR;
+            continue;
+        }
+        request->result = reply[5];
+        request->reply_bytes = n;
+        if (request->reply != NULL) {
+            memcpy(request->reply, reply, n < request->reply_size ? n : request->reply_size);
+        }
+    }
+}
+
+static void serial_close(FAS_TRANSPORT *tp) {
+    FAS_SERIAL *port = (FAS_SERIAL *)tp;
+    for (FAS_SERIAL **p = &serial_ports; *p != NULL; p = &(*p)->next) {
+        if (*p == port) {
+            *p = port->next;
+            break;
+        }
+    }
+    close(tp->fd);
+    FAS_PoolFree(&FAS_SerialPool, port);
+}
+
+static const FAS_TRANSPORT_OPS serial_ops = {
+    .name = "RS-485",
+    .send = serial_send,
+    .recv = serial_recv,
+    .batch = serial_batch,
+    .close = serial_close,
+};
+
+ /**@brief 포트를 8N1 raw 모드로 설정, USB-RS485 변환기는 low latency 모드로 바꿔 응답 지연을 줄임*/
+static bool serial_configure(int fd, int baud) {
+    speed_t speed = 0;
+    for (size_t i = 0; i < sizeof(serial_speeds) / sizeof(serial_speeds[0]); i++) {
+        if (serial_speeds[i].baud == baud) {
+            speed = serial_speeds[i].speed;
+        }
+    }
+    if (speed == 0) {
+        fprintf(stderr, "Unsupported baud rate: %d\n", baud);
+        return false;
+    }
+
+    struct termios tio;
+    if (tcgetattr(fd, &tio) < 0) {
+        perror("tcgetattr failed");
+        return false;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    if (tcsetattr(fd, TCSANOW, &tio) < 0) {
+        perror("tcsetattr failed");
+        return false;
+    }
+    tcflush(fd, TCIOFLUSH);
+
+    struct serial_struct serial; // pty 등 지원하지 않는 장치는 무시
+    if (ioctl(fd, TIOCGSERIAL, &serial) == 0) {
+        serial.flags |= ASYNC_LOW_LATENCY;
+        ioctl(fd, TIOCSSERIAL, &serial);
+    }
+    return true;
+}
+
+ /**@brief RS-485 포트를 열어 transport로 돌려줌, 이미 열린 포트면 그것을 같이 씀
+  * @param const char *device 예) "/dev/ttyUSB0"
+  * @param int baud 9600 ~ 921600, 이미 열린 포트면 그때의 속도와 같아야 함
+  * @return 실패 시 NULL*/
+FAS_TRANSPORT *FAS_SerialOpen(const char *device, int baud) {
+    for (FAS_SERIAL *port = serial_ports; port != NULL; port = port->next) {
+        if (strcmp(port->device, device) == 0) {
+            if (port->baud != baud) {
+                fprintf(stderr, "%s is already open at %d baud, not %d\n", device, port->baud, baud);
+                return NULL;
+            }
+            return &port->base;
+        }
+    }
+
+    int fd = open(device, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        perror("Serial open failed");
+        return NULL;
+    }
+    if (!serial_configure(fd, baud)) {
+        close(fd);
+        return NULL;
+    }
+
+    FAS_SERIAL *port = FAS_PoolAlloc(&FAS_SerialPool);
+    if (port == NULL) {
+        close(fd);
+        return NULL;
+    }
+    port->base.ops = &serial_ops;
+    port->base.fd = fd;
+    port->baud = baud;
+    snprintf(port->device, sizeof(port->device), "%s", device);
+    port->next = serial_ports;
+    serial_ports = port;
+    return &port->base;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+/**
+ * @file FAS_Serial.h
+ * @brief Ezi-SERVO II Plus-R(RS-485) 프레임 인코딩/디코딩
+ * @details 프레임: [AA][CC][Slave ID][frame type][data...][CRC Lo][CRC Hi][AA][EE]
+ * Slave ID부터 CRC까지 0xAA가 나오면 0xAA를 한 번 더 넣는다(byte stuffing).
+ * CRC16은 Slave ID~data에 대한 Modbus CRC(다항식 0xA001, 초기값 0xFFFF)이며 256개짜리 표로 계산한다.
+ */
+
+#include <stdint.h>
+#include "FAS_Library.h"
+
+#define SERIAL_BODY_SIZE (BUFFER_SIZE + 2) //Slave ID + frame type + 통신상태 + data + CRC
+#define SERIAL_FRAME_SIZE (2 + 2 * SERIAL_BODY_SIZE + 2) //모든 바이트가 stuffing 되었을 때의 최대 길이
+
+typedef struct
+{
+    int state;
+    int size;                     //body에 들어간 바이트 수, 프레임 완성 후에는 CRC를 뺀 길이
+    BYTE body[SERIAL_BODY_SIZE];  //[Slave ID][frame type][data...]
+} FAS_SERIAL_PARSER;
+
+uint16_t FAS_CRC16(const BYTE *data, int size);
+int FAS_SerialEncode(BYTE slave, BYTE frame_type, const BYTE *data, int size, BYTE *out);
+int FAS_SerialParse(FAS_SERIAL_PARSER *parser, BYTE c);
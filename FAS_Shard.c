@@ -0,0 +1,305 @@
+/**
+ * @file FAS_Shard.c
+ * @brief 보드를 여러 I/O 스레드에 나눠 맡기는 요청 처리기
+ * @details worker 큐는 여러 스레드가 넣고 worker 하나가 꺼내는 bounded MPSC 큐(칸마다 sequence 번호)이다.
+ * worker는 큐가 비면 SHARD_SPIN_US 동안 다시 확인한 뒤 sleeping 표시를 하고 eventfd에서 잠든다.
+ * 넣는 쪽은 sleeping일 때만 eventfd에 쓰므로 바쁜 동안에는 시스템 콜이 없다.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "FAS_Shard.h"
+
+#define SHARD_BATCH 64    //worker가 한 번에 꺼내 FAS_TransactBatch로 보내는 요청 수
+#define SHARD_SPIN_US 50
+
+typedef struct
+{
+    FAS_REQUEST *request;
+    FAS_SHARD_DONE done;
+    void *user;
+} SHARD_JOB;
+
+typedef struct
+{
+    _Atomic size_t sequence;
+    SHARD_JOB job;
+} SHARD_CELL;
+
+typedef struct
+{
+    SHARD_CELL cells[FAS_SHARD_QUEUE_SIZE];
+    _Atomic size_t tail;      //넣는 쪽들이 공유
+    char pad[64];
+    _Atomic size_t head;      //worker만 씀
+    _Atomic int sleeping;
+    int event_fd;
+    int cpu;
+    pthread_t thread;
+} SHARD_WORKER;
+
+static SHARD_WORKER *workers[FAS_SHARD_MAX_WORKERS];
+static int worker_count;
+static int board_worker[FAS_MAX_BOARD]; //보드 ID -> worker, -1이면 맡기지 않음
+static _Atomic bool shard_running;
+
+static bool queue_push(SHARD_WORKER *w, const SHARD_JOB *job) {
+    size_t pos = atomic_load_explicit(&w->tail, memory_order_relaxed);
+    while (1) {
+        SHARD_CELL *cell = &w->cells[pos & (FAS_SHARD_QUEUE_SIZE - 1)];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&w->tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+                cell->job = *job;
+                atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0) {
+            return false; //가득 참
+        }
+        else {
+            pos = atomic_load_explicit(&w->tail, memory_order_relaxed);
+        }
+    }
+}
+
+static bool queue_pop(SHARD_WORKER *w, SHARD_JOB *job) {
+    size_t pos = atomic_load_explicit(&w->head, memory_order_relaxed);
+    SHARD_CELL *cell = &w->cells[pos & (FAS_SHARD_QUEUE_SIZE - 1)];
+    if (atomic_load_explicit(&cell->sequence, memory_order_acquire) != pos + 1) {
+        return false;
+    }
+    *job = cell->job;
+    atomic_store_explicit(&cell->sequence, pos + FAS_SHARD_QUEUE_SIZE, memory_order_release);
+    atomic_store_explicit(&w->head, pos + 1, memory_order_relaxed);
+    return true;
+}
+
+static bool queue_empty(SHARD_WORKER *w) {
+    size_t pos = atomic_load_explicit(&w->head, memory_order_relaxed);
+    return atomic_load_explicit(&w->cells[pos & (FAS_SHARD_QUEUE_SIZE - 1)].sequence, memory_order_acquire) != pos + 1;
+}
+
+ /**@brief 큐가 빌 때 잠깐 기다렸다가 그래도 없으면 eventfd에서 잠듦*/
+static void worker_wait(SHARD_WORKER *w) {
+    int64_t spin_end = FAS_NowUs() + SHARD_SPIN_US;
+    while (FAS_NowUs() < spin_end) {
+        if (!queue_empty(w) || !shard_running) {
+            return;
+        }
+    }
+    atomic_store(&w->sleeping, 1);
+    atomic_thread_fence(memory_order_seq_cst); //FAS_ShardSubmit의 fence와 짝, 둘 중 하나는 반드시 상대가 쓴 것을 봄
+    if (queue_empty(w) && shard_running) { //sleeping 표시 전에 들어온 요청을 놓치지 않도록 다시 확인
+        uint64_t value;
+        if (read(w->event_fd, &value, sizeof(value)) < 0 && errno != EINTR) {
+            perror("shard worker wait failed");
+        }
+    }
+    atomic_store(&w->sleeping, 0);
+}
+
+static void *worker_thread(void *arg) {
+    SHARD_WORKER *w = arg;
+    SHARD_JOB jobs[SHARD_BATCH];
+    FAS_REQUEST requests[SHARD_BATCH];
+
+    if (w->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(w->cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    while (shard_running || !queue_empty(w)) {
+        int count = 0;
+        while (count < SHARD_BATCH && queue_pop(w, &jobs[count])) {
+            requests[count] = *jobs[count].request;
+            count++;
+        }
+        if (count == 0) {
+            worker_wait(w);
+            continue;
+        }
+        FAS_TransactBatch(requests, count);
+        for (int i = 0; i < count; i++) {
+            jobs[i].request->result = requests[i].result;
+            jobs[i].request->reply_bytes = requests[i].reply_bytes;
+            jobs[i].request->acquired_us = requests[i].acquired_us;
+            jobs[i].request->sent_us = requests[i].sent_us;
+            jobs[i].request->received_us = requests[i].received_us;
+            if (jobs[i].done != NULL) {
+                jobs[i].done(jobs[i].request, jobs[i].user);
+            }
+        }
+    }
+    return NULL;
+}
+
+ /**@brief 연결된 보드를 worker에 나누고 worker 스레드를 시작
+  * @param int workers worker 수, 0 이하이면 온라인 코어 수
+  * @param bool pin TRUE면 worker i를 코어 i % 코어 수에 고정
+  * @return 이미 시작했거나 실패하면 FALSE*/
+bool FAS_ShardStart(int workers_wanted, bool pin) {
+    int cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    char keys[FAS_MAX_BOARD][FAS_ADDRESS_SIZE];
+    int key_count = 0;
+
+    if (worker_count > 0) {
+        return false;
+    }
+    if (workers_wanted <= 0) {
+        workers_wanted = cpus > 0 ? cpus : 1;
+    }
+    if (workers_wanted > FAS_SHARD_MAX_WORKERS) {
+        workers_wanted = FAS_SHARD_MAX_WORKERS;
+    }
+
+    // transport 단위로 worker를 돌아가며 배정, 같은 RS-485 버스('#' 앞이 같은 주소)는 같은 worker
+    for (int iBdID = 0; iBdID < FAS_MAX_BOARD; iBdID++) {
+        const char *address = FAS_BoardAddress(iBdID);
+        board_worker[iBdID] = -1;
+        if (address == NULL) {
+            continue;
+        }
+        size_t length = strcspn(address, "#");
+        int k = 0;
+        while (k < key_count && !(strlen(keys[k]) == length && strncmp(keys[k], address, length) == 0)) {
+            k++;
+        }
+        if (k == key_count) {
+            snprintf(keys[k], sizeof(keys[k]), "%.*s", (int)length, address);
+            key_count++;
+        }
+        board_worker[iBdID] = k % workers_wanted;
+    }
+
+    shard_running = true;
+    for (int i = 0; i < workers_wanted; i++) {
+        SHARD_WORKER *w = calloc(1, sizeof(SHARD_WORKER));
+        if (w == NULL || (w->event_fd = eventfd(0, EFD_CLOEXEC)) < 0) {
+            perror("shard worker create failed");
+            free(w);
+            FAS_ShardStop();
+            return false;
+        }
+        for (size_t c = 0; c < FAS_SHARD_QUEUE_SIZE; c++) {
+            atomic_init(&w->cells[c].sequence, c);
+        }
+        w->cpu = pin && cpus > 0 ? i % cpus : -1;
+        if (pthread_create(&w->thread, NULL, worker_thread, w) != 0) {
+            perror("shard worker create failed");
+            close(w->event_fd);
+            free(w);
+            FAS_ShardStop();
+            return false;
+        }
+        workers[worker_count++] = w;
+    }
+    return true;
+}
+
+ /**@brief 큐에 남은 요청을 모두 처리한 뒤 worker를 멈춤*/
+void FAS_ShardStop(void) {
+    uint64_t one = 1;
+
+    shard_running = false;
+    for (int i = 0; i < worker_count; i++) {
+        if (write(workers[i]->event_fd, &one, sizeof(one)) < 0) {
+            perror("shard worker wake failed");
+        }
+        pthread_join(workers[i]->thread, NULL);
+        close(workers[i]->event_fd);
+        free(workers[i]);
+        workers[i] = NULL;
+    }
+    worker_count = 0;
+}
+
+ /**@brief 보드를 맡은 worker 번호
+  * @return 맡긴 보드가 아니면 -1*/
+int FAS_ShardWorkerOf(int iBdID) {
+    if (worker_count == 0 || iBdID < 0 || iBdID >= FAS_MAX_BOARD) {
+        return -1;
+    }
+    return board_worker[iBdID];
+}
+
+ /**@brief 요청 하나를 보드를 맡은 worker에 넘김, 끝나면 worker 스레드에서 done을 부름
+  * @details request와 request->data, request->reply는 done이 불릴 때까지 유지해야 함
+  * @return 맡긴 보드가 아니거나 큐가 가득 차면 FALSE*/
+bool FAS_ShardSubmit(FAS_REQUEST *request, FAS_SHARD_DONE done, void *user) {
+    int index = FAS_ShardWorkerOf(request->iBdID);
+    if (index < 0) {
+        return false;
+    }
+    SHARD_WORKER *w = workers[index];
+    SHARD_JOB job = { request, done, user };
+    if (!queue_push(w, &job)) {
+        return false;
+    }
+    atomic_thread_fence(memory_order_seq_cst); //push를 sleeping 확인보다 먼저 보이게 함 (worker_wait 참고)
+    if (atomic_load(&w->sleeping)) {
+        uint64_t one = 1;
+        if (write(w->event_fd, &one, sizeof(one)) < 0) {
+            perror("shard worker wake failed");
+        }
+    }
+    return true;
+}
+
+typedef struct
+{
+    _Atomic int remaining;
+    sem_t finished;
+} SHARD_WAIT;
+
+static void batch_done(FAS_REQUEST *request, void *user) {
+    SHARD_WAIT *wait = user;
+    if (atomic_fetch_sub(&wait->remaining, 1) == 1) {
+        sem_post(&wait->finished);
+    }
+}
+
+ /**@brief FAS_TransactBatch와 같지만 요청을 보드별 worker에 나눠 동시에 처리하고 모두 끝날 때까지 기다림
+  * @return 성공(FMM_OK)한 요청 수*/
+int FAS_ShardTransactBatch(FAS_REQUEST *requests, int count) {
+    SHARD_WAIT wait;
+    int ok = 0;
+
+    atomic_init(&wait.remaining, count + 1); //다 넣기 전에 끝나지 않도록 1을 더 잡아 둠
+    sem_init(&wait.finished, 0, 0);
+    for (int i = 0; i < count; i++) {
+        requests[i].reply_bytes = 0;
+        while (!FAS_ShardSubmit(&requests[i], batch_done, &wait)) {
+            if (FAS_ShardWorkerOf(requests[i].iBdID) < 0) {
+                requests[i].result = FMM_NOT_OPEN;
+                batch_done(&requests[i], &wait);
+                break;
+            }
+            sched_yield(); //큐가 가득 참
+        }
+    }
+    batch_done(NULL, &wait);
+    while (sem_wait(&wait.finished) != 0 && errno == EINTR) {
+    }
+    sem_destroy(&wait.finished);
+
+    for (int i = 0; i < count; i++) {
+        if (requests[i].result == FMM_OK) {
+            ok++;
+        }
+    }
+    return ok;
+}
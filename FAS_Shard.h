@@ -0,0 +1,26 @@
+#pragma once
+
+/**
+ * @file FAS_Shard.h
+ * @brief 보드를 여러 I/O 스레드(코어별)에 나눠 맡기는 요청 처리기
+ * @details FAS_ShardStart 때 연결되어 있는 보드를 worker N개에 나누고, 각 worker는 코어 하나에 고정된다.
+ * 같은 transport(RS-485 버스)를 쓰는 보드는 같은 worker에 가고, 그 밖에는 transport 단위로 돌아가며 나눈다.
+ * 보드의 소켓, sync 번호, 응답 버퍼는 맡은 worker만 건드리므로 요청 처리 중에는 잠금이 없다.
+ * 요청은 보드 ID로 worker를 찾아 그 worker의 lock-free 큐에 넣고, worker가 잠들어 있을 때만 깨운다.
+ * FAS_ShardStart ~ FAS_ShardStop 사이에는 맡긴 보드에 FAS_Transact 등을 직접 부르지 않는다.
+ */
+
+#include <stdbool.h>
+#include "FAS_Library.h"
+
+#define FAS_SHARD_MAX_WORKERS 16
+#define FAS_SHARD_QUEUE_SIZE 1024 //worker별 대기 요청 수, 2의 거듭제곱
+
+ /**@brief 요청이 끝났을 때 worker 스레드에서 부르는 함수*/
+typedef void (*FAS_SHARD_DONE)(FAS_REQUEST *request, void *user);
+
+bool FAS_ShardStart(int workers, bool pin);
+void FAS_ShardStop(void);
+int FAS_ShardWorkerOf(int iBdID);
+bool FAS_ShardSubmit(FAS_REQUEST *request, FAS_SHARD_DONE done, void *user);
+int FAS_ShardTransactBatch(FAS_REQUEST *requests, int count);
@@ -0,0 +1,175 @@
+/**
+ * @file FAS_Trace.c
+ * @brief 스레드별 구간 buffer와 Chrome trace(JSON) 내보내기
+ * @details buffer는 스레드 하나만 쓰고, FAS_TraceStop이 기록을 끈 뒤에 읽는다.
+ * head는 지금까지 쓴 구간 수이고 구간은 head % FAS_TRACE_EVENTS 자리에 쓰므로, 가득 차면 가장 오래된 구간을 덮어쓴다.
+ * 스레드가 끝나면 buffer를 놓고 다음 스레드가 이어서 쓰므로 구간마다 스레드 번호(tid)를 같이 남긴다.
+ * 파일의 ts/dur는 FAS_TraceStart 시각부터의 us(소수점 아래 ns)이고 pid는 프로세스, tid는 리눅스 스레드 번호이다.
+ */
+
+#define _GNU_SOURCE
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "FAS_Trace.h"
+
+typedef struct
+{
+    const char *name;
+    int64_t start_ns;
+    int64_t end_ns;
+    int arg;
+    int tid;
+} TRACE_EVENT;
+
+typedef struct
+{
+    TRACE_EVENT *events;     //처음 차지할 때 잡고 놓지 않음
+    _Atomic uint64_t head;   //쓰는 스레드만 바꿈
+    _Atomic bool owned;      //쓰는 스레드가 있음, 스레드가 끝나면 다른 스레드가 이어 씀
+    int tid;                 //마지막으로 차지한 스레드
+    char thread_name[16];
+} TRACE_BUFFER;
+
+_Atomic bool FAS_TraceOn;
+
+static TRACE_BUFFER buffers[FAS_TRACE_MAX_THREADS];
+static _Thread_local TRACE_BUFFER *thread_buffer;
+static pthread_key_t buffer_key;
+static pthread_once_t buffer_once = PTHREAD_ONCE_INIT;
+
+static FILE *trace_out;
+static int64_t origin_ns;  //FAS_TraceStart 시각, 파일의 ts 0
+
+ /**@brief 구간 시각에 쓰는 CLOCK_MONOTONIC (ns)*/
+int64_t FAS_TraceNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void release_buffer(void *arg) {
+    TRACE_BUFFER *buffer = arg;
+    atomic_store_explicit(&buffer->owned, false, memory_order_release);
+}
+
+static void make_buffer_key(void) {
+    pthread_key_create(&buffer_key, release_buffer);
+}
+
+ /**@brief 이 스레드의 buffer, 처음 부르면 빈 buffer 하나를 차지함
+  * @return buffer가 모두 쓰이고 있거나 메모리가 없으면 NULL*/
+static TRACE_BUFFER *claim_buffer(void) {
+    if (thread_buffer != NULL) {
+        return thread_buffer;
+    }
+    pthread_once(&buffer_once, make_buffer_key);
+    for (int i = 0; i < FAS_TRACE_MAX_THREADS; i++) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&buffers[i].owned, &expected, true)) {
+            TRACE_BUFFER *buffer = &buffers[i];
+            if (buffer->events == NULL && (buffer->events = calloc(FAS_TRACE_EVENTS, sizeof(TRACE_EVENT))) == NULL) {
+                atomic_store(&buffer->owned, false);
+                return NULL;
+            }
+            buffer->tid = (int)syscall(SYS_gettid);
+            pthread_getname_np(pthread_self(), buffer->thread_name, sizeof(buffer->thread_name));
+            pthread_setspecific(buffer_key, buffer);
+            thread_buffer = buffer;
+            return thread_buffer;
+        }
+    }
+    return NULL;
+}
+
+ /**@brief 이미 잰 구간 하나를 남김 (FAS_REQUEST의 sent_us/received_us처럼 나중에 아는 구간용)
+  * @param int64_t start_ns FAS_TraceNow와 같은 시계, us 시각이면 1000을 곱해서 줌*/
+void FAS_TraceSpan(const char *name, int64_t start_ns, int64_t end_ns, int arg) {
+    if (!FAS_TraceEnabled() || start_ns < origin_ns) {
+        return;
+    }
+    TRACE_BUFFER *buffer = claim_buffer();
+    if (buffer == NULL) {
+        return;
+    }
+    uint64_t head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    TRACE_EVENT *event = &buffer->events[head & (FAS_TRACE_EVENTS - 1)];
+    event->name = name;
+    event->start_ns = start_ns;
+    event->end_ns = end_ns > start_ns ? end_ns : start_ns;
+    event->arg = arg;
+    event->tid = buffer->tid;
+    atomic_store_explicit(&buffer->head, head + 1, memory_order_release);
+}
+
+ /**@brief 기록을 시작함, 이전에 남은 구간은 버림
+  * @param const char *path 내보낼 파일, NULL이면 아무것도 하지 않음 (환경 변수를 그대로 넘길 수 있음)*/
+bool FAS_TraceStart(const char *path) {
+    if (path == NULL || atomic_load(&FAS_TraceOn)) {
+        return false;
+    }
+    trace_out = fopen(path, "w");
+    if (trace_out == NULL) {
+        perror(path);
+        return false;
+    }
+    for (int i = 0; i < FAS_TRACE_MAX_THREADS; i++) {
+        atomic_store(&buffers[i].head, 0);
+    }
+    origin_ns = FAS_TraceNow();
+    atomic_store(&FAS_TraceOn, true);
+    return true;
+}
+
+ /**@brief ns를 "us.ns" 형식으로 씀*/
+static void print_us(FILE *out, int64_t ns) {
+    fprintf(out, "%" PRId64 ".%03d", ns / 1000, (int)(ns % 1000));
+}
+
+ /**@brief 기록을 멈추고 모든 스레드의 구간을 파일에 씀
+  * @details 멈추는 순간 다른 스레드가 쓰던 구간 하나는 빠지거나 깨질 수 있다.
+  * @return 쓴 구간 수, 기록 중이 아니면 -1*/
+int FAS_TraceStop(void) {
+    if (!atomic_exchange(&FAS_TraceOn, false)) {
+        return -1;
+    }
+    int pid = (int)getpid();
+    int written = 0;
+    bool first = true;
+
+    fprintf(trace_out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    for (int i = 0; i < FAS_TRACE_MAX_THREADS; i++) {
+        TRACE_BUFFER *buffer = &buffers[i];
+        uint64_t head = atomic_load_explicit(&buffer->head, memory_order_acquire);
+        if (head == 0) {
+            continue;
+        }
+        char name[sizeof(buffer->thread_name)];
+        for (size_t k = 0; k < sizeof(name); k++) {
+            char c = buffer->thread_name[k];
+            name[k] = c == '"' || c == '\\' || (c != '\0' && c < ' ') ? '_' : c;
+        }
+        name[sizeof(name) - 1] = '\0';
+        fprintf(trace_out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", pid, buffer->tid, name);
+        first = false;
+        for (uint64_t k = head > FAS_TRACE_EVENTS ? head - FAS_TRACE_EVENTS : 0; k < head; k++) {
+            const TRACE_EVENT *event = &buffer->events[k & (FAS_TRACE_EVENTS - 1)];
+            fprintf(trace_out, ",\n{\"name\":\"%s\",\"cat\":\"fas\",\"ph\":\"X\",\"ts\":", event->name);
+            print_us(trace_out, event->start_ns - origin_ns);
+            fprintf(trace_out, ",\"dur\":");
+            print_us(trace_out, event->end_ns - event->start_ns);
+            fprintf(trace_out, ",\"pid\":%d,\"tid\":%d,\"args\":{\"arg\":%d}}", pid, event->tid, event->arg);
+            written++;
+        }
+    }
+    fprintf(trace_out, "\n]}\n");
+    fclose(trace_out);
+    trace_out = NULL;
+    return written;
+}
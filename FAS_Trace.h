@@ -0,0 +1,46 @@
+#pragma once
+
+/**
+ * @file FAS_Trace.h
+ * @brief 요청 하나가 지나는 단계(프레임 만들기, 시스템 콜, 선로+드라이브, 응답 해석, 화면 갱신)별 시작/끝 시각 기록
+ * @details FAS_TRACE_BEGIN(span, "send", iBdID) ... FAS_TRACE_END(span)으로 구간 하나를 남긴다.
+ * FAS_TraceStart 전이나 FAS_TraceStop 후에는 flag 하나만 보고 돌아오며, 켜져 있으면
+ * [이름][시작][끝][인자][스레드]를 스레드별 buffer에 복사한다. (잠금, malloc, 시스템 콜 없음)
+ * buffer는 스레드가 처음 기록할 때 한 번 잡고, 가득 차면 오래된 구간부터 덮어쓴다. (스레드마다 마지막 FAS_TRACE_EVENTS개가 남음)
+ * FAS_TraceStop이 모든 buffer를 Chrome trace 형식(JSON, "ph":"X")으로 파일에 쓰며, chrome://tracing이나 ui.perfetto.dev에서 바로 열 수 있다.
+ * 이름은 포인터만 저장하므로 문자열 상수를 쓴다.
+ * 드라이브 안에서 걸린 시간과 선로 시간은 밖에서 나눌 수 없으므로 요청을 보낸 시각 ~ 응답을 받은 시각은 "wire+drive" 구간 하나로 남긴다.
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define FAS_TRACE_EVENTS 32768    //스레드별 buffer의 구간 수, 2의 거듭제곱
+#define FAS_TRACE_MAX_THREADS 32  //동시에 기록하는 스레드 수
+
+ /**@brief 진행 중인 구간, start_ns가 0이면 기록하지 않음*/
+typedef struct
+{
+    const char *name;
+    int64_t start_ns;
+    int arg;           //보드 번호, frame type, 바이트 수 등 (FAS_TRACE_END 전에 바꿔도 됨)
+} FAS_TRACE_SPAN;
+
+extern _Atomic bool FAS_TraceOn;
+
+#define FAS_TRACE_BEGIN(span, name, arg) FAS_TRACE_SPAN span = { name, FAS_TraceEnabled() ? FAS_TraceNow() : 0, arg }
+#define FAS_TRACE_END(span) do { \
+        if ((span).start_ns != 0) { \
+            FAS_TraceSpan((span).name, (span).start_ns, FAS_TraceNow(), (span).arg); \
+        } \
+    } while (0)
+
+static inline bool FAS_TraceEnabled(void) {
+    return atomic_load_explicit(&FAS_TraceOn, memory_order_relaxed);
+}
+
+bool FAS_TraceStart(const char *path);
+int FAS_TraceStop(void);
+int64_t FAS_TraceNow(void);
+void FAS_TraceSpan(const char *name, int64_t start_ns, int64_t end_ns, int arg);
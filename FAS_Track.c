@@ -0,0 +1,303 @@
+/**
+ * @file FAS_Track.c
+ * @brief 속도 추종 계획 읽기와 제어 루프
+ * @details 한 주기는 엔코더 읽기(0x06) batch 하나와, 보낼 속도가 있을 때 속도 batch 하나로 이루어진다.
+ * 축마다 기준과 자기 엔코더를 처음 함께 읽은 주기에 시작 위치를 정하므로, 시작할 때의 위치 차이는 오차로 보지 않는다.
+ * 보낸 속도 프레임이 실패하면 마지막으로 보낸 속도를 바꾸지 않으므로 다음 주기에 다시 보낸다.
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FAS_Track.h"
+#include "FAS_Frame.h"
+
+ /**@brief 보드 하나의 엔코더 값과 그것으로 추정한 속도*/
+typedef struct
+{
+    bool ok;             //이번 주기에 읽었음
+    int32_t position;
+    int64_t acquired_us;
+    bool has_previous;
+    int32_t previous;
+    int64_t previous_us;
+    bool has_velocity;
+    double velocity;     //pps, 지수 평활
+} TRACK_BOARD;
+
+static bool parse_board(const char *text, int *iBdID) {
+    char *end;
+    long board = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || board < 0 || board >= FAS_MAX_BOARD) {
+        return false;
+    }
+    *iBdID = (int)board;
+    return true;
+}
+
+ /**@brief "축 follow 기준 [ratio R] [kp K] [deadband D] [max M]; ..." 형식의 계획을 읽음
+  * @return 형식이 틀렸거나 같은 축이 두 번 나오면 FALSE (원인은 stderr)*/
+bool FAS_TrackParse(FAS_TRACK_PLAN *plan, const char *text) {
+    char *copy = strdup(text);
+    char *saveptr;
+    bool used[FAS_MAX_BOARD] = { false }; //보드 i가 이미 추종 축
+    bool ok = true;
+
+    memset(plan, 0, sizeof(*plan));
+    if (copy == NULL) {
+        return false;
+    }
+    for (char *item = strtok_r(copy, ";", &saveptr); item != NULL && ok; item = strtok_r(NULL, ";", &saveptr)) {
+        item = FAS_Trim(item);
+        if (*item == '\0') {
+            continue;
+        }
+        if (plan->count >= FAS_TRACK_MAX_AXES) {
+            fprintf(stderr, "track plan: more than %d axes\n", FAS_TRACK_MAX_AXES);
+            ok = false;
+            break;
+        }
+        FAS_TRACK_AXIS *axis = &plan->axes[plan->count];
+        *axis = (FAS_TRACK_AXIS){ .ratio = 1.0, .kp = FAS_TRACK_KP, .deadband_pps = FAS_TRACK_DEADBAND_PPS, .max_pps = FAS_TRACK_MAX_PPS };
+
+        char *words[16];
+        int word_count = 0;
+        char *word_save;
+        for (char *word = strtok_r(item, " \t", &word_save); word != NULL && word_count < 16; word = strtok_r(NULL, " \t", &word_save)) {
+            words[word_count++] = word;
+        }
+        if (word_count < 3 || word_count % 2 == 0 || strcmp(words[1], "follow") != 0
+            || !parse_board(words[0], &axis->iBdID) || !parse_board(words[2], &axis->reference) || axis->iBdID == axis->reference) {
+            fprintf(stderr, "track plan: expected \"axis follow reference\": \"%s\"\n", item);
+            ok = false;
+            break;
+        }
+        if (used[axis->iBdID]) {
+            fprintf(stderr, "track plan: axis %d listed twice\n", axis->iBdID);
+            ok = false;
+            break;
+        }
+        for (int i = 3; i < word_count && ok; i += 2) {
+            char *end;
+            double value = strtod(words[i + 1], &end);
+            if (end == words[i + 1] || *end != '\0') {
+                ok = false;
+            }
+            else if (strcmp(words[i], "ratio") == 0) {
+                axis->ratio = value;
+            }
+            else if (strcmp(words[i], "kp") == 0 && value >= 0) {
+                axis->kp = value;
+            }
+            else if (strcmp(words[i], "deadband") == 0 && value >= 0) {
+                axis->deadband_pps = (int32_t)value;
+            }
+            else if (strcmp(words[i], "max") == 0 && value > 0) {
+                axis->max_pps = (int32_t)value;
+            }
+            else {
+                ok = false;
+            }
+            if (!ok) {
+                fprintf(stderr, "track plan: bad option \"%s %s\"\n", words[i], words[i + 1]);
+            }
+        }
+        used[axis->iBdID] = true;
+        plan->count++;
+    }
+    free(copy);
+    return ok && plan->count > 0;
+}
+
+ /**@brief 보낼 속도 프레임을 만듦, 지금 보낸 속도와 같은 방향이면 0x3A, 아니면 0x37 또는 0x31*/
+static FAS_REQUEST velocity_request(int iBdID, int32_t last_pps, int32_t pps, BYTE *data) {
+    DWORD speed = (DWORD)(pps < 0 ? -(int64_t)pps : pps);
+
+    if (pps == 0) {
+        return (FAS_REQUEST){ .iBdID = iBdID, .frame_type = 0x31 };
+    }
+    FAS_PutDword(data, speed);
+    if (last_pps == 0 || (last_pps < 0) != (pps < 0)) {
+        data[4] = pps > 0; //1이면 + 방향
+        return (FAS_REQUEST){ .iBdID = iBdID, .frame_type = 0x37, .data = data, .data_size = 5 };
+    }
+    return (FAS_REQUEST){ .iBdID = iBdID, .frame_type = 0x3A, .data = data, .data_size = 4 };
+}
+
+ /**@brief stop이 TRUE가 될 때까지 rate_hz로 기준을 따라 축의 속도를 고침, 끝나면 추종 축을 멈춤
+  * @param int rate_hz 초당 주기 수, 0이면 쉬지 않고 반복
+  * @return 계획이 비었으면 FALSE*/
+bool FAS_TrackRun(const FAS_TRACK_PLAN *plan, int rate_hz, volatile bool *stop, FAS_TRACK_REPORT *report) {
+    TRACK_BOARD boards[FAS_MAX_BOARD];
+    int board_ids[FAS_MAX_BOARD];
+    int board_count = 0;
+    bool locked[FAS_TRACK_MAX_AXES] = { false };
+    int32_t reference_start[FAS_TRACK_MAX_AXES], axis_start[FAS_TRACK_MAX_AXES];
+    int64_t period = rate_hz > 0 ? 1000000 / rate_hz : 0;
+    int64_t start = FAS_NowUs();
+    int64_t next = start;
+
+    memset(report, 0, sizeof(*report));
+    memset(boards, 0, sizeof(boards));
+    if (plan->count == 0) {
+        return false;
+    }
+    for (int a = 0; a < plan->count; a++) {
+        int ids[2] = { plan->axes[a].reference, plan->axes[a].iBdID };
+        for (int k = 0; k < 2; k++) {
+            int j = 0;
+            while (j < board_count && board_ids[j] != ids[k]) {
+                j++;
+            }
+            if (j == board_count) {
+                board_ids[board_count++] = ids[k];
+            }
+        }
+    }
+
+    while (stop == NULL || !*stop) {
+        int64_t cycle_start = FAS_NowUs();
+        FAS_REQUEST reads[FAS_MAX_BOARD];
+        BYTE replies[FAS_MAX_BOARD][16];
+        for (int i = 0; i < board_count; i++) {
+            reads[i] = (FAS_REQUEST){ .iBdID = board_ids[i], .frame_type = 0x06, .reply = replies[i], .reply_size = sizeof(replies[i]) };
+        }
+        FAS_TransactBatch(reads, board_count);
+        for (int i = 0; i < board_count; i++) {
+            TRACK_BOARD *b = &boards[board_ids[i]];
+            b->ok = reads[i].result == FMM_OK && reads[i].reply_bytes >= 10 && reads[i].acquired_us != 0;
+            if (!b->ok) {
+                continue;
+            }
+            b->position = (int32_t)(replies[i][6] | replies[i][7] << 8 | replies[i][8] << 16 | (DWORD)replies[i][9] << 24);
+            b->acquired_us = reads[i].acquired_us;
+            if (b->has_previous && b->acquired_us > b->previous_us) {
+                double velocity = (double)(int32_t)(b->position - b->previous) * 1e6 / (b->acquired_us - b->previous_us);
+                b->velocity = b->has_velocity ? b->velocity + FAS_TRACK_VELOCITY_ALPHA * (velocity - b->velocity) : velocity;
+                b->has_velocity = true;
+            }
+            b->has_previous = true;
+            b->previous = b->position;
+            b->previous_us = b->acquired_us;
+        }
+
+        // 축마다 오차와 속도를 계산하고, 보낼 것만 모음
+        FAS_REQUEST batch[FAS_TRACK_MAX_AXES];
+        BYTE data[FAS_TRACK_MAX_AXES][5];
+        int owner[FAS_TRACK_MAX_AXES];
+        int32_t pending[FAS_TRACK_MAX_AXES];
+        int64_t sampled[FAS_TRACK_MAX_AXES];
+        int count = 0;
+        for (int a = 0; a < plan->count; a++) {
+            const FAS_TRACK_AXIS *axis = &plan->axes[a];
+            FAS_TRACK_AXIS_RESULT *result = &report->axes[a];
+            const TRACK_BOARD *ref = &boards[axis->reference];
+            const TRACK_BOARD *own = &boards[axis->iBdID];
+            if (!ref->ok || !own->ok) {
+                result->read_errors++;
+                continue;
+            }
+            if (!locked[a]) {
+                locked[a] = true;
+                reference_start[a] = ref->position;
+                axis_start[a] = own->position;
+            }
+            double reference = (int32_t)(ref->position - reference_start[a]) + ref->velocity * (own->acquired_us - ref->acquired_us) / 1e6;
+            double error = axis->ratio * reference - (int32_t)(own->position - axis_start[a]);
+            int64_t magnitude = llround(fabs(error));
+            result->samples++;
+            result->error_square += error * error;
+            if (magnitude > result->max_error) {
+                result->max_error = magnitude;
+            }
+            LatencyHist_Add(&result->error, magnitude > UINT32_MAX ? UINT32_MAX : (uint32_t)magnitude);
+
+            double velocity = axis->ratio * ref->velocity + axis->kp * error;
+            if (velocity > axis->max_pps) {
+                velocity = axis->max_pps;
+            }
+            else if (velocity < -axis->max_pps) {
+                velocity = -axis->max_pps;
+            }
+            int32_t pps = (int32_t)lround(velocity);
+            if (abs(pps) <= axis->deadband_pps) {
+                pps = 0;
+            }
+            int32_t last = result->last_pps;
+            if (pps == last || (pps != 0 && last != 0 && (pps < 0) == (last < 0) && abs(pps - last) <= axis->deadband_pps)) {
+                result->skipped++;
+                continue;
+            }
+            batch[count] = velocity_request(axis->iBdID, last, pps, data[count]);
+            owner[count] = a;
+            pending[count] = pps;
+            sampled[count] = ref->acquired_us < own->acquired_us ? ref->acquired_us : own->acquired_us;
+            count++;
+        }
+        if (count > 0) {
+            int64_t issued = FAS_NowUs();
+            FAS_TransactBatch(batch, count);
+            for (int i = 0; i < count; i++) {
+                FAS_TRACK_AXIS_RESULT *result = &report->axes[owner[i]];
+                int64_t sent = batch[i].sent_us != 0 ? batch[i].sent_us : issued;
+                LatencyHist_Add(&result->latency, sent > sampled[i] ? (uint32_t)(sent - sampled[i]) : 0);
+                if (batch[i].result != FMM_OK) {
+                    result->errors++;
+                    if (batch[i].result == FMP_RUNFAIL) { //드라이브가 멈춰 있어 override를 받지 않음, 다음 주기에 0x37로 다시 시작
+                        result->last_pps = 0;
+                    }
+                    continue;
+                }
+                if (batch[i].frame_type == 0x3A) {
+                    result->updates++;
+                }
+                else {
+                    result->restarts++;
+                }
+                result->last_pps = pending[i];
+            }
+        }
+        report->cycles++;
+        LatencyHist_Add(&report->cycle, (uint32_t)(FAS_NowUs() - cycle_start));
+
+        if (period > 0) {
+            int64_t now = FAS_NowUs();
+            next += period;
+            if (now - next > period) {
+                next = now;
+            }
+            FAS_SleepUntilUs(next);
+        }
+    }
+
+    // 0x37이 timeout이면 last_pps가 0이어도 드라이브는 움직이고 있을 수 있으므로 모든 추종 축에 보냄
+    FAS_REQUEST stops[FAS_TRACK_MAX_AXES];
+    for (int a = 0; a < plan->count; a++) {
+        stops[a] = (FAS_REQUEST){ .iBdID = plan->axes[a].iBdID, .frame_type = 0x31 };
+        report->axes[a].last_pps = 0;
+    }
+    FAS_TransactBatch(stops, plan->count);
+    report->wall_us = FAS_NowUs() - start;
+    return true;
+}
+
+ /**@brief 축별 추종 오차, 보낸 프레임 수, 읽기 ~ 전송 지연과 전체 주기 출력*/
+void FAS_TrackPrint(FILE *out, const FAS_TRACK_PLAN *plan, const FAS_TRACK_REPORT *report) {
+    fprintf(out, "%-4s %-3s %7s %8s %8s %8s %6s %6s %9s %8s %8s %8s %8s\n", "AXIS", "REF", "RATIO", "UPDATES", "RESTARTS", "SKIPPED", "ERRORS",
+            "MISSED", "ERR RMS", "ERR P99", "ERR MAX", "LAT P50", "LAT P99");
+    for (int a = 0; a < plan->count; a++) {
+        const FAS_TRACK_AXIS *axis = &plan->axes[a];
+        const FAS_TRACK_AXIS_RESULT *r = &report->axes[a];
+        double rms = r->samples > 0 ? sqrt(r->error_square / r->samples) : 0.0;
+        fprintf(out, "%-4d %-3d %7.3f %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %6" PRIu64 " %6" PRIu64 " %9.1f %8u %8" PRId64 " %8u %8u\n",
+                axis->iBdID, axis->reference, axis->ratio, r->updates, r->restarts, r->skipped, r->errors, r->read_errors,
+                rms, LatencyHist_Percentile(&r->error, 99), r->max_error,
+                LatencyHist_Percentile(&r->latency, 50), LatencyHist_Percentile(&r->latency, 99));
+    }
+    double seconds = report->wall_us / 1e6;
+    fprintf(out, "errors in pulses, latency in us (encoder read -> velocity frame sent)\n");
+    fprintf(out, "%" PRIu64 " cycles in %.1f s (%.0f Hz), cycle p50 %u us, p99 %u us, max %u us\n", report->cycles, seconds,
+            seconds > 0 ? report->cycles / seconds : 0.0, LatencyHist_Percentile(&report->cycle, 50),
+            LatencyHist_Percentile(&report->cycle, 99), report->cycle.max_us);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+/**
+ * @file FAS_Track.h
+ * @brief 기준 엔코더(컨베이어)를 따라 축의 속도를 계속 고치는 속도 추종
+ * @details 계획은 "1 follow 0 ratio 0.5 kp 4 deadband 20 max 200000; 2 follow 0" 형식이다.
+ * 축마다 따라갈 기준 보드, 비율, 위치 오차 이득(kp, 1/s), 속도를 다시 보내지 않을 범위(deadband, pps), 최대 속도(max, pps)를 준다.
+ * 기준 엔코더는 컨베이어 엔코더를 읽는 보드의 엔코더 값(0x06)이다.
+ * 매 주기 기준과 추종 축의 엔코더를 FAS_TransactBatch 한 번으로 읽고, 축마다
+ *   목표 위치 = 시작 위치 + ratio x (기준 위치 - 기준 시작 위치), 속도 = ratio x 기준 속도 + kp x (목표 위치 - 현재 위치)
+ * 를 계산한다. 기준 위치는 두 보드를 읽은 시각 차이만큼 기준 속도로 보정한다.
+ * 마지막으로 보낸 속도와 deadband 이상 차이 나는 축만 속도 override(0x3A, 방향은 그대로)를 보내고,
+ * 멈춰 있던 축이 움직이기 시작하거나 방향이 바뀔 때만 0x37, 속도가 deadband 안으로 들어오면 0x31을 보낸다.
+ * 보낼 것이 있는 축의 프레임은 모아서 FAS_TransactBatch 한 번으로 보낸다. 끝날 때는 추종 축을 모두 멈춘다.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "FAS_Library.h"
+#include "LatencyHist.h"
+
+#define FAS_TRACK_MAX_AXES FAS_MAX_BOARD
+#define FAS_TRACK_KP 2.0             //kp 기본값 (1/s)
+#define FAS_TRACK_DEADBAND_PPS 10    //deadband 기본값
+#define FAS_TRACK_MAX_PPS 500000     //max 기본값
+#define FAS_TRACK_VELOCITY_ALPHA 0.3 //기준 속도 추정의 지수 평활 계수
+
+typedef struct
+{
+    int iBdID;             //따라가는 축
+    int reference;         //기준 엔코더를 읽는 보드
+    double ratio;
+    double kp;             //위치 오차(pulse)마다 더하는 속도 (pps)
+    int32_t deadband_pps;
+    int32_t max_pps;
+} FAS_TRACK_AXIS;
+
+typedef struct
+{
+    FAS_TRACK_AXIS axes[FAS_TRACK_MAX_AXES];
+    int count;
+} FAS_TRACK_PLAN;
+
+ /**@brief 축 하나의 결과*/
+typedef struct
+{
+    uint64_t updates;        //보낸 속도 override (0x3A)
+    uint64_t restarts;       //보낸 0x37, 0x31
+    uint64_t skipped;        //deadband 안이라 보내지 않은 주기
+    uint64_t errors;         //보낸 프레임 중 응답이 FMM_OK가 아닌 수
+    uint64_t read_errors;    //기준이나 축의 엔코더를 읽지 못해 건너뛴 주기
+    uint64_t samples;        //오차를 잰 주기
+    int32_t last_pps;        //마지막으로 보낸 속도 (방향 포함)
+    int64_t max_error;       //가장 큰 |오차| (pulse)
+    double error_square;     //오차 제곱 합, RMS 계산용
+    LATENCY_HIST error;      //|오차| 분포 (pulse)
+    LATENCY_HIST latency;    //엔코더를 읽은 시각 ~ 속도 프레임을 보낸 시각 (us)
+} FAS_TRACK_AXIS_RESULT;
+
+typedef struct
+{
+    FAS_TRACK_AXIS_RESULT axes[FAS_TRACK_MAX_AXES];
+    uint64_t cycles;
+    LATENCY_HIST cycle;      //한 주기(읽기 + 계산 + 보내기)에 걸린 시간 (us)
+    int64_t wall_us;
+} FAS_TRACK_REPORT;
+
+bool FAS_TrackParse(FAS_TRACK_PLAN *plan, const char *text);
+bool FAS_TrackRun(const FAS_TRACK_PLAN *plan, int rate_hz, volatile bool *stop, FAS_TRACK_REPORT *report);
+void FAS_TrackPrint(FILE *out, const FAS_TRACK_PLAN *plan, const FAS_TRACK_REPORT *report);
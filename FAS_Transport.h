@@ -0,0 +1,117 @@
+#pragma once
+
+/**
+ * @file FAS_Transport.h
+ * @brief FAS_Library 내부에서 쓰는 transport 인터페이스
+ * @details 보드마다 FAS_TRANSPORT 포인터를 가지고, 같은 RS-485 버스의 보드들은 하나의 transport를 공유한다.
+ * 프레임은 모두 Plus-E 형식이며 변환이 필요한 transport는 send/recv 안에서 처리한다.
+ * transport 구조체는 calloc/free 대신 FAS_PoolAlloc/FAS_PoolFree로 잡는다.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FAS_Library.h"
+
+typedef struct FAS_TRANSPORT FAS_TRANSPORT;
+
+typedef struct
+{
+    const char *name;
+     /**@return 보낸 바이트 수, 실패 시 -1*/
+    int (*send)(FAS_TRANSPORT *tp, int iBdID, const BYTE *frame, int size);
+     /**@return 받은 바이트 수, 실패나 timeout이면 -1, CRC가 틀린 프레임을 받았으면 FAS_RECV_CRC_ERROR*/
+    int (*recv)(FAS_TRANSPORT *tp, int iBdID, BYTE *frame, int size, int timeout_ms);
+     /**@brief 같은 transport로 가는 요청 여러 개를 한 번에 처리, NULL이면 FAS_Transact를 차례로 호출
+      * @details 응답을 받은 요청은 sent_us, received_us를 채움 (RTT 추정은 FAS_TransactBatch가 함)*/
+    void (*batch)(FAS_TRANSPORT *tp, FAS_REQUEST *requests, int count);
+    void (*close)(FAS_TRANSPORT *tp);
+} FAS_TRANSPORT_OPS;
+
+struct FAS_TRANSPORT
+{
+    const FAS_TRANSPORT_OPS *ops;
+    int fd;
+    int refs; //이 transport를 쓰는 보드 수
+    bool datagram; //요청/응답이 유실될 수 있는 transport(UDP), 읽기 요청은 RTO가 지나면 다시 보냄
+};
+
+ /**@brief 한 종류의 transport 구조체를 나눠 주는 곳
+  * @details FAS_STATIC_MEMORY로 빌드하면 FAS_MAX_BOARD개짜리 static 배열에서, 아니면 heap에서 가져온다.
+  * 보드마다 transport는 많아야 하나이므로 FAS_MAX_BOARD개면 모자라지 않는다.
+  * 이 저장소의 도구와 ProtocolTest는 FAS_Connect*와 FAS_Close를 한 스레드(main 또는 GTK main loop)에서만 부르지만,
+  * 라이브러리를 쓰는 프로그램이 보드마다 다른 스레드에서 연결하고 닫아도 되도록 used, in_use, peak는 lock 안에서만 바꾼다.*/
+typedef struct
+{
+    const char *name;
+    size_t size;               //구조체 하나 크기
+    void *slots;               //FAS_STATIC_MEMORY일 때 FAS_MAX_BOARD개 배열, 아니면 NULL
+    bool used[FAS_MAX_BOARD];
+    int in_use, peak;
+    pthread_mutex_t lock;
+} FAS_POOL;
+
+#ifdef FAS_STATIC_MEMORY
+#define FAS_POOL_DEFINE(pool, type) \
+    static type pool##_slots[FAS_MAX_BOARD]; \
+    FAS_POOL pool = { #type, sizeof(type), pool##_slots, { false }, 0, 0, PTHREAD_MUTEX_INITIALIZER }
+#else
+#define FAS_POOL_DEFINE(pool, type) FAS_POOL pool = { #type, sizeof(type), NULL, { false }, 0, 0, PTHREAD_MUTEX_INITIALIZER }
+#endif
+
+extern FAS_POOL FAS_EthernetPool, FAS_UringPool, FAS_SerialPool, FAS_GatewayPool;
+
+ /**@brief pool에서 0으로 채운 구조체 하나를 가져옴
+  * @details FAS_Serial.c만 링크하는 DriveSim에서도 쓰므로 header에 둔다.
+  * @return 남은 자리가 없거나 heap이 모자라면 NULL*/
+static inline void *FAS_PoolAlloc(FAS_POOL *pool) {
+    void *item = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+#ifdef FAS_STATIC_MEMORY
+    for (int i = 0; i < FAS_MAX_BOARD && item == NULL; i++) {
+        if (!pool->used[i]) {
+            pool->used[i] = true;
+            item = (BYTE *)pool->slots + i * pool->size;
+            memset(item, 0, pool->size);
+        }
+    }
+    if (item == NULL) {
+        pthread_mutex_unlock(&pool->lock);
+        fprintf(stderr, "%s: all %d slots in use\n", pool->name, FAS_MAX_BOARD);
+        return NULL;
+    }
+#else
+    if ((item = calloc(1, pool->size)) == NULL) {
+        pthread_mutex_unlock(&pool->lock);
+        return NULL;
+    }
+#endif
+    if (++pool->in_use > pool->peak) {
+        pool->peak = pool->in_use;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return item;
+}
+
+static inline void FAS_PoolFree(FAS_POOL *pool, void *item) {
+    if (item == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+#ifdef FAS_STATIC_MEMORY
+    pool->used[((BYTE *)item - (BYTE *)pool->slots) / pool->size] = false;
+#else
+    free(item);
+#endif
+    pool->in_use--;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int64_t FAS_RttTimeout(int iBdID);
+void FAS_RttBackoff(int iBdID);
+
+FAS_TRANSPORT *FAS_EthernetOpen(const char *ip, bool tcp);
+FAS_TRANSPORT *FAS_UringOpen(const char *ip, bool sqpoll);
+FAS_TRANSPORT *FAS_SerialOpen(const char *device, int baud);
+FAS_TRANSPORT *FAS_GatewayOpen(const char *path);
@@ -0,0 +1,496 @@
+/**
+ * @file FAS_Uring.c
+ * @brief Ezi-SERVO II Plus-E용 io_uring UDP transport
+ * @details liburing 없이 io_uring 시스템 콜을 직접 쓴다.
+ * - 수신: BUFFER_SIZE 크기 버퍼 RECV_BUFFERS개를 provided buffer ring으로 등록하고 multishot recv 하나를 계속 걸어 둔다.
+ *   응답이 올 때마다 recv를 다시 요청할 필요가 없다.
+ * - 송신: 미리 잡아 둔 슬롯에 프레임을 복사해 send SQE만 쌓아 두고, 다음에 응답을 기다릴 때 io_uring_enter 한 번으로
+ *   제출과 대기를 같이 한다. 요청 하나에 sendto/poll/recvfrom 세 번이던 시스템 콜이 한 번으로 준다.
+ * - SQPOLL: 커널 스레드가 SQ를 가져가므로 제출에는 시스템 콜이 필요 없고, 응답은 잠깐 CQ를 직접 보다가 없을 때만 잠든다.
+ *   커널 스레드가 코어 하나를 계속 쓰므로 남는 코어가 없으면 오히려 느려진다.
+ * - batch: 요청을 URING_WINDOW개까지 먼저 보내 두고 sync 번호로 응답을 짝지어 드라이브와의 왕복 대기를 겹친다.
+ *   읽기 요청은 보드의 RTO 안에 응답이 없으면 새 sync 번호로 다시 보낸다. (FAS_MAX_TRIES번까지)
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "FAS_Trace.h"
+#include "FAS_Transport.h"
+
+#define URING_ENTRIES 64
+#ifndef FAS_URING_RECV_BUFFERS
+#define FAS_URING_RECV_BUFFERS 64
+#endif
+#define RECV_BUFFERS FAS_URING_RECV_BUFFERS //2의 거듭제곱
+#define URING_WINDOW FAS_MAX_INFLIGHT       //batch에서 응답을 기다리지 않고 먼저 보내 두는 요청 수
+#define SEND_SLOTS (URING_WINDOW * 4)
+#define URING_SPIN_US 50  //SQPOLL일 때 잠들기 전에 CQ를 직접 확인하는 시간
+
+#define TAG_SEND (1ull << 32)
+#define TAG_RECV (2ull << 32)
+
+typedef struct
+{
+    FAS_TRANSPORT base;
+    int ring_fd;
+    bool sqpoll;
+
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_flags, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ring, *cq_ring;
+    size_t sq_ring_size, cq_ring_size, sqes_size;
+    unsigned to_submit;
+
+    struct io_uring_buf_ring *buf_ring;
+    unsigned short buf_tail;
+    bool recv_armed;
+    struct { unsigned short bid; int size; } rx_fifo[RECV_BUFFERS]; //받았지만 아직 꺼내가지 않은 응답
+    unsigned rx_head, rx_tail;
+
+    unsigned send_next;
+    int send_inflight;
+    BYTE sync;
+
+    BYTE send_slots[SEND_SLOTS][BUFFER_SIZE];
+    BYTE recv_buffers[RECV_BUFFERS][BUFFER_SIZE];
+} FAS_URING;
+
+_Static_assert((RECV_BUFFERS & (RECV_BUFFERS - 1)) == 0, "FAS_URING_RECV_BUFFERS must be a power of two");
+FAS_POOL_DEFINE(FAS_UringPool, FAS_URING);
+
+/************************************************************************************************************************************
+ ******************************************************* 링 조작 ********************************************************************
+ ************************************************************************************************************************************/
+
+ /**@brief 제출할 SQE를 쌓아 두고 min_complete개의 완료를 기다림, 필요 없으면 시스템 콜을 하지 않음*/
+static int uring_enter(FAS_URING *u, unsigned min_complete, int timeout_us) {
+    unsigned flags = 0;
+    unsigned submit = u->sqpoll ? 0 : u->to_submit;
+    struct __kernel_timespec ts = { .tv_sec = timeout_us / 1000000, .tv_nsec = (timeout_us % 1000000) * 1000 };
+    struct io_uring_getevents_arg arg = { .ts = (uint64_t)(uintptr_t)&ts };
+
+    if (u->sqpoll && u->to_submit > 0 && (__atomic_load_n(u->sq_flags, __ATOMIC_ACQUIRE) & IORING_SQ_NEED_WAKEUP)) {
+        flags |= IORING_ENTER_SQ_WAKEUP;
+    }
+    if (u->sqpoll) {
+        u->to_submit = 0;
+    }
+    if (min_complete > 0) {
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    }
+    if (submit == 0 && flags == 0) {
+        return 0;
+    }
+    FAS_TRACE_BEGIN(span, "io_uring_enter", (int)submit);
+    int ret = syscall(__NR_io_uring_enter, u->ring_fd, submit, min_complete, flags,
+                      min_complete > 0 ? (void *)&arg : NULL, min_complete > 0 ? sizeof(arg) : 0);
+    FAS_TRACE_END(span);
+    if (ret < 0) {
+        if (errno != ETIME && errno != EINTR && errno != EBUSY) {
+            perror("io_uring_enter failed");
+        }
+        return -1;
+    }
+    if (!u->sqpoll) {
+        u->to_submit -= ret;
+    }
+    return ret;
+}
+
+static struct io_uring_sqe *get_sqe(FAS_URING *u) {
+    unsigned tail = *u->sq_tail;
+    while (tail - __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE) >= URING_ENTRIES) {
+        uring_enter(u, 0, 0); //SQ가 가득 참
+    }
+    unsigned index = tail & *u->sq_mask;
+    struct io_uring_sqe *sqe = &u->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    u->sq_array[index] = index;
+    return sqe;
+}
+
+static void put_sqe(FAS_URING *u) {
+    __atomic_store_n(u->sq_tail, *u->sq_tail + 1, __ATOMIC_RELEASE);
+    u->to_submit++;
+}
+
+static void recycle_buffer(FAS_URING *u, unsigned short bid) {
+    struct io_uring_buf *buf = &u->buf_ring->bufs[u->buf_tail & (RECV_BUFFERS - 1)];
+    buf->addr = (uint64_t)(uintptr_t)u->recv_buffers[bid];
+    buf->len = BUFFER_SIZE;
+    buf->bid = bid;
+    u->buf_tail++;
+    __atomic_store_n(&u->buf_ring->tail, u->buf_tail, __ATOMIC_RELEASE);
+}
+
+static void arm_recv(FAS_URING *u) {
+    if (u->recv_armed) {
+        return;
+    }
+    struct io_uring_sqe *sqe = get_sqe(u);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = u->base.fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = 0;
+    sqe->user_data = TAG_RECV;
+    put_sqe(u);
+    u->recv_armed = true;
+}
+
+ /**@brief CQ에 쌓인 완료를 모두 처리, 받은 응답은 rx_fifo로 옮김*/
+static void process_cqes(FAS_URING *u) {
+    unsigned head = *u->cq_head;
+    unsigned tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; head++) {
+        struct io_uring_cqe *cqe = &u->cqes[head & *u->cq_mask];
+        if (cqe->user_data & TAG_SEND) {
+            u->send_inflight--;
+            if (cqe->res < 0) {
+                fprintf(stderr, "io_uring send failed: %s\n", strerror(-cqe->res));
+            }
+            continue;
+        }
+        if (!(cqe->flags & IORING_CQE_F_MORE)) {
+            u->recv_armed = false; //multishot이 끝남 (버퍼 부족 등), 다시 걸어야 함
+        }
+        if (cqe->res > 0 && (cqe->flags & IORING_CQE_F_BUFFER)) {
+            unsigned slot = u->rx_tail++ & (RECV_BUFFERS - 1);
+            u->rx_fifo[slot].bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+            u->rx_fifo[slot].size = cqe->res;
+        }
+        else if (cqe->res < 0 && cqe->res != -ENOBUFS && cqe->res != -ECONNREFUSED) { //드라이브가 꺼져 있으면 ICMP로 ECONNREFUSED가 옴
+            fprintf(stderr, "io_uring recv failed: %s\n", strerror(-cqe->res));
+        }
+    }
+    __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+}
+
+ /**@brief 받아 둔 응답 하나를 꺼냄
+  * @return 응답 길이, 없으면 -1*/
+static int pop_frame(FAS_URING *u, BYTE *frame, int size) {
+    if (u->rx_head == u->rx_tail) {
+        return -1;
+    }
+    unsigned slot = u->rx_head++ & (RECV_BUFFERS - 1);
+    unsigned short bid = u->rx_fifo[slot].bid;
+    int n = u->rx_fifo[slot].size < size ? u->rx_fifo[slot].size : size;
+    memcpy(frame, u->recv_buffers[bid], n);
+    recycle_buffer(u, bid);
+    return n;
+}
+
+ /**@brief 응답이 오거나 deadline이 될 때까지 기다림 (제출할 SQE도 같이 제출)*/
+static void wait_completion(FAS_URING *u, int64_t deadline) {
+    arm_recv(u);
+    if (u->sqpoll) {
+        uring_enter(u, 0, 0);
+        int64_t spin_end = FAS_NowUs() + URING_SPIN_US;
+        while (FAS_NowUs() < spin_end) {
+            if (__atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE) != *u->cq_head) {
+                return;
+            }
+        }
+    }
+    int64_t remain = deadline - FAS_NowUs();
+    if (remain > 0) {
+        uring_enter(u, 1, (int)remain);
+    }
+}
+
+/************************************************************************************************************************************
+ ******************************************************* transport ops **************************************************************
+ ************************************************************************************************************************************/
+
+static int uring_send(FAS_TRANSPORT *tp, int iBdID, const BYTE *frame, int size) {
+    FAS_URING *u = (FAS_URING *)tp;
+
+    if (size <= 0 || size > BUFFER_SIZE) {
+        return -1;
+    }
+    while (u->send_inflight >= SEND_SLOTS) {
+        uring_enter(u, 1, FAS_TIMEOUT_MS * 1000);
+        process_cqes(u);
+    }
+    unsigned slot = u->send_next++ % SEND_SLOTS;
+    memcpy(u->send_slots[slot], frame, size);
+
+    struct io_uring_sqe *sqe = get_sqe(u);
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = tp->fd;
+    sqe->addr = (uint64_t)(uintptr_t)u->send_slots[slot];
+    sqe->len = size;
+    sqe->user_data = TAG_SEND | slot;
+    put_sqe(u);
+    u->send_inflight++;
+    return size;
+}
+
+static int uring_recv(FAS_TRANSPORT *tp, int iBdID, BYTE *frame, int size, int timeout_ms) {
+    FAS_URING *u = (FAS_URING *)tp;
+    int64_t deadline = FAS_NowUs() + (int64_t)timeout_ms * 1000;
+
+    while (1) {
+        process_cqes(u);
+        int n = pop_frame(u, frame, size);
+        if (n >= 0) {
+            return n;
+        }
+        if (FAS_NowUs() >= deadline) {
+            return -1;
+        }
+        wait_completion(u, deadline);
+    }
+}
+
+static void finish_request(FAS_REQUEST *request, const BYTE *reply, int n, int64_t sent_us) {
+    request->sent_us = sent_us;
+    request->received_us = FAS_NowUs();
+    if (reply[4] != request->frame_type) {
+        request->result = FMC_RECVPACKET_ERROR;
+        return;
+    }
+    request->result = reply[5];
+    request->reply_bytes = n;
+    if (request->reply != NULL) {
+        memcpy(request->reply, reply, n < request->reply_size ? n : request->reply_size);
+    }
+}
+
+static void uring_batch(FAS_TRANSPORT *tp, FAS_REQUEST *requests, int count) {
+    FAS_URING *u = (FAS_URING *)tp;
+    struct { int index; BYTE sync; int tries; int64_t sent, rto, resend, deadline; } window[URING_WINDOW];
+    int inflight = 0, next = 0, done = 0;
+    BYTE frame[BUFFER_SIZE];
+
+    while (done < count) {
+        // 창이 빌 때마다 다음 요청을 보냄
+        while (inflight < URING_WINDOW && next < count) {
+            FAS_REQUEST *request = &requests[next];
+            request->reply_bytes = 0;
+            if (request->data_size < 0 || request->data_size > DATA_SIZE) {
+                request->result = FMP_DATAERROR;
+                next++;
+                done++;
+                continue;
+            }
+            BYTE sync = ++u->sync;
+            frame[0] = 0xAA; frame[1] = 3 + request->data_size; frame[2] = sync; frame[3] = 0x00; frame[4] = request->frame_type;
+            if (request->data_size > 0) {
+                memcpy(&frame[5], request->data, request->data_size);
+            }
+            uring_send(tp, request->iBdID, frame, request->data_size + 5);
+            int64_t now = FAS_NowUs();
+            window[inflight].index = next;
+            window[inflight].sync = sync;
+            window[inflight].tries = FAS_IsReadRequest(request->frame_type) ? 1 : FAS_MAX_TRIES;
+            window[inflight].sent = now;
+            window[inflight].deadline = now + FAS_TIMEOUT_MS * 1000;
+            window[inflight].rto = FAS_RttTimeout(request->iBdID);
+            window[inflight].resend = window[inflight].tries < FAS_MAX_TRIES ? now + window[inflight].rto : window[inflight].deadline;
+            inflight++;
+            next++;
+        }
+        if (inflight == 0) {
+            continue;
+        }
+
+        process_cqes(u);
+        int n;
+        while ((n = pop_frame(u, frame, sizeof(frame))) >= 0) {
+            for (int k = 0; n >= 6 && k < inflight; k++) {
+                if (window[k].sync == frame[2]) {
+                    finish_request(&requests[window[k].index], frame, n, window[k].sent);
+                    window[k] = window[--inflight];
+                    done++;
+                    break;
+                }
+            }
+        }
+
+        int64_t now = FAS_NowUs(), earliest = INT64_MAX;
+        bool backed_off = false; //같이 보낸 요청들이 한꺼번에 만료되어도 보드의 RTO는 한 번만 늘림
+        for (int k = 0; k < inflight; k++) {
+            FAS_REQUEST *request = &requests[window[k].index];
+            if (window[k].deadline <= now) {
+                request->result = FMC_TIMEOUT_ERROR;
+                window[k--] = window[--inflight];
+                done++;
+                continue;
+            }
+            if (window[k].resend <= now) {
+                // RTO 안에 응답이 없음, 새 sync로 다시 보냄 (늦게 온 이전 응답은 짝이 없어 버려짐)
+                if (!backed_off) {
+                    FAS_RttBackoff(request->iBdID);
+                    backed_off = true;
+                }
+                BYTE sync = ++u->sync;
+                frame[0] = 0xAA; frame[1] = 3 + request->data_size; frame[2] = sync; frame[3] = 0x00; frame[4] = request->frame_type;
+                if (request->data_size > 0) {
+                    memcpy(&frame[5], request->data, request->data_size);
+                }
+                uring_send(tp, request->iBdID, frame, request->data_size + 5);
+                window[k].sync = sync;
+                window[k].sent = now;
+                window[k].tries++;
+                window[k].rto *= 2;
+                window[k].resend = window[k].tries < FAS_MAX_TRIES && now + window[k].rto < window[k].deadline ? now + window[k].rto : window[k].deadline;
+            }
+            if (window[k].resend < earliest) {
+                earliest = window[k].resend;
+            }
+        }
+        if (inflight > 0 && (inflight == URING_WINDOW || next == count)) {
+            wait_completion(u, earliest);
+        }
+    }
+}
+
+static void uring_close(FAS_TRANSPORT *tp) {
+    FAS_URING *u = (FAS_URING *)tp;
+
+    if (u->ring_fd >= 0) {
+        close(u->ring_fd);
+    }
+    if (u->buf_ring != NULL) {
+        munmap(u->buf_ring, RECV_BUFFERS * sizeof(struct io_uring_buf));
+    }
+    if (u->sqes != NULL) {
+        munmap(u->sqes, u->sqes_size);
+    }
+    if (u->cq_ring != NULL && u->cq_ring != u->sq_ring) {
+        munmap(u->cq_ring, u->cq_ring_size);
+    }
+    if (u->sq_ring != NULL) {
+        munmap(u->sq_ring, u->sq_ring_size);
+    }
+    if (tp->fd >= 0) {
+        close(tp->fd);
+    }
+    FAS_PoolFree(&FAS_UringPool, u);
+}
+
+static const FAS_TRANSPORT_OPS uring_ops = {
+    .name = "io_uring",
+    .send = uring_send,
+    .recv = uring_recv,
+    .batch = uring_batch,
+    .close = uring_close,
+};
+
+ /**@brief io_uring 링과 수신 버퍼 링을 만듦*/
+static bool uring_setup(FAS_URING *u) {
+    struct io_uring_params p = { 0 };
+    if (u->sqpoll) {
+        p.flags |= IORING_SETUP_SQPOLL;
+        p.sq_thread_idle = 1000; //ms, 이 시간 동안 제출이 없으면 커널 스레드가 잠듦
+    }
+    u->ring_fd = syscall(__NR_io_uring_setup, URING_ENTRIES, &p);
+    if (u->ring_fd < 0) {
+        perror("io_uring_setup failed");
+        return false;
+    }
+
+    u->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    u->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (u->cq_ring_size > u->sq_ring_size) {
+            u->sq_ring_size = u->cq_ring_size;
+        }
+        u->cq_ring_size = u->sq_ring_size;
+    }
+    u->sq_ring = mmap(NULL, u->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->ring_fd, IORING_OFF_SQ_RING);
+    if (u->sq_ring == MAP_FAILED) {
+        u->sq_ring = NULL;
+        return false;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        u->cq_ring = u->sq_ring;
+    }
+    else {
+        u->cq_ring = mmap(NULL, u->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->ring_fd, IORING_OFF_CQ_RING);
+        if (u->cq_ring == MAP_FAILED) {
+            u->cq_ring = NULL;
+            return false;
+        }
+    }
+    u->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    u->sqes = mmap(NULL, u->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->ring_fd, IORING_OFF_SQES);
+    if (u->sqes == MAP_FAILED) {
+        u->sqes = NULL;
+        return false;
+    }
+
+    BYTE *sq = u->sq_ring, *cq = u->cq_ring;
+    u->sq_head = (unsigned *)(sq + p.sq_off.head);
+    u->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    u->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    u->sq_flags = (unsigned *)(sq + p.sq_off.flags);
+    u->sq_array = (unsigned *)(sq + p.sq_off.array);
+    u->cq_head = (unsigned *)(cq + p.cq_off.head);
+    u->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    u->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    // 수신 버퍼 등록 (provided buffer ring, bgid 0)
+    u->buf_ring = mmap(NULL, RECV_BUFFERS * sizeof(struct io_uring_buf), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (u->buf_ring == MAP_FAILED) {
+        u->buf_ring = NULL;
+        return false;
+    }
+    struct io_uring_buf_reg reg = { .ring_addr = (uint64_t)(uintptr_t)u->buf_ring, .ring_entries = RECV_BUFFERS, .bgid = 0 };
+    if (syscall(__NR_io_uring_register, u->ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        perror("io_uring buffer ring register failed");
+        return false;
+    }
+    for (int i = 0; i < RECV_BUFFERS; i++) {
+        recycle_buffer(u, i);
+    }
+    return true;
+}
+
+ /**@brief 드라이브 IP로 UDP 소켓을 열고 io_uring transport로 돌려줌
+  * @param const char *ip "xxx.xxx.xxx.xxx"
+  * @param bool sqpoll TRUE면 커널 SQ polling 스레드 사용
+  * @return 커널이 지원하지 않거나 실패 시 NULL*/
+FAS_TRANSPORT *FAS_UringOpen(const char *ip, bool sqpoll) {
+    FAS_URING *u = FAS_PoolAlloc(&FAS_UringPool);
+    if (u == NULL) {
+        return NULL;
+    }
+    u->base.ops = &uring_ops;
+    u->base.datagram = true;
+    u->base.fd = -1;
+    u->ring_fd = -1;
+    u->sqpoll = sqpoll;
+    u->sync = (BYTE)rand();
+
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(PORT) };
+    if (inet_pton(AF_INET, ip, &addr.sin_addr) <= 0) {
+        perror("Invalid address/ Address not supported");
+        uring_close(&u->base);
+        return NULL;
+    }
+    // connect 해 두면 send에 주소가 필요 없고 다른 곳에서 온 패킷은 커널이 걸러냄
+    if ((u->base.fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0 || connect(u->base.fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("Socket creation failed");
+        uring_close(&u->base);
+        return NULL;
+    }
+    if (!uring_setup(u)) {
+        uring_close(&u->base);
+        return NULL;
+    }
+    return &u->base;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file FlagAnalyze.c
+ * @brief 상태 캡처 파일(.fsc)의 플래그별 duty cycle, edge 수, chatter, 유지시간 히스토그램을 출력하는 도구
+ * @details 사용법: FlagAnalyze [-c chatter_ms] capture.fsc
+ *          시험용 캡처 생성: FlagAnalyze -g 샘플수 [-a 축수] [-p 주기us] capture.fsc
+ * 빌드: gcc -O2 -o FlagAnalyze FlagAnalyze.c StatusAnalyze.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "StatusAnalyze.h"
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+ /**@brief 시험용 캡처 생성, 서보 ON 상태에서 가끔 움직이고 INPOSITION이 가끔 chatter하는 축*/
+static int generate(const char *path, long samples, DWORD axes, DWORD period_us) {
+    FILE *fp = StatusCapture_Open(path, period_us, axes);
+    if (fp == NULL) {
+        return 1;
+    }
+    DWORD *state = calloc(axes, sizeof(DWORD));
+    srand(1);
+    for (long t = 0; t < samples; t++) {
+        for (DWORD a = 0; a < axes; a++) {
+            DWORD s = state[a] | 0x00100000; //SERVOON
+            if (rand() % 2000 == 0) {
+                s ^= 0x08000000 | 0x00080000; //MOTIONING <-> INPOSITION
+            }
+            if ((s & 0x00080000) && rand() % 500 == 0) {
+                s ^= 0x00080000; //INPOSITION chatter
+            }
+            if (rand() % 100000 == 0) {
+                s ^= 0x00000001 | 0x00000800; //ERRORALL + ERROVERLOAD
+            }
+            state[a] = s;
+        }
+        StatusCapture_Write(fp, state, axes);
+    }
+    free(state);
+    fclose(fp);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    double chatter_ms = 10;
+    long generate_samples = 0;
+    DWORD axes = 1, period_us = 1000;
+
+    while ((opt = getopt(argc, argv, "c:g:a:p:")) != -1) {
+        switch (opt)
+        {
+            case 'c':
+                chatter_ms = atof(optarg);
+                break;
+            case 'g':
+                generate_samples = atol(optarg);
+                break;
+            case 'a':
+                axes = atoi(optarg);
+                break;
+            case 'p':
+                period_us = atoi(optarg);
+                break;
+            default:
+                break;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "usage: %s [-c chatter_ms] capture.fsc\n"
+                        "       %s -g samples [-a axes] [-p period_us] capture.fsc\n", argv[0], argv[0]);
+        return 1;
+    }
+    if (generate_samples > 0) {
+        return generate(argv[optind], generate_samples, axes, period_us);
+    }
+
+    STATUS_CAPTURE_HEADER header;
+    double start = now_sec();
+    STATUS_FLAG_STATS *stats = StatusAnalyze_File(argv[optind], chatter_ms, &header);
+    if (stats == NULL) {
+        return 1;
+    }
+    double elapsed = now_sec() - start;
+
+    uint64_t total = 0;
+    for (DWORD a = 0; a < header.axes; a++) {
+        StatusAnalyze_Report(stdout, &stats[a], a, header.period_us);
+        total += stats[a].samples;
+    }
+    fprintf(stderr, "%llu samples in %.3f s (%.1f M samples/s)\n", (unsigned long long)total, elapsed, total / elapsed / 1e6);
+    free(stats);
+    return 0;
+}
@@ -0,0 +1,217 @@
+/**
+ * @file FleetConfig.c
+ * @brief 여러 드라이브의 파라미터와 I/O 할당을 동시에 읽어 파일로 남기고, 기준 레시피와 다른 값을 보여주거나 고쳐 쓰는 도구
+ * @details 사용법: FleetConfig (-i ip [-i ip ...] | -f ip 목록 파일 | -d /dev/ttyUSB0 [-n 축 수] [-B baud]) [-b socket|uring]
+ *          [-o snapshot 파일] [-r 기준 레시피 파일] [-p] [-S]
+ * 드라이브는 FAS_MAX_BOARD대씩 차례로 연결해 한 번에 읽고(FAS_RecipeSnapshot) 닫는다. -f 파일은 한 줄에 IP 하나이다.
+ * -o : 읽은 값을 레시피 파일 형식으로 저장한다. 주소를 "*"로 바꾸면 모든 드라이브의 기준 레시피로 쓸 수 있다.
+ * -r : 드라이브마다 같은 주소(없으면 "*")의 레시피와 비교해 다른 값을 "기준 -> 실제"로 출력한다.
+ * -p : 다른 값만 기준 값으로 쓰고(FAS_RecipePush) 다시 읽어 확인한다. -S를 함께 주면 고친 드라이브는 ROM에도 저장한다.
+ * 모든 드라이브가 기준과 같으면(또는 고쳐서 같아지면) 0, 아니면 1로 끝난다.
+ * 빌드: gcc -O2 -pthread -o FleetConfig FleetConfig.c FAS_Recipe.c FAS_Library.c FAS_Trace.c FAS_Ethernet.c FAS_Uring.c FAS_Serial.c FAS_Gateway.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "FAS_Recipe.h"
+
+#define MAX_GOLDEN 256
+#define MAX_DELTAS (MAX_SERVO2_PARAM + FAS_RECIPE_IO_PINS)
+
+ /**@brief 목록에 IP 하나를 더함, 필요하면 목록을 늘림*/
+static bool add_ip(char ***ips, int *count, int *capacity, const char *ip) {
+    if (*count == *capacity) {
+        int grown = *capacity > 0 ? *capacity * 2 : 64;
+        char **bigger = realloc(*ips, grown * sizeof(char *));
+        if (bigger == NULL) {
+            return false;
+        }
+        *ips = bigger;
+        *capacity = grown;
+    }
+    return ((*ips)[(*count)++] = strdup(ip)) != NULL;
+}
+
+ /**@brief 한 줄에 IP 하나인 파일을 읽음, 빈 줄과 '#' 줄은 건너뜀*/
+static bool read_ip_list(const char *path, char ***ips, int *count, int *capacity) {
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        perror(path);
+        return false;
+    }
+    char line[128];
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), fp) != NULL) {
+        char *ip = line + strspn(line, " \t");
+        ip[strcspn(ip, " \t\r\n#")] = '\0';
+        if (ip[0] != '\0') {
+            ok = add_ip(ips, count, capacity, ip);
+        }
+    }
+    fclose(fp);
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    char **ips = NULL;
+    int ip_count = 0, ip_capacity = 0;
+    const char *device = NULL;
+    int slaves = 1, baud = 115200;
+    const char *backend = "socket";
+    const char *snapshot_path = NULL;
+    const char *golden_path = NULL;
+    bool push = false, save_rom = false;
+
+    while ((opt = getopt(argc, argv, "i:f:d:n:B:b:o:r:pS")) != -1) {
+        switch (opt)
+        {
+            case 'i':
+                if (!add_ip(&ips, &ip_count, &ip_capacity, optarg)) {
+                    return 2;
+                }
+                break;
+            case 'f':
+                if (!read_ip_list(optarg, &ips, &ip_count, &ip_capacity)) {
+                    return 2;
+                }
+                break;
+            case 'd': device = optarg; break;
+            case 'n': slaves = atoi(optarg); break;
+            case 'B': baud = atoi(optarg); break;
+            case 'b': backend = optarg; break;
+            case 'o': snapshot_path = optarg; break;
+            case 'r': golden_path = optarg; break;
+            case 'p': push = true; break;
+            case 'S': save_rom = true; break;
+            default: break;
+        }
+    }
+    if ((ip_count == 0 && device == NULL) || (device != NULL && (slaves < 1 || slaves > FAS_MAX_BOARD)) || (push && golden_path == NULL)) {
+        fprintf(stderr, "usage: %s (-i ip [-i ip ...] | -f ip_list | -d device [-n slaves(1~%d)] [-B baud]) [-b socket|uring]"
+                " [-o snapshot] [-r golden [-p [-S]]]\n", argv[0], FAS_MAX_BOARD);
+        return 2;
+    }
+
+    static FAS_RECIPE golden[MAX_GOLDEN];
+    int golden_count = 0;
+    if (golden_path != NULL && (golden_count = FAS_RecipeLoad(golden_path, golden, MAX_GOLDEN)) <= 0) {
+        fprintf(stderr, "%s: no recipe\n", golden_path);
+        return 2;
+    }
+    if (strcmp(backend, "uring") == 0) {
+        FAS_SetEthernetBackend(FAS_BACKEND_URING);
+    }
+
+    int drives = device != NULL ? slaves : ip_count;
+    FAS_RECIPE *snapshot = calloc(drives, sizeof(FAS_RECIPE));
+    if (snapshot == NULL) {
+        perror("snapshot");
+        return 2;
+    }
+    int offline = 0, matching = 0, differing = 0, unknown = 0, fixed = 0, written = 0;
+    int64_t start = FAS_NowUs();
+
+    // FAS_MAX_BOARD대씩 연결해 읽고 닫음
+    for (int first = 0; first < drives; first += FAS_MAX_BOARD) {
+        int boards[FAS_MAX_BOARD];
+        int count = 0;
+        for (int i = first; i < drives && i < first + FAS_MAX_BOARD; i++) {
+            unsigned sb[4];
+            bool connected = false;
+            if (device != NULL) {
+                connected = FAS_ConnectSerial(device, baud, i);
+            }
+            else if (sscanf(ips[i], "%u.%u.%u.%u", &sb[0], &sb[1], &sb[2], &sb[3]) == 4) {
+                connected = FAS_Connect(sb[0], sb[1], sb[2], sb[3], i - first);
+            }
+            if (connected) {
+                boards[count++] = device != NULL ? i : i - first;
+            }
+            else {
+                fprintf(stderr, "%s: connect failed\n", device != NULL ? device : ips[i]);
+                offline++;
+            }
+        }
+
+        FAS_RECIPE *actual = &snapshot[first];
+        FAS_RecipeSnapshot(boards, count, actual);
+        const FAS_RECIPE *expected[FAS_MAX_BOARD] = { NULL };
+        FAS_RECIPE targets[FAS_MAX_BOARD];
+        bool needs_push = false;
+        for (int i = 0; i < count; i++) {
+            if (!actual[i].valid) {
+                printf("%s: OFFLINE\n", actual[i].address);
+                offline++;
+                continue;
+            }
+            if (golden_path == NULL) {
+                continue;
+            }
+            if ((expected[i] = FAS_RecipeFind(golden, golden_count, actual[i].address)) == NULL) {
+                printf("%s: no recipe\n", actual[i].address);
+                unknown++;
+                continue;
+            }
+            FAS_RECIPE_DELTA deltas[MAX_DELTAS];
+            int delta_count = FAS_RecipeDiff(expected[i], &actual[i], deltas, MAX_DELTAS);
+            if (delta_count == 0) {
+                printf("%s: OK\n", actual[i].address);
+                matching++;
+                continue;
+            }
+            printf("%s: %d differ\n", actual[i].address, delta_count);
+            for (int d = 0; d < delta_count; d++) {
+                printf("    ");
+                FAS_RecipePrintDelta(stdout, &deltas[d]);
+            }
+            differing++;
+            needs_push = true;
+        }
+
+        if (push && needs_push) {
+            // 기준이 없거나 같은 드라이브는 현재 값을 기준으로 넘겨 아무것도 쓰지 않게 함
+            for (int i = 0; i < count; i++) {
+                targets[i] = expected[i] != NULL ? *expected[i] : actual[i];
+            }
+            written += FAS_RecipePush(boards, count, targets, actual, save_rom);
+            FAS_RECIPE verify[FAS_MAX_BOARD];
+            FAS_RecipeSnapshot(boards, count, verify);
+            for (int i = 0; i < count; i++) {
+                if (expected[i] == NULL || FAS_RecipeDiff(expected[i], &actual[i], NULL, 0) == 0) {
+                    continue;
+                }
+                if (verify[i].valid && FAS_RecipeDiff(expected[i], &verify[i], NULL, 0) == 0) {
+                    fixed++;
+                }
+                else {
+                    printf("%s: still differs after push\n", actual[i].address);
+                }
+                if (verify[i].valid) {
+                    actual[i] = verify[i];
+                }
+            }
+        }
+        for (int i = 0; i < count; i++) {
+            FAS_Close(boards[i]);
+        }
+    }
+    double elapsed_ms = (FAS_NowUs() - start) / 1000.0;
+
+    printf("drives %d, ok %d, differ %d, fixed %d (%d values), no recipe %d, offline %d, %.1f ms\n",
+           drives, matching, differing, fixed, written, unknown, offline, elapsed_ms);
+    if (snapshot_path != NULL && !FAS_RecipeSave(snapshot_path, snapshot, drives)) {
+        return 2;
+    }
+    free(snapshot);
+    for (int i = 0; i < ip_count; i++) {
+        free(ips[i]);
+    }
+    free(ips);
+    if (golden_path == NULL) {
+        return offline == 0 ? 0 : 1;
+    }
+    return matching + fixed == drives ? 0 : 1;
+}
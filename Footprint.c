@@ -0,0 +1,104 @@
+/**
+ * @file Footprint.c
+ * @brief 드라이브에 연결하는 데 걸린 시간, 연결 후 heap 사용량과 RSS, 라이브러리가 잡은 메모리를 출력하는 도구
+ * @details 사용법: Footprint (-i ip [-i ip ...] | -d /dev/ttyUSB0 [-n 축 수] [-B baud]) [-b socket|uring]
+ * -i를 여러 번 주면 차례로 보드 ID 0, 1, 2...로 연결하고, -d는 Slave ID 0 ~ n-1로 연결한다.
+ * 연결한 뒤 축 상태(0x40)를 한 번 읽어 송수신 경로까지 쓴 다음 잰다.
+ * 빌드: gcc -Os -DFAS_STATIC_MEMORY -pthread -o Footprint Footprint.c FAS_Library.c FAS_Trace.c FAS_Ethernet.c FAS_Uring.c FAS_Serial.c FAS_Gateway.c
+ * 작은 보드에서는 -DFAS_MAX_BOARD=4 -DFAS_MAX_INFLIGHT=2 -DFAS_URING_RECV_BUFFERS=8 처럼 크기를 줄여 빌드한다.
+ */
+
+#include <fcntl.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "FAS_Library.h"
+
+ /**@brief /proc/self/status의 항목 값(kB), stdio는 heap을 쓰므로 read로 읽음*/
+static long proc_status_kb(const char *key) {
+    char text[4096];
+    int fd = open("/proc/self/status", O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t n = read(fd, text, sizeof(text) - 1);
+    close(fd);
+    if (n <= 0) {
+        return -1;
+    }
+    text[n] = '\0';
+    char *line = strstr(text, key);
+    return line != NULL ? strtol(line + strlen(key) + 1, NULL, 10) : -1;
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    const char *ips[FAS_MAX_BOARD];
+    int ip_count = 0;
+    const char *device = NULL;
+    const char *backend = "socket";
+    int slaves = 1, baud = 115200;
+
+    while ((opt = getopt(argc, argv, "i:d:n:B:b:")) != -1) {
+        switch (opt)
+        {
+            case 'i':
+                if (ip_count < FAS_MAX_BOARD) {
+                    ips[ip_count++] = optarg;
+                }
+                break;
+            case 'd': device = optarg; break;
+            case 'n': slaves = atoi(optarg); break;
+            case 'B': baud = atoi(optarg); break;
+            case 'b': backend = optarg; break;
+            default: break;
+        }
+    }
+    int boards = device != NULL ? slaves : ip_count;
+    if (boards <= 0 || boards > FAS_MAX_BOARD || optind != argc) {
+        fprintf(stderr, "usage: %s (-i ip [-i ip ...] | -d device [-n slaves(1~%d)] [-B baud]) [-b socket|uring]\n", argv[0], FAS_MAX_BOARD);
+        return 2;
+    }
+    if (strcmp(backend, "uring") == 0) {
+        FAS_SetEthernetBackend(FAS_BACKEND_URING);
+    }
+
+    size_t heap_before = mallinfo2().uordblks;
+    int64_t start = FAS_NowUs();
+    for (int i = 0; i < boards; i++) {
+        unsigned sb[4];
+        bool connected = false;
+        if (device != NULL) {
+            connected = FAS_ConnectSerial(device, baud, i);
+        }
+        else if (sscanf(ips[i], "%u.%u.%u.%u", &sb[0], &sb[1], &sb[2], &sb[3]) == 4) {
+            connected = FAS_Connect(sb[0], sb[1], sb[2], sb[3], i);
+        }
+        if (!connected) {
+            fprintf(stderr, "board %d: connect failed\n", i);
+            return 2;
+        }
+    }
+    int64_t connect_us = FAS_NowUs() - start;
+
+    FAS_REQUEST requests[FAS_MAX_BOARD];
+    BYTE replies[FAS_MAX_BOARD][16];
+    for (int i = 0; i < boards; i++) {
+        requests[i] = (FAS_REQUEST){ .iBdID = i, .frame_type = 0x40, .reply = replies[i], .reply_size = sizeof(replies[i]) };
+    }
+    int ok = FAS_TransactBatch(requests, boards);
+    int64_t first_us = FAS_NowUs() - start;
+    long heap_after = (long)mallinfo2().uordblks - (long)heap_before;
+    long rss = proc_status_kb("VmRSS:"), hwm = proc_status_kb("VmHWM:");
+
+    printf("connect %d boards %.3f ms, first status batch %d/%d ok at %.3f ms\n", boards, connect_us / 1e3, ok, boards, first_us / 1e3);
+    printf("heap used by connect + batch %ld bytes, VmRSS %ld kB, VmHWM %ld kB\n", heap_after, rss, hwm);
+    FAS_PrintFootprint(stdout);
+
+    for (int i = 0; i < boards; i++) {
+        FAS_Close(i);
+    }
+    return ok == boards ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file HomeCell.c
+ * @brief 원점복귀 계획대로 여러 축을 동시에 원점복귀시키고 그룹별 결과와 전체 시간을 출력하는 도구
+ * @details 사용법: HomeCell (-i ip [-i ip ...] | -d /dev/ttyUSB0 [-n 축 수] [-B baud]) [-s] "Z=2; XY=0,1 after Z"
+ * -i를 여러 번 주면 차례로 보드 ID 0, 1, 2...로 연결하고, -d는 Slave ID 0 ~ n-1로 연결한다.
+ * -s는 시작 전에 모든 축을 servo on 한다. 계획 형식은 FAS_HomingParse 참고.
+ * 빌드: gcc -O2 -pthread -o HomeCell HomeCell.c FAS_Homing.c FAS_Library.c FAS_Trace.c FAS_Ethernet.c FAS_Uring.c FAS_Serial.c FAS_Gateway.c
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "FAS_Homing.h"
+
+static volatile bool stop;
+
+static void on_signal(int sig) {
+    stop = true;
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    const char *ips[FAS_MAX_BOARD];
+    int ip_count = 0;
+    const char *device = NULL;
+    int slaves = 1, baud = 115200;
+    bool servo_on = false;
+
+    while ((opt = getopt(argc, argv, "i:d:n:B:s")) != -1) {
+        switch (opt)
+        {
+            case 'i':
+                if (ip_count < FAS_MAX_BOARD) {
+                    ips[ip_count++] = optarg;
+                }
+                break;
+            case 'd': device = optarg; break;
+            case 'n': slaves = atoi(optarg); break;
+            case 'B': baud = atoi(optarg); break;
+            case 's': servo_on = true; break;
+            default: break;
+        }
+    }
+    if ((ip_count == 0 && device == NULL) || optind + 1 != argc) {
+        fprintf(stderr, "usage: %s (-i ip [-i ip ...] | -d device [-n slaves] [-B baud]) [-s] \"Z=2; XY=0,1 after Z\"\n", argv[0]);
+        return 2;
+    }
+
+    FAS_HOMING_PLAN plan;
+    if (!FAS_HomingParse(&plan, argv[optind])) {
+        return 2;
+    }
+    int boards = device != NULL ? slaves : ip_count;
+    for (int i = 0; i < boards; i++) {
+        unsigned sb[4];
+        bool connected = false;
+        if (device != NULL) {
+            connected = FAS_ConnectSerial(device, baud, i);
+        }
+        else if (sscanf(ips[i], "%u.%u.%u.%u", &sb[0], &sb[1], &sb[2], &sb[3]) == 4) {
+            connected = FAS_Connect(sb[0], sb[1], sb[2], sb[3], i);
+        }
+        if (!connected) {
+            fprintf(stderr, "board %d: connect failed\n", i);
+            return 2;
+        }
+    }
+    if (servo_on) {
+        FAS_REQUEST requests[FAS_MAX_BOARD];
+        BYTE on = 1;
+        for (int i = 0; i < boards; i++) {
+            requests[i] = (FAS_REQUEST){ .iBdID = i, .frame_type = 0x2A, .data = &on, .data_size = 1 };
+        }
+        FAS_TransactBatch(requests, boards);
+    }
+
+    signal(SIGINT, on_signal);
+    FAS_HOMING_REPORT report;
+    FAS_HomingRun(&plan, &stop, &report);
+    FAS_HomingPrint(stdout, &plan, &report);
+
+    for (int i = 0; i < boards; i++) {
+        FAS_Close(i);
+    }
+    return report.ok ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file Interlock.c
+ * @brief 드라이브 입력 변화에 따라 정지/출력 프레임을 바로 보내고, 종료할 때 규칙별 실행 횟수와 지연을 출력하는 도구
+ * @details 사용법: Interlock (-i ip [-i ip ...] | -d /dev/ttyUSB0 [-n 축 수] [-B baud]) [-p 주기us] [-t 초] "4.USERIN3 rise -> stop 7"
+ * -i를 여러 번 주면 차례로 보드 ID 0, 1, 2...로 연결하고, -d는 Slave ID 0 ~ n-1로 연결한다.
+ * -p는 입력을 읽는 주기(기본 0, 쉬지 않고 읽음), -t는 실행 시간(기본 Ctrl+C까지)이다. 규칙 형식은 FAS_ReactParse 참고.
+ * 빌드: gcc -O2 -pthread -o Interlock Interlock.c FAS_React.c LatencyHist.c FAS_Library.c FAS_Trace.c FAS_Ethernet.c FAS_Uring.c FAS_Serial.c FAS_Gateway.c
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "FAS_React.h"
+
+static volatile bool stop;
+
+static void on_signal(int sig) {
+    stop = true;
+}
+
+static void on_fired(const FAS_REACT_RULE *rule, int index, int64_t latency_us, void *user) {
+    printf("rule %d fired (%lld us): %s\n", index, (long long)latency_us, rule->text);
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    const char *ips[FAS_MAX_BOARD];
+    int ip_count = 0;
+    const char *device = NULL;
+    int slaves = 1, baud = 115200;
+    int period_us = 0, seconds = 0;
+
+    while ((opt = getopt(argc, argv, "i:d:n:B:p:t:")) != -1) {
+        switch (opt)
+        {
+            case 'i':
+                if (ip_count < FAS_MAX_BOARD) {
+                    ips[ip_count++] = optarg;
+                }
+                break;
+            case 'd': device = optarg; break;
+            case 'n': slaves = atoi(optarg); break;
+            case 'B': baud = atoi(optarg); break;
+            case 'p': period_us = atoi(optarg); break;
+            case 't': seconds = atoi(optarg); break;
+            default: break;
+        }
+    }
+    if ((ip_count == 0 && device == NULL) || optind + 1 != argc) {
+        fprintf(stderr, "usage: %s (-i ip [-i ip ...] | -d device [-n slaves] [-B baud]) [-p period_us] [-t seconds] \"4.USERIN3 rise -> stop 7\"\n", argv[0]);
+        return 2;
+    }
+
+    static FAS_REACT_TABLE table;
+    if (!FAS_ReactParse(&table, argv[optind])) {
+        return 2;
+    }
+    int boards = device != NULL ? slaves : ip_count;
+    for (int i = 0; i < boards; i++) {
+        unsigned sb[4];
+        bool connected = false;
+        if (device != NULL) {
+            connected = FAS_ConnectSerial(device, baud, i);
+        }
+        else if (sscanf(ips[i], "%u.%u.%u.%u", &sb[0], &sb[1], &sb[2], &sb[3]) == 4) {
+            connected = FAS_Connect(sb[0], sb[1], sb[2], sb[3], i);
+        }
+        if (!connected) {
+            fprintf(stderr, "board %d: connect failed\n", i);
+            return 2;
+        }
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGALRM, on_signal);
+    if (seconds > 0) {
+        alarm(seconds);
+    }
+    static FAS_REACT_REPORT report;
+    FAS_ReactRun(&table, period_us, &stop, on_fired, NULL, &report);
+    FAS_ReactPrint(stdout, &table, &report);
+
+    for (int i = 0; i < boards; i++) {
+        FAS_Close(i);
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file LatencyHist.c
+ * @brief 응답시간(us) 히스토그램과 백분위수 계산
+ */
+
+#include <string.h>
+#include "LatencyHist.h"
+
+static int bucket_index(uint32_t us) {
+    if (us < 64) {
+        return us;
+    }
+    int msb = 31 - __builtin_clz(us);
+    int shift = msb - LATENCY_SUB_BITS;
+    return 64 + (msb - 6) * 32 + (int)((us >> shift) - 32);
+}
+
+ /**@brief 칸의 하한값 (us)*/
+static uint32_t bucket_value(int index) {
+    if (index < 64) {
+        return index;
+    }
+    int msb = (index - 64) / 32 + 6;
+    int sub = (index - 64) % 32;
+    return (uint32_t)(32 + sub) << (msb - LATENCY_SUB_BITS);
+}
+
+void LatencyHist_Reset(LATENCY_HIST *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+void LatencyHist_Add(LATENCY_HIST *h, uint32_t us) {
+    h->buckets[bucket_index(us)]++;
+    h->count++;
+    h->total_us += us;
+    if (us > h->max_us) {
+        h->max_us = us;
+    }
+}
+
+void LatencyHist_Merge(LATENCY_HIST *dst, const LATENCY_HIST *src) {
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        dst->buckets[i] += src->buckets[i];
+    }
+    dst->count += src->count;
+    dst->total_us += src->total_us;
+    if (src->max_us > dst->max_us) {
+        dst->max_us = src->max_us;
+    }
+}
+
+ /**@brief 백분위수
+  * @param double percent 0 ~ 100, 예) 99.9
+  * @return 해당 칸의 하한값 (us), 샘플이 없으면 0*/
+uint32_t LatencyHist_Percentile(const LATENCY_HIST *h, double percent) {
+    if (h->count == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(h->count * percent / 100.0);
+    if (rank >= h->count) {
+        rank = h->count - 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen > rank) {
+            return bucket_value(i);
+        }
+    }
+    return h->max_us;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+/**
+ * @file LatencyHist.h
+ * @brief 응답시간(us) 히스토그램과 백분위수 계산
+ * @details 0~63us는 1us 단위, 그 위로는 2배 구간마다 32칸으로 나누므로 오차는 약 3% 이내이다.
+ * 고정 크기 배열만 쓰므로 측정 중에 메모리를 할당하지 않는다.
+ */
+
+#include <stdint.h>
+
+#define LATENCY_SUB_BITS 5
+#define LATENCY_BUCKETS (64 + (32 - 6) * 32) //uint32_t 전체 범위
+
+typedef struct
+{
+    uint64_t count;
+    uint64_t total_us;
+    uint32_t max_us;
+    uint32_t buckets[LATENCY_BUCKETS];
+} LATENCY_HIST;
+
+void LatencyHist_Reset(LATENCY_HIST *h);
+void LatencyHist_Add(LATENCY_HIST *h, uint32_t us);
+void LatencyHist_Merge(LATENCY_HIST *dst, const LATENCY_HIST *src);
+uint32_t LatencyHist_Percentile(const LATENCY_HIST *h, double percent);
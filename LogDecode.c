@@ -0,0 +1,33 @@
+/**
+ * @file LogDecode.c
+ * @brief FAS_LogStart(path)로 남긴 binary 로그를 글자로 바꿔 출력하는 도구
+ * @details 사용법: LogDecode 로그파일 (생략하거나 '-'이면 stdin)
+ * 한 줄에 로그 하나를 "시:분:초.us T스레드 내용"으로 출력한다. 시각은 로그를 남긴 컴퓨터의 지역 시간이다.
+ * 빌드: gcc -O2 -pthread -o LogDecode LogDecode.c FAS_Log.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "FAS_Log.h"
+
+int main(int argc, char *argv[]) {
+    FILE *in = stdin;
+
+    if (argc > 2) {
+        fprintf(stderr, "usage: %s [log file]\n", argv[0]);
+        return 2;
+    }
+    if (argc == 2 && strcmp(argv[1], "-") != 0 && (in = fopen(argv[1], "rb")) == NULL) {
+        perror(argv[1]);
+        return 2;
+    }
+    int count = FAS_LogDecode(in, stdout);
+    if (in != stdin) {
+        fclose(in);
+    }
+    if (count < 0) {
+        fprintf(stderr, "%s: not a FAS log\n", argc == 2 ? argv[1] : "stdin");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+/**
+ * @file MOTION_DEFINE.h
+ * @brief MOTION_EziSERVO2_DEFINE.h가 include하는 공통 정의
+ * @details Fastech 라이브러리의 MOTION_DEFINE.h 중 Ezi-SERVO II 정의 헤더가 쓰는 기본 타입만 옮겨 둠.
+ * 라즈비안에는 windows.h가 없으므로 BYTE, DWORD, LPSTR을 여기서 정의한다.
+ */
+
+#include <stdint.h>
+
+#ifndef FAS_BASIC_TYPES
+#define FAS_BASIC_TYPES
+
+typedef uint8_t BYTE;
+typedef uint32_t DWORD;
+typedef char* LPSTR;
+
+#endif //FAS_BASIC_TYPES
@@ -0,0 +1,371 @@
+/**
+ * @file MotionPlot.c
+ * @brief Status Monitor 창의 위치/속도/상태 실시간 그래프
+ * @details 축마다 PLOT_BUCKETS개의 min/max 버킷만 유지하고, 버킷이 가득 차면 이웃한 두 버킷을 합쳐
+ * 버킷 하나가 담는 샘플 수(span)를 두 배로 늘린다. 몇 시간 분량의 1 kHz 데이터도 메모리가 일정하고,
+ * 짧은 스파이크는 버킷의 min/max에 남으므로 사라지지 않는다.
+ * 그리기는 캐시 surface에 새로 채워진 버킷만 덧그리고, y축 범위 변경/버킷 압축/창 크기 변경 때만 전체를 다시 그린다.
+ */
+
+#include "MotionPlot.h"
+#include "FAS_Trace.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PLOT_MARGIN 4
+#define PLOT_TICK_MS 33 //약 30 fps
+
+typedef struct
+{
+    int32_t min, max;
+} PLOT_SPAN;
+
+typedef struct
+{
+    PLOT_SPAN ch[PLOT_CHANNELS][PLOT_BUCKETS];
+    DWORD status[PLOT_BUCKETS]; //버킷 동안 한 번이라도 켜졌던 플래그 (OR)
+    int count;                  //사용 중인 버킷 수, 마지막 버킷은 아직 채우는 중일 수 있음
+    int fill;                   //마지막 버킷에 들어간 샘플 수
+    int span;                   //버킷 하나가 담는 샘플 수
+    int drawn;                  //캐시에 다 그려진 버킷 수
+    DWORD last_status;
+    int32_t last_pos;
+    gint64 last_time;
+    bool has_pos;
+} PLOT_AXIS;
+
+/**@brief 상태 줄에 표시할 플래그와 색*/
+static const struct
+{
+    DWORD mask;
+    double r, g, b;
+} plot_flags[] = {
+    { 0x00000001, 0.85, 0.10, 0.10 }, //FFLAG_ERRORALL
+    { 0x08000000, 0.10, 0.65, 0.10 }, //FFLAG_MOTIONING
+    { 0x00080000, 0.10, 0.35, 0.85 }, //FFLAG_INPOSITION
+    { 0x00100000, 0.50, 0.50, 0.50 }, //FFLAG_SERVOON
+};
+#define PLOT_FLAG_ROWS ((int)(sizeof(plot_flags) / sizeof(plot_flags[0])))
+
+static const double plot_colors[PLOT_MAX_AXIS][3] = {
+    { 0.00, 0.45, 0.75 }, { 0.85, 0.33, 0.10 }, { 0.47, 0.67, 0.19 }, { 0.49, 0.18, 0.56 },
+};
+
+static const char *plot_names[PLOT_CHANNELS] = { "Position", "Velocity" };
+
+static struct
+{
+    PLOT_AXIS axis[PLOT_MAX_AXIS];
+    int32_t lo[PLOT_CHANNELS], hi[PLOT_CHANNELS]; //현재 y축 범위
+    bool ranged[PLOT_CHANNELS];
+    bool full_redraw;
+    bool dirty;
+    cairo_surface_t *cache;
+    int width, height;
+    GtkWidget *area;
+    guint tick;
+} plot;
+
+/**@brief 버킷이 모두 찼을 때 이웃한 두 버킷을 합쳐 절반으로 줄임*/
+static void plot_compact(PLOT_AXIS *a) {
+    for (int i = 0; i < PLOT_BUCKETS / 2; i++) {
+        for (int c = 0; c < PLOT_CHANNELS; c++) {
+            PLOT_SPAN l = a->ch[c][2 * i], r = a->ch[c][2 * i + 1];
+            a->ch[c][i].min = l.min < r.min ? l.min : r.min;
+            a->ch[c][i].max = l.max > r.max ? l.max : r.max;
+        }
+        a->status[i] = a->status[2 * i] | a->status[2 * i + 1];
+    }
+    a->count = PLOT_BUCKETS / 2;
+    a->span *= 2;
+    a->fill = a->span;
+    plot.full_redraw = true;
+}
+
+/**@brief 값이 y축 범위를 벗어나면 여유를 두고 범위를 넓힘*/
+static void plot_fit(int c, int32_t v) {
+    if (plot.ranged[c] && v >= plot.lo[c] && v <= plot.hi[c]) {
+        return;
+    }
+
+    int64_t lo = plot.ranged[c] ? plot.lo[c] : v;
+    int64_t hi = plot.ranged[c] ? plot.hi[c] : v;
+    if (v < lo) {
+        lo = v;
+    }
+    if (v > hi) {
+        hi = v;
+    }
+    int64_t pad = (hi - lo) / 4 + 1;
+    lo -= pad;
+    hi += pad;
+    plot.lo[c] = lo < INT32_MIN ? INT32_MIN : (int32_t)lo;
+    plot.hi[c] = hi > INT32_MAX ? INT32_MAX : (int32_t)hi;
+    plot.ranged[c] = true;
+    plot.full_redraw = true;
+}
+
+static void plot_push(PLOT_AXIS *a, const int32_t v[PLOT_CHANNELS]) {
+    if (a->span == 0) {
+        a->span = 1;
+    }
+    for (int c = 0; c < PLOT_CHANNELS; c++) {
+        plot_fit(c, v[c]);
+    }
+
+    if (a->count == 0 || a->fill >= a->span) {
+        if (a->count == PLOT_BUCKETS) {
+            plot_compact(a);
+        }
+        int b = a->count++;
+        for (int c = 0; c < PLOT_CHANNELS; c++) {
+            a->ch[c][b].min = a->ch[c][b].max = v[c];
+        }
+        a->status[b] = a->last_status;
+        a->fill = 1;
+    }
+    else {
+        int b = a->count - 1;
+        for (int c = 0; c < PLOT_CHANNELS; c++) {
+            if (v[c] < a->ch[c][b].min) {
+                a->ch[c][b].min = v[c];
+            }
+            if (v[c] > a->ch[c][b].max) {
+                a->ch[c][b].max = v[c];
+            }
+        }
+        a->status[b] |= a->last_status;
+        a->fill++;
+    }
+    plot.dirty = true;
+}
+
+ /**@brief 엔코더 값 한 샘플 추가, 속도는 이전 샘플과의 차이로 구함
+  * @param int axis 축 번호 (0 ~ PLOT_MAX_AXIS-1)
+  * @param int32_t position 엔코더 위치 (pulse)
+  * @param gint64 time_us 수신 시각 (g_get_monotonic_time 기준) */
+void MotionPlot_PushEncoder(int axis, int32_t position, gint64 time_us) {
+    if (axis < 0 || axis >= PLOT_MAX_AXIS) {
+        return;
+    }
+    PLOT_AXIS *a = &plot.axis[axis];
+
+    int32_t v[PLOT_CHANNELS] = { position, 0 };
+    if (a->has_pos && time_us > a->last_time) {
+        int64_t pps = ((int64_t)position - a->last_pos) * 1000000 / (time_us - a->last_time);
+        v[PLOT_VELOCITY] = pps > INT32_MAX ? INT32_MAX : pps < INT32_MIN ? INT32_MIN : (int32_t)pps;
+    }
+    a->last_pos = position;
+    a->last_time = time_us;
+    a->has_pos = true;
+
+    plot_push(a, v);
+}
+
+ /**@brief 축 상태(EZISERVO2_AXISSTATUS.dwValue) 갱신
+  * @details 다음 엔코더 샘플부터 반영되고, 지금 채우는 버킷에도 OR로 남김*/
+void MotionPlot_PushStatus(int axis, DWORD status) {
+    if (axis < 0 || axis >= PLOT_MAX_AXIS) {
+        return;
+    }
+    PLOT_AXIS *a = &plot.axis[axis];
+
+    a->last_status = status;
+    if (a->count > 0) {
+        a->status[a->count - 1] |= status;
+    }
+    plot.dirty = true;
+}
+
+ /**@brief 모든 축의 히스토리를 지움*/
+void MotionPlot_Clear(void) {
+    memset(plot.axis, 0, sizeof(plot.axis));
+    for (int i = 0; i < PLOT_MAX_AXIS; i++) {
+        plot.axis[i].span = 1;
+    }
+    memset(plot.ranged, 0, sizeof(plot.ranged));
+    plot.full_redraw = true;
+    plot.dirty = true;
+}
+
+static double plot_x(int b) {
+    return PLOT_MARGIN + (double)b * (plot.width - 2 * PLOT_MARGIN) / PLOT_BUCKETS;
+}
+
+static void plot_strip(int c, double *y0, double *h) {
+    double usable = plot.height - 2 * PLOT_MARGIN;
+    *h = usable * 0.4;
+    *y0 = PLOT_MARGIN + c * *h;
+}
+
+static double plot_y(int c, int32_t v) {
+    double y0, h;
+    plot_strip(c, &y0, &h);
+    double span = (double)plot.hi[c] - plot.lo[c];
+    return y0 + h - ((double)v - plot.lo[c]) / span * h;
+}
+
+/**@brief 버킷 하나를 세로 막대(min~max)로 그림*/
+static void plot_draw_bucket(cairo_t *cr, int axis, int b) {
+    PLOT_AXIS *a = &plot.axis[axis];
+    double x = plot_x(b);
+    double w = plot_x(b + 1) - x;
+    if (w < 1.0) {
+        w = 1.0;
+    }
+
+    cairo_set_source_rgb(cr, plot_colors[axis][0], plot_colors[axis][1], plot_colors[axis][2]);
+    for (int c = 0; c < PLOT_CHANNELS; c++) {
+        double top = plot_y(c, a->ch[c][b].max);
+        double bottom = plot_y(c, a->ch[c][b].min);
+        cairo_rectangle(cr, x, top, w, bottom - top < 1.0 ? 1.0 : bottom - top);
+    }
+    cairo_fill(cr);
+
+    double sy = PLOT_MARGIN + (plot.height - 2 * PLOT_MARGIN) * 0.8;
+    double row = (plot.height - PLOT_MARGIN - sy) / (PLOT_FLAG_ROWS * PLOT_MAX_AXIS);
+    for (int f = 0; f < PLOT_FLAG_ROWS; f++) {
+        if ((a->status[b] & plot_flags[f].mask) == 0) {
+            continue;
+        }
+        cairo_set_source_rgb(cr, plot_flags[f].r, plot_flags[f].g, plot_flags[f].b);
+        cairo_rectangle(cr, x, sy + (f * PLOT_MAX_AXIS + axis) * row, w, row);
+        cairo_fill(cr);
+    }
+}
+
+/**@brief 캐시 surface 전체를 배경부터 다시 그림*/
+static void plot_draw_background(cairo_t *cr) {
+    cairo_set_source_rgb(cr, 1, 1, 1);
+    cairo_paint(cr);
+
+    cairo_set_line_width(cr, 1);
+    cairo_set_font_size(cr, 10);
+    for (int c = 0; c < PLOT_CHANNELS; c++) {
+        double y0, h;
+        plot_strip(c, &y0, &h);
+        cairo_set_source_rgb(cr, 0.85, 0.85, 0.85);
+        cairo_rectangle(cr, PLOT_MARGIN + 0.5, y0 + 0.5, plot.width - 2 * PLOT_MARGIN - 1, h - 1);
+        cairo_stroke(cr);
+
+        char label[64];
+        if (plot.ranged[c]) {
+            snprintf(label, sizeof(label), "%s [%d, %d]", plot_names[c], plot.lo[c], plot.hi[c]);
+        }
+        else {
+            snprintf(label, sizeof(label), "%s", plot_names[c]);
+        }
+        cairo_set_source_rgb(cr, 0.3, 0.3, 0.3);
+        cairo_move_to(cr, PLOT_MARGIN + 4, y0 + 12);
+        cairo_show_text(cr, label);
+    }
+}
+
+/**@brief 캐시에 아직 그리지 않은 버킷만 그림, 필요하면 전체 다시 그리기*/
+static void plot_render(void) {
+    cairo_t *cr = cairo_create(plot.cache);
+
+    if (plot.full_redraw) {
+        plot_draw_background(cr);
+        for (int i = 0; i < PLOT_MAX_AXIS; i++) {
+            plot.axis[i].drawn = 0;
+        }
+        plot.full_redraw = false;
+    }
+    for (int i = 0; i < PLOT_MAX_AXIS; i++) {
+        PLOT_AXIS *a = &plot.axis[i];
+        if (!plot.ranged[PLOT_POSITION]) {
+            break;
+        }
+        //마지막 버킷은 min/max가 넓어지기만 하므로 덧그려도 이전 그림을 덮어쓰지 않음
+        for (int b = a->drawn; b < a->count; b++) {
+            plot_draw_bucket(cr, i, b);
+        }
+        a->drawn = a->count > 0 ? a->count - 1 : 0;
+    }
+    cairo_destroy(cr);
+}
+
+static gboolean on_plot_draw(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
+    int width = gtk_widget_get_allocated_width(widget);
+    int height = gtk_widget_get_allocated_height(widget);
+
+    if (plot.cache == NULL || width != plot.width || height != plot.height) {
+        if (plot.cache != NULL) {
+            cairo_surface_destroy(plot.cache);
+        }
+        plot.cache = gdk_window_create_similar_surface(gtk_widget_get_window(widget), CAIRO_CONTENT_COLOR, width, height);
+        plot.width = width;
+        plot.height = height;
+        plot.full_redraw = true;
+    }
+    FAS_TRACE_BEGIN(span, "plot draw", 0);
+    plot_render();
+
+    cairo_set_source_surface(cr, plot.cache, 0, 0);
+    cairo_paint(cr);
+    FAS_TRACE_END(span);
+    return FALSE;
+}
+
+ /**@brief 새 샘플이 있으면 바뀐 영역만 다시 그리도록 요청*/
+static gboolean on_plot_tick(gpointer user_data) {
+    if (plot.area == NULL) {
+        return G_SOURCE_REMOVE;
+    }
+    if (!plot.dirty) {
+        return G_SOURCE_CONTINUE;
+    }
+    plot.dirty = false;
+
+    if (plot.full_redraw || plot.cache == NULL) {
+        gtk_widget_queue_draw(plot.area);
+        return G_SOURCE_CONTINUE;
+    }
+    int from = PLOT_BUCKETS, to = 0;
+    for (int i = 0; i < PLOT_MAX_AXIS; i++) {
+        if (plot.axis[i].count == 0) {
+            continue;
+        }
+        if (plot.axis[i].drawn < from) {
+            from = plot.axis[i].drawn;
+        }
+        if (plot.axis[i].count > to) {
+            to = plot.axis[i].count;
+        }
+    }
+    if (from < to) {
+        int x = (int)plot_x(from);
+        gtk_widget_queue_draw_area(plot.area, x, 0, (int)plot_x(to) - x + 2, plot.height);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static void on_plot_destroy(GtkWidget *widget, gpointer user_data) {
+    if (plot.tick != 0) {
+        g_source_remove(plot.tick);
+    }
+    plot.tick = 0;
+    plot.area = NULL;
+    if (plot.cache != NULL) {
+        cairo_surface_destroy(plot.cache);
+    }
+    plot.cache = NULL;
+}
+
+ /**@brief 그래프 위젯 생성, 히스토리는 위젯과 별개로 계속 유지됨
+  * @return GtkDrawingArea*/
+GtkWidget *MotionPlot_New(void) {
+    if (plot.axis[0].span == 0) {
+        MotionPlot_Clear();
+    }
+
+    plot.area = gtk_drawing_area_new();
+    gtk_widget_set_size_request(plot.area, 600, 360);
+    g_signal_connect(plot.area, "draw", G_CALLBACK(on_plot_draw), NULL);
+    g_signal_connect(plot.area, "destroy", G_CALLBACK(on_plot_destroy), NULL);
+    plot.tick = g_timeout_add(PLOT_TICK_MS, on_plot_tick, NULL);
+    plot.full_redraw = true;
+    return plot.area;
+}
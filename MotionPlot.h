@@ -0,0 +1,25 @@
+#pragma once
+
+/**
+ * @file MotionPlot.h
+ * @brief Status Monitor 창의 위치/속도/상태 실시간 그래프
+ */
+
+#include <gtk/gtk.h>
+#include <stdint.h>
+#include "MOTION_EziSERVO2_DEFINE.h"
+
+#define PLOT_MAX_AXIS 4
+#define PLOT_BUCKETS 2048 //축마다 유지하는 min/max 버킷 수 (히스토리 메모리 상한)
+
+typedef enum
+{
+    PLOT_POSITION = 0,
+    PLOT_VELOCITY,
+    PLOT_CHANNELS
+} PLOT_CHANNEL;
+
+GtkWidget *MotionPlot_New(void);
+void MotionPlot_PushEncoder(int axis, int32_t position, gint64 time_us);
+void MotionPlot_PushStatus(int axis, DWORD status);
+void MotionPlot_Clear(void);
@@ -5,12 +5,14 @@
  * @version 0.0.0.1
  * @brief Fastech 프로그램의 Protocol Test 구현을 위한 프로그램
  * @details C언어와 GTK3(라즈비안(데비안11) 호환을 위해서), GLADE(UI XML->.glade파일) 사용
- * Ethernet 부분(Ezi Servo Plus-E 모델용)만 구현, 
- * 라이브러리로 분리할 만한 기본 함수, GUI프로그램 구현 함수가 섞인 상태
+ * Ethernet(Ezi Servo Plus-E 모델용), RS-485(Plus-R 모델용) 구현, 연결과 송수신은 FAS_Library로 분리함
+ * 프레임을 만드는 기본 함수와 GUI프로그램 구현 함수는 아직 섞인 상태
+ * 빌드: gcc -o ProtocolTest ProtocolTest.c MotionPlot.c StatusAnalyze.c EncoderStore.c FAS_Library.c FAS_Frame.c FAS_Log.c FAS_Trace.c FAS_Macro.c LatencyHist.c FAS_Inventory.c FAS_Poll.c FAS_Ethernet.c FAS_Uring.c FAS_Serial.c FAS_Gateway.c `pkg-config --cflags --libs gtk+-3.0`
  * @warning 동작 시 예외처리가 제대로 안되어있으니 정확한 절차로만 작동시킬것
  */
 
 #include <gtk/gtk.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -19,35 +21,41 @@
 #include <unistd.h>
 #include <time.h>
 #include <inttypes.h>
-#include <arpa/inet.h>
 #include "ReturnCodes_Define.h"
-
+#include "MOTION_EziSERVO2_DEFINE.h"
+#include "FAS_Library.h"
+#include "FAS_Serial.h"
+#include "FAS_Macro.h"
+#include "FAS_Frame.h"
+#include "FAS_Inventory.h"
+#include "FAS_Poll.h"
+#include "FAS_Trace.h"
+#include "FAS_Log.h"
+#include "MotionPlot.h"
+#include "StatusAnalyze.h"
+#include "EncoderStore.h"
 
 /************************************************************************************************************************************
  ********************************나중에 라이브러리로 뺄 FASTECH 라이브러리와 같은 기능의 함수*************************************************
  ************************************************************************************************************************************/
  
-typedef uint8_t BYTE;
-typedef uint32_t DWORD;
-typedef char* LPSTR;
-
-#define BUFFER_SIZE 258
-#define DATA_SIZE 253
-#define PORT 3001 //UDP GUI
-
-int client_socket;
-struct sockaddr_in server_addr;
+#define REQUEST_TIMEOUT_MS 100 //모니터링 요청의 응답 대기 시간
+#define MONITOR_POLL_MS 20 //Status Monitor 창의 그래프/상태 캡처 주기, 축이 움직일 때의 요청 주기
+#define MONITOR_NORMAL_MS 100 //servo on 정지 중 요청 주기
+#define MONITOR_SLOW_MS 500 //servo off 또는 in-position일 때 요청 주기
+#define MONITOR_BUDGET_FPS 100 //Status Monitor가 보내는 초당 프레임 수 한도
+#define STATUS_CHATTER_MS 100 //Analyze Flag에서 이보다 짧게 켜졌다 꺼진 플래그를 chatter로 셈
+#define ENCODER_FLUSH_US 10000000 //엔코더 기록을 파일에 쓰는 최대 간격, 전원이 꺼지면 이만큼까지 잃을 수 있음
+#define MACRO_SLOTS 4 //Record 탭의 기록/전송 칸 수
+#define LIST_STAT_MS 200 //List 탭 실행 중 통계를 다시 그리는 주기
+#define INVENTORY_PATH "fas_inventory.tsv" //연결했던 드라이브의 보드/모터/펌웨어 정보 캐시
 
 static BYTE header, sync_no, frame_type;
 static BYTE data[DATA_SIZE];
-static BYTE buffer[BUFFER_SIZE];
+static FAS_FRAME *send_frame; //마지막으로 만든 요청 프레임, library_interface가 새로 잡음
 
 char *protocol;
-
-bool FAS_Connect(BYTE sb1, BYTE sb2, BYTE sb3, BYTE sb4, int iBdID);
-bool FAS_ConnectTCP(BYTE sb1, BYTE sb2, BYTE sb3, BYTE sb4, int iBdID);
-
-void FAS_Close(int iBdID);
+static bool connected;
 
 int FAS_ServoEnable(int iBdID, bool bOnOff);
 int FAS_MoveOriginSingleAxis(int iBdID);
@@ -62,12 +70,20 @@ int FAS_SaveAllParameters(int iBdID);
 int FAS_ServoAlarmReset(int iBdID);
 int FAS_EmergencyStop(int iBdID);
 int FAS_GetAlarmType(int iBdID);
+int FAS_GetAxisStatus(int iBdID);
 
 /************************************************************************************************************************************
  ***************************GUI 프로그램의 버튼 등 구성요소들에서 사용하는 callback등 여러 함수***********************************************
  ************************************************************************************************************************************/
 static void on_button_connect_clicked(GtkButton *button, gpointer user_data);
 static void on_button_send_clicked(GtkButton *button, gpointer user_data);
+static void on_button_statusmonitor_clicked(GtkButton *button, gpointer user_data);
+static void on_button_calccrc_clicked(GtkButton *button, gpointer user_data);
+static void on_button_analyzeflag_clicked(GtkButton *button, gpointer user_data);
+static void on_button_record_clicked(GtkButton *button, gpointer user_data);
+static void on_button_transfer_clicked(GtkButton *button, gpointer user_data);
+static void on_button_listrun_clicked(GtkButton *button, gpointer user_data);
+static void on_button_listclear_clicked(GtkButton *button, gpointer user_data);
 
 static void on_combo_protocol_changed(GtkComboBoxText *combo_text, gpointer user_data);
 static void on_combo_command_changed(GtkComboBox *combo_id, gpointer user_data);
@@ -76,6 +92,7 @@ static void on_combo_direction_changed(GtkComboBox *combo_id, gpointer user_data
 
 static void on_check_autosync_toggled(GtkToggleButton *togglebutton, gpointer user_data);
 static void on_check_fastech_toggled(GtkToggleButton *togglebutton, gpointer user_data);
+static void on_check_uselist_toggled(GtkToggleButton *togglebutton, gpointer user_data);
 
 /************************************************************************************************************************************
  ******************************************************* 편의상 만든 함수 **************************************************************
@@ -89,12 +106,42 @@ GtkTextBuffer *sendbuffer_buffer;
 GtkTextBuffer *monitor1_buffer;
 GtkTextBuffer *monitor2_buffer;
 GtkTextBuffer *autosync_buffer;
+GtkWidget *monitor_window;
+static GThread *monitor_thread; //엔코더와 축 상태를 요청하는 스레드, Status Monitor가 열려 있는 동안만 있음
+static volatile bool monitor_stop;
+static GMutex board_lock;     //보드 0으로 요청을 보내는 곳(Send 버튼, Status Monitor, 매크로, 목록)이 하나씩만 보내도록 잡음
+static FILE *status_capture; //Status Monitor가 열려 있는 동안 축 상태를 저장하는 파일
+static ENCODER_STORE *encoder_store; //Status Monitor가 열려 있는 동안 엔코더 값을 날짜별로 쌓는 파일
+static int64_t encoder_epoch_us;      //열 때의 벽시계 - monotonic, 기록 중에 벽시계가 바뀌어도 시간이 거꾸로 가지 않음
+static FAS_POLLER monitor_poller; //축 상태에 따라 Status Monitor의 요청 주기를 정함, monitor_thread만 씀
+static gint64 capture_time;   //status_capture에 마지막으로 쓴 tick의 시각 (드라이브가 읽은 monotonic 시각), 0이면 아직 쓰지 않음
+static DWORD capture_last;    //status_capture에 마지막으로 쓴 축 상태
+GtkTextBuffer *record_buffer[MACRO_SLOTS];
+static FAS_MACRO macros[MACRO_SLOTS];
+static FAS_MACRO_RESULT macro_result;
+static GThread *macro_thread; //전송 중인 매크로, 없으면 NULL
+static volatile bool macro_stop;
+static int macro_slot, macro_loops, macro_rate;
+GtkTextBuffer *list_buffer;
+GtkToggleButton *check_uselist; //켜져 있으면 Send 버튼이 보내지 않고 명령을 List 탭의 목록에 추가
+GtkToggleButton *check_showsend; //꺼져 있으면 보낼 프레임을 monitor에 출력하지 않음
+static FAS_MACRO send_list;
+static FAS_MACRO_RESULT list_result; //실행 중에는 FAS_MacroSnapshot으로 읽음
+static GThread *list_thread; //실행 중인 목록, 없으면 NULL
+static volatile bool list_stop;
+static int list_loops, list_rate;
+static guint list_timer;
  
 void print_buffer(uint8_t *array, size_t size);
-void library_interface();
+bool library_interface();
 char *command_interface();
 char *FMM_interface(FMM_ERROR error);
-char* array_to_string(const unsigned char *array, int size);
+void plot_reply(const BYTE *reply, ssize_t size, gint64 acquired_us);
+int request_frame(BYTE type, BYTE *reply, int reply_size, gint64 *acquired_us);
+void print_inventory(int iBdID);
+static gboolean on_inventory_poll(gpointer user_data);
+static void lock_board(int iBdID, bool lock, void *user);
+static void add_list_item(void);
 
  /**@brief Main 함수*/
 int main(int argc, char *argv[]) {
@@ -107,6 +154,11 @@ int main(int argc, char *argv[]) {
     GError *error = NULL;
     
     srand(time(NULL));
+    // 환경 변수 FAS_LOG에 경로를 주면 binary 로그 파일로 남기고(LogDecode로 읽음), 없으면 기록 스레드가 stdout에 씀
+    FAS_LogStart(getenv("FAS_LOG"));
+    // 환경 변수 FAS_TRACE에 경로를 주면 요청 단계별 구간을 남겼다가 끝날 때 Chrome trace 형식으로 씀 (ui.perfetto.dev에서 열기)
+    FAS_TraceStart(getenv("FAS_TRACE"));
+    FAS_InventoryLoad(INVENTORY_PATH);
 
     header = 0xAA;
     sync_no = (BYTE)(rand() % 256);
@@ -144,6 +196,30 @@ int main(int argc, char *argv[]) {
     g_signal_connect(button, "clicked", G_CALLBACK(on_button_connect_clicked), builder);
     button = gtk_builder_get_object(builder, "button_send");
     g_signal_connect(button, "clicked", G_CALLBACK(on_button_send_clicked), builder);
+    button = gtk_builder_get_object(builder, "button_statusmonitor");
+    g_signal_connect(button, "clicked", G_CALLBACK(on_button_statusmonitor_clicked), NULL);
+    button = gtk_builder_get_object(builder, "button_calccrc");
+    g_signal_connect(button, "clicked", G_CALLBACK(on_button_calccrc_clicked), NULL);
+    button = gtk_builder_get_object(builder, "button_analyzeflag");
+    g_signal_connect(button, "clicked", G_CALLBACK(on_button_analyzeflag_clicked), NULL);
+    for (int i = 0; i < MACRO_SLOTS; i++) {
+        char id[32];
+        snprintf(id, sizeof(id), "record_command%d", i + 1);
+        record_buffer[i] = gtk_text_view_get_buffer(GTK_TEXT_VIEW(gtk_builder_get_object(builder, id)));
+        snprintf(id, sizeof(id), "button_record%d", i + 1);
+        button = gtk_builder_get_object(builder, id);
+        g_object_set_data(button, "slot", GINT_TO_POINTER(i));
+        g_signal_connect(button, "clicked", G_CALLBACK(on_button_record_clicked), builder);
+        snprintf(id, sizeof(id), "button_transfer%d", i + 1);
+        button = gtk_builder_get_object(builder, id);
+        g_object_set_data(button, "slot", GINT_TO_POINTER(i));
+        g_signal_connect(button, "clicked", G_CALLBACK(on_button_transfer_clicked), builder);
+    }
+    list_buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(gtk_builder_get_object(builder, "text_list")));
+    button = gtk_builder_get_object(builder, "button_listrun");
+    g_signal_connect(button, "clicked", G_CALLBACK(on_button_listrun_clicked), builder);
+    button = gtk_builder_get_object(builder, "button_listclear");
+    g_signal_connect(button, "clicked", G_CALLBACK(on_button_listclear_clicked), builder);
     
     combo_text = GTK_COMBO_BOX_TEXT(gtk_builder_get_object(builder, "combo_protocol"));
     g_signal_connect(combo_text, "changed", G_CALLBACK(on_combo_protocol_changed), NULL);
@@ -160,6 +236,9 @@ int main(int argc, char *argv[]) {
     g_signal_connect(checkbox, "toggled", G_CALLBACK(on_check_autosync_toggled), NULL);
     checkbox = gtk_builder_get_object(builder, "check_fastech");
     g_signal_connect(checkbox, "toggled", G_CALLBACK(on_check_fastech_toggled), NULL);
+    check_uselist = GTK_TOGGLE_BUTTON(gtk_builder_get_object(builder, "check_uselist"));
+    g_signal_connect(check_uselist, "toggled", G_CALLBACK(on_check_uselist_toggled), builder);
+    check_showsend = GTK_TOGGLE_BUTTON(gtk_builder_get_object(builder, "check_showsend"));
     
     char sync_str[4];
     sprintf(sync_str, "%u", sync_no);
@@ -170,6 +249,8 @@ int main(int argc, char *argv[]) {
     gtk_widget_set_sensitive(GTK_WIDGET(button_send), FALSE);
     // Start the GTK main loop
     gtk_main();
+    FAS_TraceStop();
+    FAS_LogStop();
 
     return 0;
 }
@@ -181,6 +262,7 @@ int main(int argc, char *argv[]) {
  /**@brief Connect버튼의 callback*/
 static void on_button_connect_clicked(GtkButton *button, gpointer user_data) {
     BYTE sb1, sb2, sb3, sb4;
+    bool result = false;
     
     // Get the GtkBuilder object passed as user data
     GtkBuilder *builder = GTK_BUILDER(user_data);
@@ -189,14 +271,48 @@ static void on_button_connect_clicked(GtkButton *button, gpointer user_data) {
     const char *label_text = gtk_button_get_label(button);
     GObject *button_send = gtk_builder_get_object(builder, "button_send");
 
+    if (strcmp(label_text, "Disconn") == 0)
+    {
+        connected = false;
+        g_mutex_lock(&board_lock); //Status Monitor가 보내는 중이면 끝날 때까지 기다렸다가 닫음
+        FAS_Close(0);
+        g_mutex_unlock(&board_lock);
+        gtk_button_set_label(button, "Connect");
+        gtk_widget_set_sensitive(GTK_WIDGET(button_send), FALSE);
+        return;
+    }
+    if (protocol == NULL) {
+        g_print("Select Protocol\n");
+        return;
+    }
+
     // Get the entry widget by its ID
     GtkEntry *entry_ip = GTK_ENTRY(gtk_builder_get_object(builder, "entry_ip"));
 
     // Get the entered text from the entry
     const char *ip_text = gtk_entry_get_text(entry_ip);
 
+    if (strcmp(protocol, "RS485") == 0) {
+        // RS485는 IP 대신 "장치경로@baud" 입력, 예) /dev/ttyUSB0@115200 (baud 생략 시 115200)
+        char *device = g_strdup(ip_text);
+        char *at = strchr(device, '@');
+        int baud = 115200;
+        if (at != NULL) {
+            *at = '\0';
+            baud = atoi(at + 1);
+        }
+        g_print("Serial: %s %d baud\n", device, baud);
+        result = FAS_ConnectSerial(device, baud, 0);
+        g_free(device);
+    }
+    else if (strcmp(protocol, "Gateway") == 0) {
+        // DriveGateway를 거쳐 연결, 입력칸은 socket 경로 (비우면 FAS_GATEWAY_PATH)
+        const char *path = ip_text[0] != '\0' ? ip_text : FAS_GATEWAY_PATH;
+        g_print("Gateway: %s\n", path);
+        result = FAS_ConnectGateway(path, 0);
+    }
     // Check if the IP is valid (For a simple example, let's assume it's valid if it's not empty)
-    if (g_strcmp0(ip_text, "") != 0) {
+    else if (g_strcmp0(ip_text, "") != 0) {
         g_print("IP: %s\n", ip_text);
 
         // Parse and store IP address in BYTE format
@@ -228,37 +344,83 @@ static void on_button_connect_clicked(GtkButton *button, gpointer user_data) {
         }
         g_print("Parsed IP: %d.%d.%d.%d\n", sb1, sb2, sb3, sb4);
         g_free(ip_copy);
-    }
-    else {
-            g_print("Please enter a valid IP.\n");
-    }
-        
-    // Check the current label and update it accordingly
-    if (strcmp(label_text, "Connect") == 0)
-    {
-        gtk_button_set_label(button, "Disconn");
-        gtk_widget_set_sensitive(GTK_WIDGET(button_send), TRUE);
         
         if(strcmp(protocol, "TCP") == 0){
-        FAS_ConnectTCP(sb1, sb2, sb3, sb4, 0);
-        g_print("Selected Protocol: %s\n", protocol);
+            result = FAS_ConnectTCP(sb1, sb2, sb3, sb4, 0);
         }
-        else if(strcmp(protocol, "UDP") == 0){
-            FAS_Connect(sb1, sb2, sb3, sb4, 0);
-            g_print("Selected Protocol: %s\n", protocol);
-        }
-        else if(protocol != NULL){
-            g_print("Select Protocol\n");
+        else if(strncmp(protocol, "UDP", 3) == 0){
+            // UDP(io_uring)은 제출/대기를 시스템 콜 한 번으로, UDP(SQPOLL)은 남는 코어가 있을 때만 이득
+            if (strcmp(protocol, "UDP(io_uring)") == 0) {
+                FAS_SetEthernetBackend(FAS_BACKEND_URING);
+            }
+            else if (strcmp(protocol, "UDP(SQPOLL)") == 0) {
+                FAS_SetEthernetBackend(FAS_BACKEND_URING_SQPOLL);
+            }
+            else {
+                FAS_SetEthernetBackend(FAS_BACKEND_SOCKET);
+            }
+            result = FAS_Connect(sb1, sb2, sb3, sb4, 0);
         }
     }
-    else if (strcmp(label_text, "Disconn") == 0)
-    {
-        FAS_Close(0);
-        gtk_button_set_label(button, "Connect");
-        gtk_widget_set_sensitive(GTK_WIDGET(button_send), FALSE);
+    else {
+        g_print("Please enter a valid IP.\n");
+        return;
+    }
+    g_print("Selected Protocol: %s\n", protocol);
+    
+    if (!result) {
+        g_print("Connection failed\n");
+        return;
+    }
+    gtk_button_set_label(button, "Disconn");
+    g_mutex_lock(&board_lock);
+    connected = true;
+    g_mutex_unlock(&board_lock);
+    
+    // 캐시의 정보를 믿고 바로 명령을 받고, 드라이브에 다시 확인하는 요청은 board_lock으로 사용자 요청과 번갈아 보냄
+    print_inventory(0);
+    gtk_widget_set_sensitive(GTK_WIDGET(button_send), TRUE);
+    if (FAS_InventoryRevalidate(lock_board, NULL)) {
+        gtk_widget_set_sensitive(GTK_WIDGET(button), FALSE); //확인 중에는 FAS_Close 하지 않음
+        g_timeout_add(10, on_inventory_poll, builder);
     }
 }
 
+ /**@brief 보드 정보 재확인이 요청 묶음마다 부름, Send 버튼/Status Monitor/매크로/목록과 같은 board_lock으로 차례를 지킴*/
+static void lock_board(int iBdID, bool lock, void *user) {
+    if (lock) {
+        g_mutex_lock(&board_lock);
+    }
+    else {
+        g_mutex_unlock(&board_lock);
+    }
+}
+
+ /**@brief 보드 정보 캐시의 내용을 출력*/
+void print_inventory(int iBdID) {
+    static const char *states[] = { "UNKNOWN", "CACHED", "VALID", "CHANGED", "OFFLINE" };
+    FAS_INVENTORY info;
+    
+    if (!FAS_InventoryGet(iBdID, &info)) {
+        g_print("Inventory %s: %s\n", info.address, states[info.state]);
+        return;
+    }
+    g_print("Inventory %s: %s, board %u %s, motor %u %s, firmware %s, param checksum %08X\n", info.address, states[info.state],
+            info.board_type, info.board_name, info.motor_type, info.motor_name, info.firmware, info.param_checksum);
+}
+
+ /**@brief 보드 정보 재확인이 끝나면 결과를 출력하고 Connect 버튼을 다시 켬 (매크로/목록 전송 중이면 그쪽이 끝날 때 켬)*/
+static gboolean on_inventory_poll(gpointer user_data) {
+    GtkBuilder *builder = GTK_BUILDER(user_data);
+    
+    if (!FAS_InventoryWait(0)) {
+        return G_SOURCE_CONTINUE;
+    }
+    print_inventory(0);
+    gtk_widget_set_sensitive(GTK_WIDGET(gtk_builder_get_object(builder, "button_connect")), macro_thread == NULL && list_thread == NULL);
+    return G_SOURCE_REMOVE;
+}
+
  /**@brief Send버튼의 callback*/
 static void on_button_send_clicked(GtkButton *button, gpointer user_data){
     sync_no++;
@@ -266,53 +428,69 @@ static void on_button_send_clicked(GtkButton *button, gpointer user_data){
     sprintf(sync_str, "%u", sync_no);
     
     gtk_text_buffer_set_text(autosync_buffer, sync_str, -1);
-    library_interface();
+    FAS_TRACE_BEGIN(encode, "encode", frame_type);
+    bool encoded = library_interface();
+    FAS_TRACE_END(encode);
+    if (!encoded) {
+        return;
+    }
+    if (gtk_toggle_button_get_active(check_uselist)) {
+        add_list_item();
+        return;
+    }
     
-    int send_result = sendto(client_socket, buffer, buffer[1] + 2, 0, (const struct sockaddr *)&server_addr, sizeof(server_addr)); 
+    g_mutex_lock(&board_lock);
+    int send_result = FAS_SendFrame(0, send_frame->data, send_frame->size);
     if (send_result < 0) {
-        perror("sendto failed");
+        FAS_LOG("sendto failed: %s", strerror(errno));
     }
-    while(1){
-        ssize_t received_bytes = recvfrom(client_socket, buffer, sizeof(buffer), 0, NULL, NULL);
-        if (received_bytes < 0) {
-            perror("recvfrom failed");
-            continue;
-        }
-
-        // Print the received data in hexadecimal format
-        printf("Server: ");
-        for (ssize_t i = 0; i < received_bytes; i++) {
-            printf("%02x ", (BYTE)buffer[i]);
-        }
-        printf("\n");
-        FMM_ERROR errorCode = buffer[5];
-        char *errorMsg = FMM_interface(errorCode);
-        
-        char *response_text = array_to_string(buffer, received_bytes);
-        GtkTextIter iter;
-        gtk_text_buffer_get_end_iter(monitor1_buffer, &iter);
-        gtk_text_buffer_insert(monitor1_buffer, &iter, "\n", -1); // Add a newline
-        gtk_text_buffer_insert(monitor1_buffer, &iter, "\n", -1); // Add a newline
-        gtk_text_buffer_insert(monitor1_buffer, &iter, response_text, -1);
-        char *command = command_interface();
-        gtk_text_buffer_get_end_iter(monitor2_buffer, &iter);
-        gtk_text_buffer_insert(monitor2_buffer, &iter, "[RECEIVE]", -1);
-        gtk_text_buffer_insert(monitor2_buffer, &iter, "\n", -1);
-        gtk_text_buffer_insert(monitor2_buffer, &iter, command, -1);
-        gtk_text_buffer_insert(monitor2_buffer, &iter, "\n", -1);
-        gtk_text_buffer_insert(monitor2_buffer, &iter, "RESPONSE : ", -1);
-        gtk_text_buffer_insert(monitor2_buffer, &iter, errorMsg, -1);
-        
-        break;
+    // 응답은 pool 프레임에 바로 받아 터미널, 화면, 그래프가 복사 없이 같이 씀
+    FAS_TRACE_BEGIN(wait, "wait reply", frame_type);
+    FAS_FRAME *reply = FAS_FrameRecv(0, REQUEST_TIMEOUT_MS);
+    FAS_TRACE_END(wait);
+    g_mutex_unlock(&board_lock);
+    if (reply == NULL) {
+        FAS_LOG("FMC_TIMEOUT_ERROR");
+        return;
+    }
+    FAS_LOG_BYTES("Server: %s", reply->data, reply->size);
+    if (reply->size < 6) { // [AA][길이][sync][00][type][통신상태]보다 짧으면 통신상태를 읽을 수 없음
+        FAS_LOG("FMC_RECVPACKET_ERROR");
+        FAS_FrameUnref(reply);
+        return;
     }
-    memset(&buffer, 0, sizeof(buffer));
+    FAS_TRACE_BEGIN(parse, "parse", reply->size);
+    const char *response_text = FAS_FrameText(reply);
+    FMM_ERROR errorCode = reply->data[5];
+    char *errorMsg = FMM_interface(errorCode);
+    FAS_TRACE_END(parse);
+    
+    FAS_TRACE_BEGIN(gui, "gui update", frame_type);
+    GtkTextIter iter;
+    gtk_text_buffer_get_end_iter(monitor1_buffer, &iter);
+    gtk_text_buffer_insert(monitor1_buffer, &iter, "\n", -1); // Add a newline
+    gtk_text_buffer_insert(monitor1_buffer, &iter, "\n", -1); // Add a newline
+    gtk_text_buffer_insert(monitor1_buffer, &iter, response_text, -1);
+    char *command = command_interface();
+    gtk_text_buffer_get_end_iter(monitor2_buffer, &iter);
+    gtk_text_buffer_insert(monitor2_buffer, &iter, "[RECEIVE]", -1);
+    gtk_text_buffer_insert(monitor2_buffer, &iter, "\n", -1);
+    gtk_text_buffer_insert(monitor2_buffer, &iter, command, -1);
+    gtk_text_buffer_insert(monitor2_buffer, &iter, "\n", -1);
+    gtk_text_buffer_insert(monitor2_buffer, &iter, "RESPONSE : ", -1);
+    gtk_text_buffer_insert(monitor2_buffer, &iter, errorMsg, -1);
+    
+    plot_reply(reply->data, reply->size, g_get_monotonic_time());
+    FAS_TRACE_END(gui);
+    FAS_FrameUnref(reply);
 }
 
  /**@brief TCP/UDP 프로토콜 선택 콤보박스의 callback*/
 static void on_combo_protocol_changed(GtkComboBoxText *combo_text, gpointer user_data) {
+    g_free(protocol); // gtk_combo_box_text_get_active_text는 매번 새 문자열을 돌려줌
     protocol = gtk_combo_box_text_get_active_text(combo_text);
     if (protocol != NULL) {
-        g_print("Selected Protocol: %s\n", protocol);
+        FAS_LOG("Selected Protocol: %s", protocol);
     }
 }
 
@@ -336,18 +514,18 @@ static void on_combo_command_changed(GtkComboBox *combo_id, gpointer user_data)
     }
     
     if (selected_id  != NULL) {
-        g_print("Selected Command: %s\n", selected_id);
+        FAS_LOG("Selected Command: %s", selected_id);
         char* endptr;
         unsigned long int value = strtoul(selected_id, &endptr, 16);
         if (*endptr == '\0' && value <= UINT8_MAX) {
             frame_type = (uint8_t)value;
         } else {
-            g_print("Invalid input: %s\n", selected_id);
+            FAS_LOG("Invalid input: %s", selected_id);
         }
     } else {
-        g_print("No item selected.\n");
+        FAS_LOG("No item selected.");
     }
-    g_print("Converted Frame: %X \n", frame_type);
+    FAS_LOG("Converted Frame: %X", frame_type);
 }
 
  /**@brief 명령어 콤보박스 combo_data1의 callback*/
@@ -355,18 +533,18 @@ static void on_combo_data1_changed(GtkComboBox *combo_id, gpointer user_data) {
     const gchar *selected_id = gtk_combo_box_get_active_id(combo_id);
     memset(&data, 0, sizeof(data));
     if (selected_id != NULL) {
-        g_print("Selected Data: %s\n", selected_id);
+        FAS_LOG("Selected Data: %s", selected_id);
         char* endptr;
         unsigned long int value = strtoul(selected_id, &endptr, 16);
         if (*endptr == '\0' && value <= UINT8_MAX) {
             data[0] = (uint8_t)value;
         } else {
-            g_print("Invalid input: %s\n", selected_id);
+            FAS_LOG("Invalid input: %s", selected_id);
         }
     } else {
-        g_print("No item selected.\n");
+        FAS_LOG("No item selected.");
     }
-    g_print("Converted Data: %X \n", data[0]);
+    FAS_LOG("Converted Data: %X", data[0]);
 }
 
  /**@brief AutoSync 체크박스의 callback*/
@@ -374,10 +552,10 @@ static void on_check_autosync_toggled(GtkToggleButton *togglebutton, gpointer us
     gboolean is_checked = gtk_toggle_button_get_active(togglebutton);
     if (is_checked) {
         sync_no = (BYTE)(rand() % 256);
-        g_print("Auto Sync Enabled Sync No: %X \n",sync_no);
+        FAS_LOG("Auto Sync Enabled Sync No: %X", sync_no);
     } else {
         sync_no = 0x00;
-        g_print("Auto Sync Disabled Sync No: %X \n",sync_no);
+        FAS_LOG("Auto Sync Disabled Sync No: %X", sync_no);
     }
 }
 
@@ -386,13 +564,21 @@ static void on_check_fastech_toggled(GtkToggleButton *togglebutton, gpointer use
     gboolean is_checked = gtk_toggle_button_get_active(togglebutton);
     if (is_checked) {
         header = 0xAA;
-        g_print("FASTECH Protocol header: %X \n",header);
+        FAS_LOG("FASTECH Protocol header: %X", header);
     } else {
         header = 0x00;
-        g_print("USER Protocol header: %X \n",header);
+        FAS_LOG("USER Protocol header: %X", header);
     }
 }
 
+ /**@brief Use List 체크박스의 callback, 켜져 있는 동안 Send 버튼은 목록에 추가만 함*/
+static void on_check_uselist_toggled(GtkToggleButton *togglebutton, gpointer user_data) {
+    GtkBuilder *builder = GTK_BUILDER(user_data);
+    GtkButton *button_send = GTK_BUTTON(gtk_builder_get_object(builder, "button_send"));
+    
+    gtk_button_set_label(button_send, gtk_toggle_button_get_active(togglebutton) ? "Add" : "Send");
+}
+
  /**@brief MoveVelocity에서 방향 선택 콤보박스의 callback*/
 static void on_combo_direction_changed(GtkComboBox *combo_id, gpointer user_data) {
     memset(&data, 0, sizeof(data));
@@ -412,104 +598,457 @@ static void on_combo_direction_changed(GtkComboBox *combo_id, gpointer user_data
     }
 
     if (selected_id != NULL) {
-        g_print("Selected Data: %s\n", selected_id);
+        FAS_LOG("Selected Data: %s", selected_id);
         char* endptr;
         unsigned long int value = strtoul(selected_id, &endptr, 16);
         if (*endptr == '\0' && value <= UINT8_MAX) {
             data[4] = (uint8_t)value;
         } else {
-            g_print("Invalid input: %s\n", selected_id);
+            FAS_LOG("Invalid input: %s", selected_id);
         }
     } else {
-        g_print("No item selected.\n");
+        FAS_LOG("No item selected.");
     }
     print_buffer(data, 5);
     
 }
 
+ /**@brief Calc.CRC 버튼의 callback, 현재 명령을 Plus-R(RS-485) 프레임으로 만들었을 때의 CRC를 보여줌*/
+static void on_button_calccrc_clicked(GtkButton *button, gpointer user_data) {
+    BYTE frame[SERIAL_FRAME_SIZE];
+    
+    if (!library_interface()) {
+        return;
+    }
+    // Plus-R CRC 범위: [Slave ID][frame type][data...]
+    const BYTE *buffer = send_frame->data;
+    BYTE body[BUFFER_SIZE];
+    int size = buffer[1] - 1;
+    body[0] = 0;
+    memcpy(&body[1], &buffer[4], size - 1);
+    uint16_t crc = FAS_CRC16(body, size);
+    int length = FAS_SerialEncode(0, buffer[4], &buffer[5], buffer[1] - 3, frame);
+    
+    char text[SERIAL_FRAME_SIZE * 3];
+    FAS_FrameFormat(frame, length, text, sizeof(text));
+    char *line = g_strdup_printf("\n[CRC16] %02X %02X (Lo Hi)\n[Plus-R] %s\n", crc & 0xFF, crc >> 8, text);
+    GtkTextIter iter;
+    gtk_text_buffer_get_end_iter(monitor2_buffer, &iter);
+    gtk_text_buffer_insert(monitor2_buffer, &iter, line, -1);
+    g_free(line);
+}
+
+ /**@brief monitor_thread가 받은 응답 프레임을 main loop에서 그래프와 파일에 넣고 놓음*/
+static gboolean on_monitor_sample(gpointer user_data) {
+    FAS_FRAME *reply = user_data;
+    plot_reply(reply->data, reply->size, reply->acquired_us);
+    FAS_FrameUnref(reply);
+    return G_SOURCE_REMOVE;
+}
 
-/************************************************************************************************************************************
- ********************************나중에 라이브러리로 뺄 FASTECH 라이브러리와 같은 기능의 함수*************************************************
- ************************************************************************************************************************************/
- 
- /**@brief UDP 연결 시 사용
-  * @param BYTE sb1,sb2,sb3,sb4 IPv4주소 입력 시 각 자리
-  * @param int iBdID 드라이브 ID
-  * @return boolean 성공시 TRUE 실패시 FALSE*/
-bool FAS_Connect(BYTE sb1, BYTE sb2, BYTE sb3, BYTE sb4, int iBdID){
-    char SERVER_IP[16]; //최대 길이 가정 "xxx.xxx.xxx.xxx\0" 
-    snprintf(SERVER_IP, sizeof(SERVER_IP), "%u.%u.%u.%u", sb1, sb2, sb3, sb4);
+ /**@brief 요청 하나의 응답을 pool 프레임에 받아 main loop에 넘김 (복사 없이 참조만 넘김)
+  * @return 받은 응답 프레임 (참조 1, 다 쓰면 FAS_FrameUnref), 실패나 timeout 또는 pool이 비었으면 NULL*/
+static FAS_FRAME *monitor_request(BYTE type) {
+    FAS_FRAME *reply = FAS_FrameAlloc();
+    if (reply == NULL) {
+        return NULL;
+    }
+    reply->size = request_frame(type, reply->data, sizeof(reply->data), &reply->acquired_us);
+    if (reply->size <= 0) {
+        FAS_FrameUnref(reply);
+        return NULL;
+    }
+    g_idle_add(on_monitor_sample, FAS_FrameRef(reply));
+    return reply;
+}
+
+ /**@brief Status Monitor의 요청 스레드, 응답을 기다리는 동안 화면이 멈추지 않도록 main loop 밖에서 보냄
+  * @details 요청 주기는 monitor_poller가 축 상태로 정한다. 매크로/목록 전송이나 보드 정보 재확인이 board_lock을 잡고 있으면
+  * 응답이 섞이지 않도록 이번 차례는 보내지 않는다. GTK 함수는 부르지 않음*/
+static gpointer monitor_thread_func(gpointer user_data) {
+    while (!monitor_stop) {
+        int board;
+        bool sent = false;
+        int64_t wait = MONITOR_POLL_MS * 1000;
+        if (g_mutex_trylock(&board_lock)) {
+            if (connected && FAS_PollDue(&monitor_poller, g_get_monotonic_time(), &board, 1, &wait) == 1) {
+                FAS_FrameUnref(monitor_request(0x06));
+                FAS_FRAME *reply = monitor_request(0x40);
+                bool ok = reply != NULL && reply->size >= 10 && reply->data[5] == FMM_OK;
+                FAS_PollUpdate(&monitor_poller, 0, g_get_monotonic_time(), ok,
+                               ok ? reply->data[6] | (DWORD)reply->data[7] << 8 | (DWORD)reply->data[8] << 16 | (DWORD)reply->data[9] << 24 : 0);
+                FAS_FrameUnref(reply);
+                sent = true;
+            }
+            g_mutex_unlock(&board_lock);
+        }
+        if (!sent) { //다음 요청 시각까지 자되 1ms ~ MONITOR_POLL_MS 사이로 맞춤 (창을 닫으면 바로 끝나도록)
+            g_usleep(CLAMP(wait, 1000, MONITOR_POLL_MS * 1000));
+        }
+    }
+    return NULL;
+}
+
+ /**@brief 새로 받은 축 상태를 상태 캡처의 드라이브가 읽은 시각 자리에 씀
+  * @details 캡처 파일은 MONITOR_POLL_MS 간격 tick이지만 상태는 응답이 올 때만 알 수 있으므로, 직전 응답 이후의 tick은
+  * 직전 응답의 값(그동안 실제로 알던 값)으로 채우고 이번 값은 acquired_us에 가장 가까운 tick에 쓴다.
+  * 유지시간은 실제 시각을 따르고, 요청 간격보다 짧게 켜졌다 꺼진 변화는 캡처에도 없다.
+  * 직전 tick과 같은 자리에 떨어진 응답은 쓰지 않음*/
+static void capture_status(DWORD status, gint64 acquired_us) {
+    const gint64 period = MONITOR_POLL_MS * 1000;
+    
+    if (status_capture == NULL) {
+        return;
+    }
+    if (capture_time != 0) {
+        gint64 ticks = (acquired_us - capture_time + period / 2) / period;
+        if (ticks <= 0) {
+            return;
+        }
+        for (gint64 i = 1; i < ticks; i++) {
+            StatusCapture_Write(status_capture, &capture_last, 1);
+        }
+        capture_time += ticks * period;
+    }
+    else {
+        capture_time = acquired_us;
+    }
+    StatusCapture_Write(status_capture, &status, 1);
+    capture_last = status;
+}
+
+ /**@brief Status Monitor 창을 닫을 때 주기 요청도 멈춤*/
+static void on_monitor_destroy(GtkWidget *widget, gpointer user_data) {
+    monitor_stop = true;
+    g_thread_join(monitor_thread);
+    monitor_thread = NULL;
+    monitor_window = NULL;
+    if (status_capture != NULL) {
+        fclose(status_capture);
+        status_capture = NULL;
+    }
+    EncoderStore_Close(encoder_store);
+    encoder_store = NULL;
+}
+
+ /**@brief Status Monitor 버튼의 callback, 위치/속도/상태 그래프 창을 띄움*/
+static void on_button_statusmonitor_clicked(GtkButton *button, gpointer user_data) {
+    if (monitor_window != NULL) {
+        gtk_window_present(GTK_WINDOW(monitor_window));
+        return;
+    }
+    monitor_window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    gtk_window_set_title(GTK_WINDOW(monitor_window), "Status Monitor");
+    gtk_container_add(GTK_CONTAINER(monitor_window), MotionPlot_New());
+    g_signal_connect(monitor_window, "destroy", G_CALLBACK(on_monitor_destroy), NULL);
+    
+    // 축 상태는 Analyze Flag 버튼으로 나중에 분석할 수 있도록 파일로도 남김
+    GDateTime *now = g_date_time_new_now_local();
+    char *path = g_date_time_format(now, "status_%Y%m%d_%H%M%S.fsc");
+    status_capture = StatusCapture_Open(path, MONITOR_POLL_MS * 1000, 1);
+    g_print("status capture: %s\n", path);
+    g_free(path);
+    // 엔코더 값은 축별, 날짜별 파일에 이어서 쌓음
+    path = g_date_time_format(now, "encoder_ax0_%Y%m%d.fts");
+    encoder_store = EncoderStore_Open(path, ENCODER_FLUSH_US);
+    encoder_epoch_us = g_get_real_time() - g_get_monotonic_time();
+    g_free(path);
+    g_date_time_unref(now);
     
-    // Create socket
-    if ((client_socket = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
-        perror("Socket creation failed\n");
-        exit(EXIT_FAILURE);
+    FAS_POLL_CONFIG poll_config = { MONITOR_POLL_MS, MONITOR_NORMAL_MS, MONITOR_SLOW_MS, MONITOR_BUDGET_FPS, 2 }; //엔코더 + 상태
+    FAS_PollInit(&monitor_poller, &poll_config);
+    FAS_PollAdd(&monitor_poller, 0);
+    capture_time = 0;
+    monitor_stop = false;
+    monitor_thread = g_thread_new("monitor", monitor_thread_func, NULL);
+    gtk_widget_show_all(monitor_window);
+}
+
+ /**@brief Analyze Flag 버튼의 callback, 저장된 상태 캡처 파일을 골라 플래그별 통계를 monitor2에 출력*/
+static void on_button_analyzeflag_clicked(GtkButton *button, gpointer user_data) {
+    GtkWidget *dialog = gtk_file_chooser_dialog_new("Open Status Capture", NULL, GTK_FILE_CHOOSER_ACTION_OPEN,
+                                                    "_Cancel", GTK_RESPONSE_CANCEL, "_Open", GTK_RESPONSE_ACCEPT, NULL);
+    GtkFileFilter *filter = gtk_file_filter_new();
+    gtk_file_filter_set_name(filter, "Status Capture (*.fsc)");
+    gtk_file_filter_add_pattern(filter, "*.fsc");
+    gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog), filter);
+    
+    if (gtk_dialog_run(GTK_DIALOG(dialog)) != GTK_RESPONSE_ACCEPT) {
+        gtk_widget_destroy(dialog);
+        return;
+    }
+    char *path = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
+    gtk_widget_destroy(dialog);
+    
+    if (status_capture != NULL) {
+        fflush(status_capture); // 지금 기록 중인 파일을 고른 경우
+    }
+    STATUS_CAPTURE_HEADER capture;
+    STATUS_FLAG_STATS *stats = StatusAnalyze_File(path, STATUS_CHATTER_MS, &capture);
+    if (stats == NULL) {
+        g_print("Analyze failed: %s\n", path);
+        g_free(path);
+        return;
     }
-    else{
-        g_print("Socket created\n");
+    char *report = NULL;
+    size_t report_size = 0;
+    FILE *out = open_memstream(&report, &report_size);
+    fprintf(out, "\n[ANALYZE] %s\n", path);
+    for (DWORD axis = 0; axis < capture.axes; axis++) {
+        StatusAnalyze_Report(out, &stats[axis], axis, capture.period_us);
     }
+    fclose(out);
+    
+    GtkTextIter iter;
+    gtk_text_buffer_get_end_iter(monitor2_buffer, &iter);
+    gtk_text_buffer_insert(monitor2_buffer, &iter, report, -1);
+    free(report);
+    free(stats);
+    g_free(path);
+}
+
+
 
-    memset(&server_addr, 0, sizeof(server_addr));
+ /**@brief 기록 버튼의 callback, 지금 선택된 명령의 프레임을 해당 칸의 매크로 끝에 추가
+  * @details 칸의 글자를 모두 지운 뒤 누르면 처음부터 새로 기록함*/
+static void on_button_record_clicked(GtkButton *button, gpointer user_data) {
+    int slot = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(button), "slot"));
+    GtkTextIter start, end;
     
-    // Configure server address
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(PORT);
-    if (inet_pton(AF_INET, SERVER_IP, &server_addr.sin_addr) <= 0) {
-        perror("Invalid address/ Address not supported\n");
-        exit(EXIT_FAILURE);
+    if (macro_thread != NULL) {
+        g_print("Macro is running\n");
+        return;
     }
-    else{
-        g_print("Valid address\n");
+    gtk_text_buffer_get_bounds(record_buffer[slot], &start, &end);
+    char *text = gtk_text_buffer_get_text(record_buffer[slot], &start, &end, FALSE);
+    if (text[0] == '\0') {
+        FAS_MacroClear(&macros[slot]);
     }
-    return 0;
+    g_free(text);
+    
+    if (!library_interface()) {
+        return;
+    }
+    if (!FAS_MacroRecord(&macros[slot], send_frame->data, send_frame->size)) {
+        g_print("Record failed (max %d frames)\n", FAS_MACRO_MAX_FRAMES);
+        return;
+    }
+    char *item = g_strdup_printf(macros[slot].count > 1 ? " %02X" : "%02X", send_frame->data[4]);
+    gtk_text_buffer_get_end_iter(record_buffer[slot], &end);
+    gtk_text_buffer_insert(record_buffer[slot], &end, item, -1);
+    g_free(item);
 }
 
- /**@brief TCP 연결 시 사용
-  * @param BYTE sb1,sb2,sb3,sb4 IPv4주소 입력 시 각 자리
-  * @param int iBdID 드라이브 ID
-  * @return boolean 성공시 TRUE 실패시 FALSE*/
-bool FAS_ConnectTCP(BYTE sb1, BYTE sb2, BYTE sb3, BYTE sb4, int iBdID){
-    char SERVER_IP[16]; //최대 길이 가정 "xxx.xxx.xxx.xxx\0" 
-    snprintf(SERVER_IP, sizeof(SERVER_IP), "%u.%u.%u.%u", sb1, sb2, sb3, sb4);
+ /**@brief 매크로 전송이 끝났을 때 main loop에서 실행, 결과를 monitor2에 출력하고 버튼을 되돌림*/
+static gboolean on_macro_done(gpointer user_data) {
+    GtkBuilder *builder = GTK_BUILDER(user_data);
+    char id[32];
     
-    // Create socket
-    if ((client_socket = socket(AF_INET, SOCK_STREAM, 0)) == -1) {
-        perror("Socket creation failed");
-        exit(EXIT_FAILURE);
+    g_thread_join(macro_thread);
+    macro_thread = NULL;
+    
+    snprintf(id, sizeof(id), "button_transfer%d", macro_slot + 1);
+    gtk_button_set_label(GTK_BUTTON(gtk_builder_get_object(builder, id)), "전송");
+    gtk_widget_set_sensitive(GTK_WIDGET(gtk_builder_get_object(builder, "button_connect")), FAS_InventoryWait(0)); //재확인 중이면 on_inventory_poll이 켬
+    gtk_widget_set_sensitive(GTK_WIDGET(gtk_builder_get_object(builder, "button_send")), connected);
+    
+    FAS_MACRO_RESULT *r = &macro_result;
+    uint64_t replied = r->sent - r->timeout;
+    double seconds = r->elapsed_us / 1e6;
+    char *line = g_strdup_printf("\n[MACRO %d] sent %" PRIu64 ", ok %" PRIu64 ", timeout %" PRIu64 ", error %" PRIu64
+                                 "\n%.3f s, %.1f frames/s, RTT avg %.0f us, max %" PRId64 " us\n",
+                                 macro_slot + 1, r->sent, r->ok, r->timeout, r->failed,
+                                 seconds, seconds > 0 ? r->sent / seconds : 0.0,
+                                 replied > 0 ? (double)r->rtt_total_us / replied : 0.0, r->rtt_max_us);
+    GtkTextIter iter;
+    gtk_text_buffer_get_end_iter(monitor2_buffer, &iter);
+    gtk_text_buffer_insert(monitor2_buffer, &iter, line, -1);
+    g_free(line);
+    return G_SOURCE_REMOVE;
+}
+
+ /**@brief 매크로 전송 스레드, GTK 함수는 부르지 않고 끝나면 on_macro_done을 main loop에 넘김*/
+static gpointer macro_thread_func(gpointer user_data) {
+    g_mutex_lock(&board_lock);
+    FAS_MacroRun(0, &macros[macro_slot], macro_loops, macro_rate, &macro_stop, &macro_result);
+    g_mutex_unlock(&board_lock);
+    g_idle_add(on_macro_done, user_data);
+    return NULL;
+}
+
+ /**@brief 전송 버튼의 callback, 칸에 기록된 매크로를 반복/Hz 칸의 값대로 보냄, 전송 중에 누르면 중단
+  * @details Hz가 0이면 응답을 받는 대로 바로 다음 프레임을 보냄*/
+static void on_button_transfer_clicked(GtkButton *button, gpointer user_data) {
+    GtkBuilder *builder = GTK_BUILDER(user_data);
+    int slot = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(button), "slot"));
+    
+    if (macro_thread != NULL) {
+        macro_stop = true;
+        return;
+    }
+    if (list_thread != NULL) {
+        g_print("List is running\n");
+        return;
+    }
+    if (!connected) {
+        g_print("Not connected\n");
+        return;
     }
-    else{
-        g_print("Socket created\n");
+    if (macros[slot].count == 0) {
+        g_print("Record %d is empty\n", slot + 1);
+        return;
     }
+    GtkEntry *entry_loop = GTK_ENTRY(gtk_builder_get_object(builder, "entry_macroloop"));
+    GtkEntry *entry_rate = GTK_ENTRY(gtk_builder_get_object(builder, "entry_macrorate"));
+    macro_loops = atoi(gtk_entry_get_text(entry_loop));
+    macro_rate = atoi(gtk_entry_get_text(entry_rate));
+    if (macro_loops < 1) {
+        macro_loops = 1;
+    }
+    if (macro_rate < 0) {
+        macro_rate = 0;
+    }
+    macro_slot = slot;
+    macro_stop = false;
+    
+    // 전송 중에는 같은 보드로 다른 요청을 보내지 않도록 막음
+    gtk_button_set_label(button, "중단");
+    gtk_widget_set_sensitive(GTK_WIDGET(gtk_builder_get_object(builder, "button_connect")), FALSE);
+    gtk_widget_set_sensitive(GTK_WIDGET(gtk_builder_get_object(builder, "button_send")), FALSE);
+    macro_thread = g_thread_new("macro", macro_thread_func, builder);
+}
 
-    // Prepare the sockaddr_in structure
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = inet_addr(SERVER_IP);
-    server_addr.sin_port = htons(PORT);
+ /**@brief 지금 만든 프레임을 List 탭의 목록 끝에 추가*/
+static void add_list_item(void) {
+    if (list_thread != NULL) {
+        g_print("List is running\n");
+        return;
+    }
+    if (!FAS_MacroRecord(&send_list, send_frame->data, send_frame->size)) {
+        g_print("Add failed (max %d frames)\n", FAS_MACRO_MAX_FRAMES);
+        return;
+    }
+    char *item = g_strdup_printf("%2d %-20s %s\n", send_list.count, command_interface(), FAS_FrameText(send_frame));
+    GtkTextIter end;
+    gtk_text_buffer_get_end_iter(list_buffer, &end);
+    gtk_text_buffer_insert(list_buffer, &end, item, -1);
+    g_free(item);
+}
+
+ /**@brief 목록 실행 결과를 label_liststat에 한 번 그림, 실행 중에는 list_timer가 LIST_STAT_MS마다 부름*/
+static gboolean on_list_stat(gpointer user_data) {
+    GtkBuilder *builder = GTK_BUILDER(user_data);
+    FAS_MACRO_RESULT r;
+    
+    FAS_MacroSnapshot(&list_result, &r);
+    uint64_t total = (uint64_t)list_loops * send_list.count;
+    double seconds = r.elapsed_us / 1e6;
+    char *text = g_strdup_printf("%" PRIu64 "/%" PRIu64 " sent, %.1f frames/s, timeout %" PRIu64 ", error %" PRIu64
+                                 "\nRTT p50 %u us, p99 %u us, max %" PRId64 " us",
+                                 r.sent, total, seconds > 0 ? r.sent / seconds : 0.0, r.timeout, r.failed,
+                                 LatencyHist_Percentile(&r.rtt, 50), LatencyHist_Percentile(&r.rtt, 99), r.rtt_max_us);
+    gtk_label_set_text(GTK_LABEL(gtk_builder_get_object(builder, "label_liststat")), text);
+    g_free(text);
+    return G_SOURCE_CONTINUE;
+}
 
-    // Connect to server
-    if (connect(client_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        perror("Connection failed");
-        exit(EXIT_FAILURE);
+ /**@brief 목록 실행이 끝났을 때 main loop에서 실행, 마지막 통계를 그리고 결과를 monitor2에 출력*/
+static gboolean on_list_done(gpointer user_data) {
+    GtkBuilder *builder = GTK_BUILDER(user_data);
+    
+    g_thread_join(list_thread);
+    list_thread = NULL;
+    g_source_remove(list_timer);
+    list_timer = 0;
+    on_list_stat(builder);
+    
+    gtk_button_set_label(GTK_BUTTON(gtk_builder_get_object(builder, "button_listrun")), "실행");
+    gtk_widget_set_sensitive(GTK_WIDGET(gtk_builder_get_object(builder, "button_connect")), FAS_InventoryWait(0)); //재확인 중이면 on_inventory_poll이 켬
+    gtk_widget_set_sensitive(GTK_WIDGET(gtk_builder_get_object(builder, "button_send")), connected);
+    
+    FAS_MACRO_RESULT *r = &list_result;
+    double seconds = r->elapsed_us / 1e6;
+    char *line = g_strdup_printf("\n[LIST] %d frames x %d, sent %" PRIu64 ", ok %" PRIu64 ", timeout %" PRIu64 ", error %" PRIu64
+                                 "\n%.3f s, %.1f frames/s, RTT p50 %u us, p90 %u us, p99 %u us, max %" PRId64 " us\n",
+                                 send_list.count, list_loops, r->sent, r->ok, r->timeout, r->failed,
+                                 seconds, seconds > 0 ? r->sent / seconds : 0.0, LatencyHist_Percentile(&r->rtt, 50),
+                                 LatencyHist_Percentile(&r->rtt, 90), LatencyHist_Percentile(&r->rtt, 99), r->rtt_max_us);
+    GtkTextIter iter;
+    gtk_text_buffer_get_end_iter(monitor2_buffer, &iter);
+    gtk_text_buffer_insert(monitor2_buffer, &iter, line, -1);
+    g_free(line);
+    return G_SOURCE_REMOVE;
+}
+
+ /**@brief 목록 실행 스레드, GTK 함수는 부르지 않고 끝나면 on_list_done을 main loop에 넘김*/
+static gpointer list_thread_func(gpointer user_data) {
+    g_mutex_lock(&board_lock);
+    FAS_MacroRun(0, &send_list, list_loops, list_rate, &list_stop, &list_result);
+    g_mutex_unlock(&board_lock);
+    g_idle_add(on_list_done, user_data);
+    return NULL;
+}
+
+ /**@brief List 탭 실행 버튼의 callback, 목록을 반복/Hz 칸의 값대로 보내고 실행 중에 누르면 중단
+  * @details Hz는 초당 프레임 수이며 0이면 응답을 받는 대로 바로 다음 프레임을 보냄 (최대 속도)*/
+static void on_button_listrun_clicked(GtkButton *button, gpointer user_data) {
+    GtkBuilder *builder = GTK_BUILDER(user_data);
+    
+    if (list_thread != NULL) {
+        list_stop = true;
+        return;
     }
-    else{
-        g_print("Connection Success\n");
+    if (macro_thread != NULL) {
+        g_print("Macro is running\n");
+        return;
     }
-    return 0;
+    if (!connected) {
+        g_print("Not connected\n");
+        return;
+    }
+    if (send_list.count == 0) {
+        g_print("List is empty, check Use List and press Add\n");
+        return;
+    }
+    list_loops = atoi(gtk_entry_get_text(GTK_ENTRY(gtk_builder_get_object(builder, "entry_listloop"))));
+    list_rate = atoi(gtk_entry_get_text(GTK_ENTRY(gtk_builder_get_object(builder, "entry_listrate"))));
+    if (list_loops < 1) {
+        list_loops = 1;
+    }
+    if (list_rate < 0) {
+        list_rate = 0;
+    }
+    list_stop = false;
+    
+    // 실행 중에는 같은 보드로 다른 요청을 보내지 않도록 막음
+    gtk_button_set_label(button, "중단");
+    gtk_widget_set_sensitive(GTK_WIDGET(gtk_builder_get_object(builder, "button_connect")), FALSE);
+    gtk_widget_set_sensitive(GTK_WIDGET(gtk_builder_get_object(builder, "button_send")), FALSE);
+    list_thread = g_thread_new("list", list_thread_func, builder);
+    list_timer = g_timeout_add(LIST_STAT_MS, on_list_stat, builder);
 }
 
- /**@brief 연결 해제 시 사용
-  * @param int iBdID 드라이브 ID */
-void FAS_Close(int iBdID){
-    close(client_socket);
+ /**@brief List 탭 지우기 버튼의 callback*/
+static void on_button_listclear_clicked(GtkButton *button, gpointer user_data) {
+    if (list_thread != NULL) {
+        g_print("List is running\n");
+        return;
+    }
+    FAS_MacroClear(&send_list);
+    gtk_text_buffer_set_text(list_buffer, "", -1);
 }
 
+/************************************************************************************************************************************
+ ********************************나중에 라이브러리로 뺄 FASTECH 라이브러리와 같은 기능의 함수*************************************************
+ ************************************************************************************************************************************/
+ 
  /**@brief 해당보드의 정보
   * @param int iBdID 드라이브 ID
   * @param BYTE pType 모터의 Type
   * @param LPSTR LpBuff Motor정보를 받을 문자열
   * @param int nBuffSize 버퍼의 사이즈 */
 int FAS_GetboardInfo(int iBdID, BYTE pType, LPSTR LpBuff, int nBuffSize){
-    buffer[0] = header; buffer[1] = 0x03; buffer[2] = sync_no; buffer[3] = 0x00; buffer[4] = frame_type;
+    send_frame->data[0] = header; send_frame->data[1] = 0x03; send_frame->data[2] = sync_no; send_frame->data[3] = 0x00; send_frame->data[4] = frame_type;
     return 0;
 }
 
@@ -519,7 +1058,7 @@ int FAS_GetboardInfo(int iBdID, BYTE pType, LPSTR LpBuff, int nBuffSize){
   * @param LPSTR LpBuff Motor정보를 받을 문자열
   * @param int nBuffSize 버퍼의 사이즈 */
 int FAS_GetMotorInfo(int iBdID, BYTE pType, LPSTR LpBuff, int nBuffSize){
-    buffer[0] = header; buffer[1] = 0x03; buffer[2] = sync_no; buffer[3] = 0x00; buffer[4] = frame_type;
+    send_frame->data[0] = header; send_frame->data[1] = 0x03; send_frame->data[2] = sync_no; send_frame->data[3] = 0x00; send_frame->data[4] = frame_type;
     return 0;
 }
 
@@ -529,7 +1068,7 @@ int FAS_GetMotorInfo(int iBdID, BYTE pType, LPSTR LpBuff, int nBuffSize){
   * @param LPSTR LpBuff Motor정보를 받을 문자열
   * @param int nBuffSize 버퍼의 사이즈 */
 int FAS_GetEncoder(int iBdID, BYTE pType, LPSTR LpBuff, int nBuffSize){
-    buffer[0] = header; buffer[1] = 0x03; buffer[2] = sync_no; buffer[3] = 0x00; buffer[4] = frame_type;
+    send_frame->data[0] = header; send_frame->data[1] = 0x03; send_frame->data[2] = sync_no; send_frame->data[3] = 0x00; send_frame->data[4] = frame_type;
     return 0;
 }
 
@@ -539,7 +1078,7 @@ int FAS_GetEncoder(int iBdID, BYTE pType, LPSTR LpBuff, int nBuffSize){
   * @param LPSTR LpBuff Motor정보를 받을 문자열
   * @param int nBuffSize 버퍼의 사이즈 */
 int FAS_GetFirmwareInfo(int iBdID, BYTE pType, LPSTR LpBuff, int nBuffSize){
-    buffer[0] = header; buffer[1] = 0x03; buffer[2] = sync_no; buffer[3] = 0x00; buffer[4] = frame_type;
+    send_frame->data[0] = header; send_frame->data[1] = 0x03; send_frame->data[2] = sync_no; send_frame->data[3] = 0x00; send_frame->data[4] = frame_type;
     return 0;
 }
 
@@ -549,14 +1088,14 @@ int FAS_GetFirmwareInfo(int iBdID, BYTE pType, LPSTR LpBuff, int nBuffSize){
   * @param LPSTR LpBuff Motor정보를 받을 문자열
   * @param int nBuffSize 버퍼의 사이즈 */
 int FAS_GetSlaveInfoEx(int iBdID, BYTE pType, LPSTR LpBuff, int nBuffSize){
-    buffer[0] = header; buffer[1] = 0x03; buffer[2] = sync_no; buffer[3] = 0x00; buffer[4] = frame_type;
+    send_frame->data[0] = header; send_frame->data[1] = 0x03; send_frame->data[2] = sync_no; send_frame->data[3] = 0x00; send_frame->data[4] = frame_type;
     return 0;
 }
 
  /**@brief 현재까지 수정된 파라미터 값고 입출력 신호를 ROM영역에 저장
   * @param int iBdID 드라이브 ID*/
 int FAS_SaveAllParameters(int iBdID){
-    buffer[0] = header; buffer[1] = 0x03; buffer[2] = sync_no; buffer[3] = 0x00; buffer[4] = frame_type;
+    send_frame->data[0] = header; send_frame->data[1] = 0x03; send_frame->data[2] = sync_no; send_frame->data[3] = 0x00; send_frame->data[4] = frame_type;
     return 0;
 }
 
@@ -564,7 +1103,7 @@ int FAS_SaveAllParameters(int iBdID){
   * @param int iBdID 드라이브 ID
   * @return 명령이 수행된 정보*/
 int FAS_EmergencyStop(int iBdID){
-    buffer[0] = header; buffer[1] = 0x03; buffer[2] = sync_no; buffer[3] = 0x00; buffer[4] = frame_type;
+    send_frame->data[0] = header; send_frame->data[1] = 0x03; send_frame->data[2] = sync_no; send_frame->data[3] = 0x00; send_frame->data[4] = frame_type;
     return 0;
 }
 
@@ -573,21 +1112,21 @@ int FAS_EmergencyStop(int iBdID){
   * @param bool bOnOff Enable/Disable
   * @return 명령이 수행된 정보*/
 int FAS_ServoEnable(int iBdID, bool bOnOff){
-    buffer[0] = header; buffer[1] = 0x04; buffer[2] = sync_no; buffer[3] = 0x00; buffer[4] = frame_type; buffer[5] = data[0];
+    send_frame->data[0] = header; send_frame->data[1] = 0x04; send_frame->data[2] = sync_no; send_frame->data[3] = 0x00; send_frame->data[4] = frame_type; send_frame->data[5] = data[0];
     return 0;
 }
 
  /**@brief Alarm Reset명령 보냄
   * @param int iBdID 드라이브 ID*/
 int FAS_ServoAlarmReset(int iBdID){
-    buffer[0] = header; buffer[1] = 0x03; buffer[2] = sync_no; buffer[3] = 0x00; buffer[4] = frame_type;
+    send_frame->data[0] = header; send_frame->data[1] = 0x03; send_frame->data[2] = sync_no; send_frame->data[3] = 0x00; send_frame->data[4] = frame_type;
     return 0;
 }
 
  /**@brief Alarm 정보 요청
   * @param int iBdID 드라이브 ID*/
 int FAS_GetAlarmType(int iBdID){
-    buffer[0] = header; buffer[1] = 0x03; buffer[2] = sync_no; buffer[3] = 0x00; buffer[4] = frame_type;
+    send_frame->data[0] = header; send_frame->data[1] = 0x03; send_frame->data[2] = sync_no; send_frame->data[3] = 0x00; send_frame->data[4] = frame_type;
     return 0;
 }
 
@@ -595,7 +1134,7 @@ int FAS_GetAlarmType(int iBdID){
   * @param int iBdID 드라이브 ID
   * @return 명령이 수행된 정보*/
 int FAS_MoveStop(int iBdID){
-    buffer[0] = header; buffer[1] = 0x03; buffer[2] = sync_no; buffer[3] = 0x00; buffer[4] = frame_type;
+    send_frame->data[0] = header; send_frame->data[1] = 0x03; send_frame->data[2] = sync_no; send_frame->data[3] = 0x00; send_frame->data[4] = frame_type;
     return 0;
 }
 
@@ -603,7 +1142,14 @@ int FAS_MoveStop(int iBdID){
   * @param int iBdID 드라이브 ID
   * @return 명령이 수행된 정보*/
 int FAS_MoveOriginSingleAxis(int iBdID){
-    buffer[0] = header; buffer[1] = 0x03; buffer[2] = sync_no; buffer[3] = 0x00; buffer[4] = frame_type;
+    send_frame->data[0] = header; send_frame->data[1] = 0x03; send_frame->data[2] = sync_no; send_frame->data[3] = 0x00; send_frame->data[4] = frame_type;
+    return 0;
+}
+
+/**@brief 축 상태(EZISERVO2_AXISSTATUS) 요청
+  * @param int iBdID 드라이브 ID*/
+int FAS_GetAxisStatus(int iBdID){
+    send_frame->data[0] = header; send_frame->data[1] = 0x03; send_frame->data[2] = sync_no; send_frame->data[3] = 0x00; send_frame->data[4] = frame_type;
     return 0;
 }
 
@@ -613,38 +1159,64 @@ int FAS_MoveOriginSingleAxis(int iBdID){
   * @param int iVelDir 이동할 방향 (0:-Jog, 1:+Jog)
   * @return 명령이 수행된 정보*/
 int FAS_MoveVelocity(int iBdID, DWORD lVelocity, int iVelDir) {
-    buffer[0] = header; buffer[1] = 0x08; buffer[2] = sync_no; buffer[3] = 0x00; buffer[4] = frame_type;
-    memcpy(&buffer[5], data, sizeof(data));
+    send_frame->data[0] = header; send_frame->data[1] = 0x08; send_frame->data[2] = sync_no; send_frame->data[3] = 0x00; send_frame->data[4] = frame_type;
+    memcpy(&send_frame->data[5], data, sizeof(data));
     return 0;
 }
 /************************************************************************************************************************************
  ******************************************************* 편의상 만든 함수 **************************************************************
  ************************************************************************************************************************************/
  
- /**@brief 명령전달에 쓰는 버퍼 내용을 터미널에 일단 보여주는 함수*/
+ /**@brief 명령전달에 쓰는 버퍼 내용을 터미널에 일단 보여주는 함수, 바이트만 로그에 복사하고 글자는 기록 스레드가 만듦*/
  void print_buffer(uint8_t *array, size_t size) {
-    for (size_t i = 0; i < size; i++) {
-        printf("%02X ", array[i]);
-    }
-    printf("\n");
+    FAS_LOG_BYTES("%s", array, (int)size);
 }
 
-/**@brief  배열을 문자열로 변환하는 함수*/
-char* array_to_string(const uint8_t *array, int size) {
-    char *str = g_strdup_printf("%02X", array[0]); // 첫 번째 요소는 따로 처리
-
-    char *temp;
-    for (int i = 1; i < size; i++) { // 첫 번째 요소 이후의 요소들 처리
-        temp = g_strdup_printf("%s %02X", str, array[i]);
-        g_free(str);
-        str = temp;
+/**@brief 응답 프레임이 엔코더 값이나 축 상태이면 Status Monitor 그래프와 파일에 넣는 함수, 받은 응답마다 한 번만 넣음
+  * @param gint64 acquired_us 드라이브가 값을 읽은 시각 (monotonic), 모르면 받은 시각*/
+void plot_reply(const BYTE *reply, ssize_t size, gint64 acquired_us){
+    if (monitor_window == NULL || size < 10 || reply[5] != FMM_OK) {
+        return;
     }
+    DWORD value = reply[6] | (DWORD)reply[7] << 8 | (DWORD)reply[8] << 16 | (DWORD)reply[9] << 24;
+    switch (reply[4])
+    {
+        case 0x06:
+            MotionPlot_PushEncoder(0, (int32_t)value, acquired_us);
+            if (encoder_store != NULL && !EncoderStore_Append(encoder_store, encoder_epoch_us + acquired_us, (int32_t)value)) {
+                FAS_LOG("encoder store append failed at %lld", (long long)(encoder_epoch_us + acquired_us));
+            }
+            break;
+        case 0x40:
+            MotionPlot_PushStatus(0, value);
+            capture_status(value, acquired_us);
+            break;
+    }
+}
 
-    return str;
+ /**@brief 모니터링용 요청 프레임을 보내고 응답을 기다리는 함수
+  * @details 라이브러리의 보드별 sync 번호를 쓰므로 Send 버튼의 sync_no와 섞이지 않고, 늦게 도착한 이전 응답은 버림.
+  * 응답이 RTO 안에 오지 않으면 라이브러리가 다시 보냄
+  * @param gint64 *acquired_us 드라이브가 값을 읽었을 것으로 추정한 시각 (monotonic)
+  * @return 받은 바이트 수, 실패나 timeout이면 -1*/
+int request_frame(BYTE type, BYTE *reply, int reply_size, gint64 *acquired_us){
+    FAS_REQUEST request = { .iBdID = 0, .frame_type = type, .reply = reply, .reply_size = reply_size };
+    
+    FAS_TransactBatch(&request, 1);
+    *acquired_us = request.acquired_us;
+    return request.reply_bytes > 0 ? request.reply_bytes : -1;
 }
 
- /**@brief 함수들을 찾아가게하는 인터페이스 용도 함수*/
-void library_interface(){
+ /**@brief 함수들을 찾아가게하는 인터페이스 용도 함수, 요청 프레임은 pool에서 새로 잡아 send_frame에 만듦
+  * @return pool이 비어 프레임을 만들지 못하면 FALSE*/
+bool library_interface(){
+    FAS_FrameUnref(send_frame); // 이전 프레임을 다른 곳에서 아직 쓰고 있으면 그쪽이 다 쓸 때 pool로 돌아감
+    send_frame = FAS_FrameAlloc();
+    if (send_frame == NULL) {
+        FAS_LOG("Frame pool exhausted");
+        return false;
+    }
+    memset(send_frame->data, 0, sizeof(send_frame->data)); // pool 칸은 이전 내용이 남아 있으므로 지원하지 않는 frame type이면 빈 프레임이 되도록 지움
     switch(frame_type)
     {
         case 0x01:
@@ -686,12 +1258,18 @@ void library_interface(){
          case 0x37:
             FAS_MoveVelocity(0, 1000, 0); // 예시로 lVelocity를 1000, iVelDir를 0으로 설정
             break;
+        case 0x40:
+            FAS_GetAxisStatus(0);
+            break;
     }
-    size_t data_size = buffer[1] + 2;
-    print_buffer(buffer, data_size);
+    send_frame->size = send_frame->data[1] + 2;
+    print_buffer(send_frame->data, send_frame->size);
     
-    char *text = array_to_string(buffer, buffer[1] + 2);
+    const char *text = FAS_FrameText(send_frame);
     gtk_text_buffer_set_text(sendbuffer_buffer, text, -1);
+    if (!gtk_toggle_button_get_active(check_showsend)) {
+        return true;
+    }
     gtk_text_buffer_set_text(monitor1_buffer, text, -1);
     
     char *command = command_interface();
@@ -703,6 +1281,7 @@ void library_interface(){
     gtk_text_buffer_insert(monitor2_buffer, &iter, command, -1);
     gtk_text_buffer_insert(monitor2_buffer, &iter, "\n", -1);
     gtk_text_buffer_insert(monitor2_buffer, &iter, "\n", -1);
+    return true;
 }
 
  /**@brief 각 명령어의 함수 이름을 찾아가는 인터페이스 용도 함수*/
@@ -735,6 +1314,8 @@ char *command_interface(){
             return "FAS_MoveOriginSingleAxis";
          case 0x37:
             return "FAS_MoveVelocity";
+        case 0x40:
+            return "FAS_GetAxisStatus";
         default:
             return "Transfer Fail";
     }
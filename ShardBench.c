@@ -0,0 +1,105 @@
+/**
+ * @file ShardBench.c
+ * @brief worker 수를 1, 2, 4 ...로 늘려 가며 FAS_ShardTransactBatch 처리량을 재는 도구
+ * @details 사용법: ShardBench -i ip [-i ip ...] [-b socket|uring] [-w 최대 worker 수] [-t 초] [-n 한 번에 보낼 요청 수]
+ * -i를 여러 번 주면 차례로 보드 ID 0, 1, 2...로 연결한다. 보드마다 축 상태(0x40)를 돌아가며 요청하고,
+ * worker 없이 호출 스레드에서 FAS_TransactBatch로 보낸 처리량을 기준(1.00x)으로 배수를 출력한다.
+ * 시험할 때는 DriveSim -u -a 127.0.0.X를 여러 개 띄워 두고 그 주소들로 연결한다.
+ * 빌드: gcc -O2 -pthread -o ShardBench ShardBench.c FAS_Shard.c FAS_Library.c FAS_Trace.c FAS_Ethernet.c FAS_Uring.c FAS_Serial.c FAS_Gateway.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "FAS_Shard.h"
+
+#define MAX_BATCH 1024
+
+ /**@brief seconds 동안 요청을 반복해 초당 성공 요청 수를 구함
+  * @param int workers 0이면 worker 없이 FAS_TransactBatch*/
+static double measure(int workers, int boards, int batch, double seconds, int *errors) {
+    static FAS_REQUEST requests[MAX_BATCH];
+    static BYTE replies[MAX_BATCH][BUFFER_SIZE];
+    uint64_t ok = 0, total = 0;
+
+    if (workers > 0 && !FAS_ShardStart(workers, true)) {
+        return 0;
+    }
+    int64_t start = FAS_NowUs();
+    int64_t end = start + (int64_t)(seconds * 1e6);
+    while (FAS_NowUs() < end) {
+        for (int i = 0; i < batch; i++) {
+            requests[i] = (FAS_REQUEST){ .iBdID = i % boards, .frame_type = 0x40, .reply = replies[i], .reply_size = BUFFER_SIZE };
+        }
+        ok += workers > 0 ? FAS_ShardTransactBatch(requests, batch) : FAS_TransactBatch(requests, batch);
+        total += batch;
+    }
+    double elapsed = (FAS_NowUs() - start) / 1e6;
+    if (workers > 0) {
+        FAS_ShardStop();
+    }
+    *errors = (int)(total - ok);
+    return ok / elapsed;
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    const char *ips[FAS_MAX_BOARD];
+    int ip_count = 0;
+    const char *backend = "socket";
+    int max_workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int batch = 64;
+    double seconds = 3;
+
+    while ((opt = getopt(argc, argv, "i:b:w:t:n:")) != -1) {
+        switch (opt)
+        {
+            case 'i':
+                if (ip_count < FAS_MAX_BOARD) {
+                    ips[ip_count++] = optarg;
+                }
+                break;
+            case 'b': backend = optarg; break;
+            case 'w': max_workers = atoi(optarg); break;
+            case 't': seconds = atof(optarg); break;
+            case 'n': batch = atoi(optarg); break;
+            default: break;
+        }
+    }
+    if (ip_count == 0 || batch <= 0 || batch > MAX_BATCH || seconds <= 0) {
+        fprintf(stderr, "usage: %s -i ip [-i ip ...] [-b socket|uring] [-w max_workers] [-t seconds] [-n batch(1~%d)]\n", argv[0], MAX_BATCH);
+        return 2;
+    }
+    if (max_workers < 1) {
+        max_workers = 1;
+    }
+    if (max_workers > FAS_SHARD_MAX_WORKERS) {
+        max_workers = FAS_SHARD_MAX_WORKERS;
+    }
+    if (strcmp(backend, "uring") == 0) {
+        FAS_SetEthernetBackend(FAS_BACKEND_URING);
+    }
+    for (int i = 0; i < ip_count; i++) {
+        unsigned sb[4];
+        if (sscanf(ips[i], "%u.%u.%u.%u", &sb[0], &sb[1], &sb[2], &sb[3]) != 4 || !FAS_Connect(sb[0], sb[1], sb[2], sb[3], i)) {
+            fprintf(stderr, "board %d: connect failed\n", i);
+            return 2;
+        }
+    }
+
+    int errors;
+    printf("%8s %12s %8s %8s\n", "WORKERS", "REQ/S", "SPEEDUP", "ERRORS");
+    double base = measure(0, ip_count, batch, seconds, &errors);
+    printf("%8s %12.0f %7.2fx %8d\n", "-", base, 1.0, errors);
+    for (int workers = 1; workers <= max_workers; workers *= 2) {
+        double rate = measure(workers, ip_count, batch, seconds, &errors);
+        printf("%8d %12.0f %7.2fx %8d\n", workers, rate, base > 0 ? rate / base : 0, errors);
+        fflush(stdout);
+    }
+
+    for (int i = 0; i < ip_count; i++) {
+        FAS_Close(i);
+    }
+    return 0;
+}
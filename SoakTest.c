@@ -0,0 +1,252 @@
+/**
+ * @file SoakTest.c
+ * @brief 장시간 요청을 반복하며 메모리(RSS), 열린 fd 수, 응답시간 백분위수가 늘어나는지 확인하는 도구
+ * @details 사용법: SoakTest (-i 127.0.0.1 [-b socket|uring|sqpoll] | -d /dev/pts/X | -g gateway socket) [-t 초] [-r 초당 요청 수] [-w 구간(초)] [-m RSS 증가 한도(KB/h)] [-p p99 증가 한도(%)]
+ * DriveSim(-u 또는 -s 1)을 먼저 띄워 두고 그 주소로 연결한다. -g는 DriveGateway를 거쳐 보드 0과 통신한다.
+ * 구간마다 RSS, fd 수, p50/p99/p99.9를 한 줄씩 출력하고, 끝나면 첫 구간(워밍업)을 뺀 나머지로 최소제곱 기울기를 구해
+ * RSS나 p99가 한도 이상 계속 늘었거나 fd가 늘었으면 실패(종료코드 1)로 판정한다.
+ * 구간이 모자라 추세를 구하지 못하면 통과로 보지 않고 판정 불가(종료코드 2)로 끝낸다.
+ * 환경 변수 FAS_TRACE에 경로를 주면 마지막 요청들의 단계별 구간을 Chrome trace 형식으로 남긴다. (FAS_Trace.h)
+ * 빌드: gcc -O2 -pthread -o SoakTest SoakTest.c LatencyHist.c FAS_Library.c FAS_Trace.c FAS_Ethernet.c FAS_Uring.c FAS_Serial.c FAS_Gateway.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include "FAS_Library.h"
+#include "FAS_Trace.h"
+#include "LatencyHist.h"
+
+ /**@brief 반복해서 보낼 요청 하나*/
+typedef struct
+{
+    BYTE frame_type;
+    BYTE data[5];
+    int data_size;
+} SOAK_COMMAND;
+
+ /**@brief 구간 하나의 측정값*/
+typedef struct
+{
+    double t_hours;
+    long rss_kb;
+    int fds;
+    uint32_t p50, p99, p999, max;
+    uint64_t count, errors;
+} SOAK_SAMPLE;
+
+static const SOAK_COMMAND commands[] = {
+    { 0x40, { 0 }, 0 },                          //FAS_GetAxisStatus
+    { 0x06, { 0 }, 0 },                          //FAS_GetEncoder
+    { 0x2A, { 1 }, 1 },                          //FAS_ServoEnable ON
+    { 0x37, { 0xE8, 0x03, 0x00, 0x00, 1 }, 5 },  //FAS_MoveVelocity 1000pps
+    { 0x01, { 0 }, 0 },                          //FAS_GetboardInfo
+    { 0x31, { 0 }, 0 },                          //FAS_MoveStop
+    { 0x2E, { 0 }, 0 },                          //FAS_GetAlarmType
+};
+#define COMMAND_COUNT (int)(sizeof(commands) / sizeof(commands[0]))
+
+static long rss_kb(void) {
+    long size, pages = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+    if (fp == NULL) {
+        return -1;
+    }
+    if (fscanf(fp, "%ld %ld", &size, &pages) != 2) {
+        pages = -1;
+    }
+    fclose(fp);
+    return pages < 0 ? -1 : pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+ /**@brief 열린 fd 수, 세는 동안 연 디렉터리 fd는 뺌*/
+static int open_fds(void) {
+    DIR *dir = opendir("/proc/self/fd");
+    if (dir == NULL) {
+        return -1;
+    }
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') {
+            count++;
+        }
+    }
+    closedir(dir);
+    return count - 1;
+}
+
+ /**@brief 최소제곱 기울기 (단위: y / 시간)*/
+static double slope(const SOAK_SAMPLE *s, int n, double (*y)(const SOAK_SAMPLE *)) {
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (int i = 0; i < n; i++) {
+        double x = s[i].t_hours;
+        sx += x;
+        sy += y(&s[i]);
+        sxx += x * x;
+        sxy += x * y(&s[i]);
+    }
+    double d = n * sxx - sx * sx;
+    return d > 0 ? (n * sxy - sx * sy) / d : 0;
+}
+
+static double sample_rss(const SOAK_SAMPLE *s) { return s->rss_kb; }
+static double sample_p99(const SOAK_SAMPLE *s) { return s->p99; }
+
+static bool connect_target(const char *ip, const char *device, const char *gateway) {
+    if (gateway != NULL) {
+        return FAS_ConnectGateway(gateway, 0);
+    }
+    if (device != NULL) {
+        return FAS_ConnectSerial(device, 115200, 0);
+    }
+    unsigned sb[4];
+    if (ip == NULL || sscanf(ip, "%u.%u.%u.%u", &sb[0], &sb[1], &sb[2], &sb[3]) != 4) {
+        return false;
+    }
+    return FAS_Connect(sb[0], sb[1], sb[2], sb[3], 0);
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    const char *ip = NULL, *device = NULL, *gateway = NULL, *backend = "socket";
+    double duration_s = 3600, window_s = 60;
+    int rate = 1000;
+    double max_rss_kb_per_h = 256, max_p99_percent = 20;
+
+    while ((opt = getopt(argc, argv, "i:d:g:b:t:r:w:m:p:")) != -1) {
+        switch (opt)
+        {
+            case 'i': ip = optarg; break;
+            case 'd': device = optarg; break;
+            case 'g': gateway = optarg; break;
+            case 'b': backend = optarg; break;
+            case 't': duration_s = atof(optarg); break;
+            case 'r': rate = atoi(optarg); break;
+            case 'w': window_s = atof(optarg); break;
+            case 'm': max_rss_kb_per_h = atof(optarg); break;
+            case 'p': max_p99_percent = atof(optarg); break;
+            default: break;
+        }
+    }
+    if ((ip == NULL && device == NULL && gateway == NULL) || window_s <= 0 || duration_s < window_s) {
+        fprintf(stderr, "usage: %s (-i ip [-b socket|uring|sqpoll] | -d device | -g gateway) [-t seconds] [-r rate] [-w window_s] [-m rss_kb_per_h] [-p p99_percent]\n", argv[0]);
+        return 2;
+    }
+    if (strcmp(backend, "uring") == 0) {
+        FAS_SetEthernetBackend(FAS_BACKEND_URING);
+    }
+    else if (strcmp(backend, "sqpoll") == 0) {
+        FAS_SetEthernetBackend(FAS_BACKEND_URING_SQPOLL);
+    }
+    if (!connect_target(ip, device, gateway)) {
+        fprintf(stderr, "connect failed\n");
+        return 2;
+    }
+
+    FAS_TraceStart(getenv("FAS_TRACE"));
+
+    // 측정 중에는 할당하지 않도록 구간 배열을 미리 잡음
+    int max_windows = (int)(duration_s / window_s) + 1;
+    SOAK_SAMPLE *samples = calloc(max_windows, sizeof(SOAK_SAMPLE));
+    if (samples == NULL) {
+        return 2;
+    }
+    LATENCY_HIST hist;
+    BYTE reply[BUFFER_SIZE];
+    int windows = 0;
+
+    printf("%8s %10s %5s %8s %8s %8s %8s %10s %8s\n", "TIME(s)", "RSS(KB)", "FDS", "P50(us)", "P99(us)", "P99.9", "MAX", "REQUESTS", "ERRORS");
+    int64_t period = rate > 0 ? 1000000 / rate : 0;
+    int64_t start = FAS_NowUs();
+    int64_t end = start + (int64_t)(duration_s * 1e6);
+    int64_t next = start;
+    uint64_t sequence = 0;
+
+    while (windows < max_windows) {
+        int64_t window_end = start + (int64_t)((windows + 1) * window_s * 1e6);
+        SOAK_SAMPLE *s = &samples[windows];
+        LatencyHist_Reset(&hist);
+
+        while (FAS_NowUs() < window_end) {
+            if (period > 0) {
+                int64_t now = FAS_NowUs();
+                if (now < next) {
+                    usleep(next - now);
+                }
+                else if (now - next > period) {
+                    next = now;
+                }
+                next += period;
+            }
+            const SOAK_COMMAND *c = &commands[sequence++ % COMMAND_COUNT];
+            int64_t sent_at = FAS_NowUs();
+            int result = FAS_Transact(0, c->frame_type, c->data, c->data_size, reply, sizeof(reply));
+            LatencyHist_Add(&hist, (uint32_t)(FAS_NowUs() - sent_at));
+            if (result != FMM_OK) {
+                s->errors++;
+            }
+        }
+
+        s->t_hours = (FAS_NowUs() - start) / 3.6e9;
+        s->rss_kb = rss_kb();
+        s->fds = open_fds();
+        s->count = hist.count;
+        s->p50 = LatencyHist_Percentile(&hist, 50);
+        s->p99 = LatencyHist_Percentile(&hist, 99);
+        s->p999 = LatencyHist_Percentile(&hist, 99.9);
+        s->max = hist.max_us;
+        printf("%8.0f %10ld %5d %8u %8u %8u %8u %10llu %8llu\n", s->t_hours * 3600, s->rss_kb, s->fds,
+               s->p50, s->p99, s->p999, s->max, (unsigned long long)s->count, (unsigned long long)s->errors);
+        fflush(stdout);
+        windows++;
+        if (FAS_NowUs() >= end) {
+            break;
+        }
+    }
+    FAS_Close(0);
+    int traced = FAS_TraceStop();
+    if (traced >= 0) {
+        fprintf(stderr, "trace: %d events -> %s\n", traced, getenv("FAS_TRACE"));
+    }
+
+    // 첫 구간은 워밍업(캐시, 페이지 할당)이므로 추세에서 뺌
+    bool failed = false;
+    const SOAK_SAMPLE *steady = &samples[1];
+    int n = windows - 1;
+    if (n < 3) {
+        printf("too few windows for a trend (%d), use -t >= 4 * -w\n", n);
+        free(samples);
+        printf("SOAK INCONCLUSIVE\n");
+        return 2;
+    }
+    double hours = steady[n - 1].t_hours - steady[0].t_hours;
+    double rss_slope = slope(steady, n, sample_rss);
+    double p99_slope = slope(steady, n, sample_p99);
+    double p99_mean = 0;
+    for (int i = 0; i < n; i++) {
+        p99_mean += steady[i].p99;
+    }
+    p99_mean /= n;
+    double p99_growth = p99_mean > 0 ? 100.0 * p99_slope * hours / p99_mean : 0;
+
+    printf("RSS trend %+.1f KB/h (limit %.1f), p99 trend %+.1f us/h = %+.1f%% over run (limit %.1f%%), fds %d -> %d\n",
+           rss_slope, max_rss_kb_per_h, p99_slope, p99_growth, max_p99_percent, steady[0].fds, steady[n - 1].fds);
+    if (rss_slope > max_rss_kb_per_h) {
+        printf("FAIL: memory grows\n");
+        failed = true;
+    }
+    if (p99_growth > max_p99_percent) {
+        printf("FAIL: p99 latency grows\n");
+        failed = true;
+    }
+    if (steady[n - 1].fds > steady[0].fds) {
+        printf("FAIL: file descriptors leak\n");
+        failed = true;
+    }
+    free(samples);
+    printf("%s\n", failed ? "SOAK FAILED" : "SOAK PASSED");
+    return failed ? 1 : 0;
+}
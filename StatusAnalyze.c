@@ -0,0 +1,272 @@
+/**
+ * @file StatusAnalyze.c
+ * @brief 축 상태 캡처 파일의 플래그별 duty cycle, edge 수, 유지시간 히스토그램 계산
+ * @details 통계는 모두 edge에서만 갱신된다. 켜져 있던 시간은 꺼지는 edge에서 구간 길이를 더해 구하므로
+ * 상태가 바뀌지 않는 샘플은 "직전 샘플과 XOR한 값이 0인지"만 확인하면 된다.
+ * 32샘플 단위로 이 확인을 벡터 연산으로 한 번에 하고, 바뀐 블록만 XOR 결과를 32x32 비트 전치해서
+ * 플래그마다 "어느 샘플에서 바뀌었는지"를 32비트 워드 하나로 만든 뒤 ctz로 edge를 순회한다.
+ * 캡처 파일과 호스트 모두 little-endian이라고 가정한다.
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include "StatusAnalyze.h"
+
+#define READ_TICKS 65536 //한 번에 읽는 tick 수
+
+typedef uint32_t v8u32 __attribute__((vector_size(32)));
+
+const char *StatusFlagNames[STATUS_FLAG_COUNT] = {
+    "ERRORALL", "HWPOSILMT", "HWNEGALMT", "SWPOGILMT", "SWNEGALMT", "RESERVED0", "RESERVED1", "ERRPOSOVERFLOW",
+    "ERROVERCURRENT", "ERROVERSPEED", "ERRPOSTRACKING", "ERROVERLOAD", "ERROVERHEAT", "ERRBACKEMF", "ERRMOTORPOWER", "ERRINPOSITION",
+    "EMGSTOP", "SLOWSTOP", "ORIGINRETURNING", "INPOSITION", "SERVOON", "ALARMRESET", "PTSTOPPED", "ORIGINSENSOR",
+    "ZPULSE", "ORIGINRETOK", "MOTIONDIR", "MOTIONING", "MOTIONPAUSE", "MOTIONACCEL", "MOTIONDECEL", "MOTIONCONST",
+};
+
+/************************************************************************************************************************************
+ ******************************************************* 캡처 파일 저장 ***************************************************************
+ ************************************************************************************************************************************/
+
+ /**@brief 캡처 파일을 새로 만들고 헤더를 씀
+  * @param DWORD period_us 샘플 주기 (us)
+  * @param DWORD axes tick마다 저장할 축 수
+  * @return 실패 시 NULL*/
+FILE *StatusCapture_Open(const char *path, DWORD period_us, DWORD axes) {
+    STATUS_CAPTURE_HEADER header = { .period_us = period_us, .axes = axes };
+    memcpy(header.magic, STATUS_CAPTURE_MAGIC, 4);
+
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) {
+        perror("capture open failed");
+        return NULL;
+    }
+    if (fwrite(&header, sizeof(header), 1, fp) != 1) {
+        fclose(fp);
+        return NULL;
+    }
+    return fp;
+}
+
+ /**@brief tick 하나(축 수만큼의 상태값)를 덧붙임*/
+bool StatusCapture_Write(FILE *fp, const DWORD *tick, DWORD axes) {
+    return fwrite(tick, sizeof(DWORD), axes, fp) == axes;
+}
+
+/************************************************************************************************************************************
+ ******************************************************* 플래그 분석 ****************************************************************
+ ************************************************************************************************************************************/
+
+static int hist_bin(uint64_t run) {
+    int bin = 63 - __builtin_clzll(run | 1);
+    return bin < STATUS_HIST_BINS ? bin : STATUS_HIST_BINS - 1;
+}
+
+ /**@brief 플래그 f가 샘플 t에서 바뀜, 직전 구간을 히스토그램에 넣음*/
+static inline void flag_edge(STATUS_FLAG_STATS *st, int f, uint64_t t, DWORD now_on) {
+    uint64_t run = t - st->last_change[f];
+    if (now_on) {
+        st->rising[f]++;
+        st->dwell_off[f][hist_bin(run)]++;
+    }
+    else {
+        st->falling[f]++;
+        st->dwell_on[f][hist_bin(run)]++;
+        st->ones[f] += run;
+        if (run < st->chatter_samples) {
+            st->chatter[f]++;
+        }
+    }
+    st->last_change[f] = t;
+}
+
+ /**@brief 32x32 비트 전치 (Hacker's Delight), 전치 후 A[31-f]의 비트 31-k가 원래 A[k]의 비트 f*/
+static void transpose32(DWORD A[32]) {
+    DWORD m = 0x0000FFFF;
+    for (int j = 16; j != 0; j >>= 1, m ^= (m << j)) {
+        for (int k = 0; k < 32; k = ((k | j) + 1) & ~j) {
+            DWORD t = (A[k] ^ (A[k | j] >> j)) & m;
+            A[k] ^= t;
+            A[k | j] ^= (t << j);
+        }
+    }
+}
+
+ /**@brief 32샘플 안에서 한 번이라도 바뀐 비트 (벡터 연산)
+  * @param const DWORD *cur 샘플 k, before는 샘플 k-1을 가리킴*/
+static inline DWORD block_changes(const DWORD *cur, const DWORD *before) {
+    v8u32 acc = { 0 };
+    for (int k = 0; k < 32; k += 8) {
+        v8u32 a, b;
+        memcpy(&a, cur + k, sizeof(a));
+        memcpy(&b, before + k, sizeof(b));
+        acc |= a ^ b;
+    }
+    DWORD lanes[8];
+    memcpy(lanes, &acc, sizeof(lanes));
+    return lanes[0] | lanes[1] | lanes[2] | lanes[3] | lanes[4] | lanes[5] | lanes[6] | lanes[7];
+}
+
+ /**@brief 바뀐 블록의 edge를 플래그별로 처리*/
+static void block_edges(STATUS_FLAG_STATS *st, const DWORD *cur, const DWORD *before, DWORD changed, uint64_t base) {
+    DWORD d[32];
+    for (int k = 0; k < 32; k++) {
+        d[k] = cur[k] ^ before[k];
+    }
+    transpose32(d);
+
+    while (changed != 0) {
+        int f = __builtin_ctz(changed);
+        changed &= changed - 1;
+        DWORD e = d[31 - f];
+        while (e != 0) {
+            int k = 31 - __builtin_clz(e);
+            e &= ~(1u << k);
+            int sample = 31 - k;
+            flag_edge(st, f, base + sample, (cur[sample] >> f) & 1);
+        }
+    }
+}
+
+ /**@brief 통계 초기화
+  * @param uint64_t chatter_samples 이보다 짧게 켜진 구간을 chatter로 셈*/
+void StatusAnalyze_Init(STATUS_FLAG_STATS *st, uint64_t chatter_samples) {
+    memset(st, 0, sizeof(*st));
+    st->chatter_samples = chatter_samples;
+}
+
+ /**@brief 한 축의 연속된 상태 샘플을 넣음, 여러 번 나눠서 넣어도 결과는 같음*/
+void StatusAnalyze_Feed(STATUS_FLAG_STATS *st, const DWORD *samples, size_t count) {
+    size_t i = 0;
+
+    if (count == 0) {
+        return;
+    }
+    if (!st->started) {
+        st->prev = samples[0];
+        st->started = true;
+    }
+    if (count >= 32) { //첫 블록은 직전 샘플이 이전 호출에 있으므로 따로 이어 붙임
+        DWORD joined[33];
+        joined[0] = st->prev;
+        memcpy(&joined[1], samples, 32 * sizeof(DWORD));
+        DWORD changed = block_changes(&joined[1], joined);
+        if (changed != 0) {
+            block_edges(st, &joined[1], joined, changed, st->samples);
+        }
+        for (i = 32; i + 32 <= count; i += 32) {
+            changed = block_changes(&samples[i], &samples[i - 1]);
+            if (changed != 0) {
+                block_edges(st, &samples[i], &samples[i - 1], changed, st->samples + i);
+            }
+        }
+        st->prev = samples[i - 1];
+    }
+    for (; i < count; i++) {
+        DWORD changed = samples[i] ^ st->prev;
+        while (changed != 0) {
+            int f = __builtin_ctz(changed);
+            changed &= changed - 1;
+            flag_edge(st, f, st->samples + i, (samples[i] >> f) & 1);
+        }
+        st->prev = samples[i];
+    }
+    st->samples += count;
+}
+
+ /**@brief 마지막까지 켜져 있던 플래그의 시간을 duty에 더함, 분석 끝에 한 번 호출*/
+void StatusAnalyze_Finish(STATUS_FLAG_STATS *st) {
+    for (int f = 0; f < STATUS_FLAG_COUNT; f++) {
+        if ((st->prev >> f) & 1) {
+            st->ones[f] += st->samples - st->last_change[f];
+            st->last_change[f] = st->samples;
+        }
+    }
+}
+
+ /**@brief 캡처 파일 전체를 읽어 축마다 분석
+  * @param double chatter_ms 이보다 짧게 켜진 구간을 chatter로 셈, 파일 헤더의 period_us로 샘플 수로 바꿈
+  * @param STATUS_CAPTURE_HEADER *header 파일 헤더를 돌려받음
+  * @return 축 수만큼의 통계 배열 (free로 해제), 실패 시 NULL*/
+STATUS_FLAG_STATS *StatusAnalyze_File(const char *path, double chatter_ms, STATUS_CAPTURE_HEADER *header) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        perror("capture open failed");
+        return NULL;
+    }
+    if (fread(header, sizeof(*header), 1, fp) != 1 || memcmp(header->magic, STATUS_CAPTURE_MAGIC, 4) != 0 || header->axes == 0) {
+        fprintf(stderr, "%s: not a status capture file\n", path);
+        fclose(fp);
+        return NULL;
+    }
+
+    DWORD axes = header->axes;
+    uint64_t chatter_samples = header->period_us ? (uint64_t)(chatter_ms * 1000 / header->period_us) : 0;
+    STATUS_FLAG_STATS *stats = calloc(axes, sizeof(STATUS_FLAG_STATS));
+    DWORD *ticks = malloc((size_t)READ_TICKS * axes * sizeof(DWORD));
+    DWORD *column = axes > 1 ? malloc(READ_TICKS * sizeof(DWORD)) : NULL;
+    if (stats == NULL || ticks == NULL || (axes > 1 && column == NULL)) {
+        free(stats);
+        free(ticks);
+        free(column);
+        fclose(fp);
+        return NULL;
+    }
+    for (DWORD a = 0; a < axes; a++) {
+        StatusAnalyze_Init(&stats[a], chatter_samples);
+    }
+
+    size_t n;
+    while ((n = fread(ticks, (size_t)axes * sizeof(DWORD), READ_TICKS, fp)) > 0) {
+        if (axes == 1) {
+            StatusAnalyze_Feed(&stats[0], ticks, n);
+            continue;
+        }
+        for (DWORD a = 0; a < axes; a++) {
+            for (size_t t = 0; t < n; t++) {
+                column[t] = ticks[t * axes + a];
+            }
+            StatusAnalyze_Feed(&stats[a], column, n);
+        }
+    }
+    for (DWORD a = 0; a < axes; a++) {
+        StatusAnalyze_Finish(&stats[a]);
+    }
+    free(ticks);
+    free(column);
+    fclose(fp);
+    return stats;
+}
+
+ /**@brief 한 축의 분석 결과를 표로 출력, 한 번도 켜지지 않은 플래그는 생략*/
+void StatusAnalyze_Report(FILE *out, const STATUS_FLAG_STATS *st, int axis, DWORD period_us) {
+    double ms = period_us / 1000.0;
+
+    fprintf(out, "[Axis %d] %" PRIu64 " samples (%.3f s)\n", axis, st->samples, st->samples * ms / 1000.0);
+    fprintf(out, "%-16s %8s %9s %9s %8s\n", "FLAG", "DUTY%", "RISE", "FALL", "CHATTER");
+    for (int f = 0; f < STATUS_FLAG_COUNT; f++) {
+        if (st->ones[f] == 0 && st->rising[f] == 0 && st->falling[f] == 0) {
+            continue;
+        }
+        fprintf(out, "%-16s %8.3f %9" PRIu64 " %9" PRIu64 " %8" PRIu64 "\n", StatusFlagNames[f],
+                st->samples ? 100.0 * st->ones[f] / st->samples : 0.0, st->rising[f], st->falling[f], st->chatter[f]);
+
+        for (int on = 1; on >= 0; on--) {
+            const uint64_t *hist = on ? st->dwell_on[f] : st->dwell_off[f];
+            bool any = false;
+            for (int b = 0; b < STATUS_HIST_BINS; b++) {
+                if (hist[b] == 0) {
+                    continue;
+                }
+                if (!any) {
+                    fprintf(out, "    %s dwell(ms):", on ? "ON " : "OFF");
+                    any = true;
+                }
+                fprintf(out, " %.0f~%.0f:%" PRIu64, (double)(1ull << b) * ms, (double)((2ull << b) - 1) * ms, hist[b]);
+            }
+            if (any) {
+                fprintf(out, "\n");
+            }
+        }
+    }
+}
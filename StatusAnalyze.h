@@ -0,0 +1,53 @@
+#pragma once
+
+/**
+ * @file StatusAnalyze.h
+ * @brief 축 상태(EZISERVO2_AXISSTATUS) 캡처 파일 저장과 플래그별 분석
+ * @details 캡처 파일: [헤더 16바이트 "FSC1", 샘플 주기(us), 축 수, 예약][tick마다 축 수만큼의 DWORD 상태값...]
+ * 모든 값은 little-endian.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "MOTION_DEFINE.h"
+
+#define STATUS_CAPTURE_MAGIC "FSC1"
+#define STATUS_FLAG_COUNT 32
+#define STATUS_HIST_BINS 32 //구간 길이 히스토그램, bin k = 2^k ~ 2^(k+1)-1 샘플
+
+typedef struct
+{
+    char magic[4];
+    DWORD period_us;
+    DWORD axes;
+    DWORD reserved;
+} STATUS_CAPTURE_HEADER;
+
+ /**@brief 축 하나의 플래그별 누적 통계*/
+typedef struct
+{
+    uint64_t samples;
+    uint64_t ones[STATUS_FLAG_COUNT];     //켜져 있던 샘플 수 (Finish 이후 확정)
+    uint64_t rising[STATUS_FLAG_COUNT];
+    uint64_t falling[STATUS_FLAG_COUNT];
+    uint64_t chatter[STATUS_FLAG_COUNT];  //chatter_samples보다 짧게 켜졌다 꺼진 횟수
+    uint64_t dwell_on[STATUS_FLAG_COUNT][STATUS_HIST_BINS];
+    uint64_t dwell_off[STATUS_FLAG_COUNT][STATUS_HIST_BINS];
+    uint64_t chatter_samples;
+
+    DWORD prev;                                  //직전 샘플
+    uint64_t last_change[STATUS_FLAG_COUNT];     //마지막으로 바뀐 샘플 번호
+    bool started;
+} STATUS_FLAG_STATS;
+
+extern const char *StatusFlagNames[STATUS_FLAG_COUNT];
+
+FILE *StatusCapture_Open(const char *path, DWORD period_us, DWORD axes);
+bool StatusCapture_Write(FILE *fp, const DWORD *tick, DWORD axes);
+
+void StatusAnalyze_Init(STATUS_FLAG_STATS *st, uint64_t chatter_samples);
+void StatusAnalyze_Feed(STATUS_FLAG_STATS *st, const DWORD *samples, size_t count);
+void StatusAnalyze_Finish(STATUS_FLAG_STATS *st);
+STATUS_FLAG_STATS *StatusAnalyze_File(const char *path, double chatter_ms, STATUS_CAPTURE_HEADER *header);
+void StatusAnalyze_Report(FILE *out, const STATUS_FLAG_STATS *st, int axis, DWORD period_us);
@@ -0,0 +1,95 @@
+/**
+ * @file Track.c
+ * @brief 기준 엔코더를 따라 축의 속도를 계속 고치고, 종료할 때 축별 추종 오차와 지연을 출력하는 도구
+ * @details 사용법: Track (-i ip [-i ip ...] | -d /dev/ttyUSB0 [-n 축 수] [-B baud]) [-r Hz] [-t 초] [-s] "1 follow 0 ratio 0.5"
+ * -i를 여러 번 주면 차례로 보드 ID 0, 1, 2...로 연결하고, -d는 Slave ID 0 ~ n-1로 연결한다.
+ * -r은 제어 주기(기본 250Hz), -t는 실행 시간(기본 Ctrl+C까지), -s는 시작 전에 추종 축을 servo on 한다.
+ * 계획 형식은 FAS_TrackParse 참고.
+ * 빌드: gcc -O2 -pthread -o Track Track.c FAS_Track.c LatencyHist.c FAS_Library.c FAS_Trace.c FAS_Ethernet.c FAS_Uring.c FAS_Serial.c FAS_Gateway.c -lm
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "FAS_Track.h"
+
+static volatile bool stop;
+
+static void on_signal(int sig) {
+    stop = true;
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    const char *ips[FAS_MAX_BOARD];
+    int ip_count = 0;
+    const char *device = NULL;
+    int slaves = 1, baud = 115200;
+    int rate_hz = 250, seconds = 0;
+    bool servo_on = false;
+
+    while ((opt = getopt(argc, argv, "i:d:n:B:r:t:s")) != -1) {
+        switch (opt)
+        {
+            case 'i':
+                if (ip_count < FAS_MAX_BOARD) {
+                    ips[ip_count++] = optarg;
+                }
+                break;
+            case 'd': device = optarg; break;
+            case 'n': slaves = atoi(optarg); break;
+            case 'B': baud = atoi(optarg); break;
+            case 'r': rate_hz = atoi(optarg); break;
+            case 't': seconds = atoi(optarg); break;
+            case 's': servo_on = true; break;
+            default: break;
+        }
+    }
+    if ((ip_count == 0 && device == NULL) || optind + 1 != argc) {
+        fprintf(stderr, "usage: %s (-i ip [-i ip ...] | -d device [-n slaves] [-B baud]) [-r Hz] [-t seconds] [-s] \"1 follow 0 ratio 0.5 kp 4\"\n", argv[0]);
+        return 2;
+    }
+
+    FAS_TRACK_PLAN plan;
+    if (!FAS_TrackParse(&plan, argv[optind])) {
+        return 2;
+    }
+    int boards = device != NULL ? slaves : ip_count;
+    for (int i = 0; i < boards; i++) {
+        unsigned sb[4];
+        bool connected = false;
+        if (device != NULL) {
+            connected = FAS_ConnectSerial(device, baud, i);
+        }
+        else if (sscanf(ips[i], "%u.%u.%u.%u", &sb[0], &sb[1], &sb[2], &sb[3]) == 4) {
+            connected = FAS_Connect(sb[0], sb[1], sb[2], sb[3], i);
+        }
+        if (!connected) {
+            fprintf(stderr, "board %d: connect failed\n", i);
+            return 2;
+        }
+    }
+    if (servo_on) {
+        FAS_REQUEST requests[FAS_TRACK_MAX_AXES];
+        BYTE on = 1;
+        for (int a = 0; a < plan.count; a++) {
+            requests[a] = (FAS_REQUEST){ .iBdID = plan.axes[a].iBdID, .frame_type = 0x2A, .data = &on, .data_size = 1 };
+        }
+        FAS_TransactBatch(requests, plan.count);
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGALRM, on_signal);
+    if (seconds > 0) {
+        alarm(seconds);
+    }
+    static FAS_TRACK_REPORT report;
+    FAS_TrackRun(&plan, rate_hz, &stop, &report);
+    FAS_TrackPrint(stdout, &plan, &report);
+
+    for (int i = 0; i < boards; i++) {
+        FAS_Close(i);
+    }
+    return 0;
+}